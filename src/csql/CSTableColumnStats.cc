@@ -0,0 +1,397 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <math.h>
+#include <sys/stat.h>
+#include <stx/io/fileutil.h>
+#include <stx/random.h>
+#include <csql/CSTableColumnStats.h>
+
+using namespace stx;
+
+namespace csql {
+
+const size_t CSTableColumnStats::kRecordsPerBlock = 8192;
+const uint64_t CSTableColumnStatsCache::kSidecarVersion = 1;
+
+static bool isIntegral(const SValue& value) {
+  switch (value.getType()) {
+    case SQL_INTEGER:
+    case SQL_TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool isOrdered(const SValue& value) {
+  switch (value.getType()) {
+    case SQL_INTEGER:
+    case SQL_TIMESTAMP:
+    case SQL_FLOAT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Compares two values the same way the lt/gt expressions do, returns -1, 0 or
+ * 1
+ */
+static int compareValues(
+    sql_type type,
+    const SValue& left,
+    const SValue& right) {
+  if (type == SQL_STRING) {
+    auto l = left.getString();
+    auto r = right.getString();
+    return l < r ? -1 : (l > r ? 1 : 0);
+  }
+
+  if (isIntegral(left) && isIntegral(right)) {
+    auto l = left.getInteger();
+    auto r = right.getInteger();
+    return l < r ? -1 : (l > r ? 1 : 0);
+  }
+
+  auto l = left.getFloat();
+  auto r = right.getFloat();
+  return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+CSTableColumnStats::Block::Block(
+    size_t _begin,
+    size_t _end) :
+    begin(_begin),
+    end(_end),
+    has_values(false),
+    has_null(false),
+    has_unordered(false) {}
+
+void CSTableColumnStats::Block::addValue(const SValue& value, sql_type type) {
+  if (value.getType() == SQL_NULL) {
+    has_null = true;
+    return;
+  }
+
+  if (value.getType() != type ||
+      (type == SQL_FLOAT && isnan(value.getFloat()))) {
+    has_unordered = true;
+    return;
+  }
+
+  if (!has_values) {
+    min = value;
+    max = value;
+    has_values = true;
+    return;
+  }
+
+  if (compareValues(type, value, min) < 0) {
+    min = value;
+  }
+
+  if (compareValues(type, value, max) > 0) {
+    max = value;
+  }
+}
+
+CSTableColumnStats::CSTableColumnStats(
+    sql_type type) :
+    type_(type) {}
+
+sql_type CSTableColumnStats::type() const {
+  return type_;
+}
+
+const Vector<CSTableColumnStats::Block>& CSTableColumnStats::blocks() const {
+  return blocks_;
+}
+
+void CSTableColumnStats::addBlock(Block block) {
+  blocks_.emplace_back(std::move(block));
+}
+
+bool CSTableColumnStats::isSupportedType(sql_type type) {
+  switch (type) {
+    case SQL_STRING:
+    case SQL_INTEGER:
+    case SQL_FLOAT:
+    case SQL_TIMESTAMP:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool CSTableColumnStats::mayMatch(
+    const Block& block,
+    const ScanConstraint& constraint) const {
+  const auto& value = constraint.value;
+  if (block.has_unordered || value.getType() == SQL_NULL) {
+    return true;
+  }
+
+  bool is_equality =
+      constraint.type == ScanConstraintType::EQUAL_TO ||
+      constraint.type == ScanConstraintType::NOT_EQUAL_TO;
+
+  SValue min = block.min;
+  SValue max = block.max;
+  bool has_values = block.has_values;
+
+  if (type_ == SQL_STRING) {
+    /* NULL only compares like a string in lt/gt, never in eq */
+    if (block.has_null && !is_equality) {
+      return true;
+    }
+  } else {
+    if (!isOrdered(value)) {
+      return true;
+    }
+
+    /* eq only compares INTEGER and FLOAT values numerically */
+    if (is_equality && (type_ == SQL_TIMESTAMP || !value.isNumeric())) {
+      return true;
+    }
+
+    /* lt/gt treat NULL as zero */
+    if (block.has_null && !is_equality) {
+      SValue zero(SValue::IntegerType(0));
+      if (!has_values || compareValues(type_, zero, min) < 0) {
+        min = zero;
+      }
+
+      if (!has_values || compareValues(type_, zero, max) > 0) {
+        max = zero;
+      }
+
+      has_values = true;
+    }
+  }
+
+  /* NULL != value is always true */
+  if (constraint.type == ScanConstraintType::NOT_EQUAL_TO && block.has_null) {
+    return true;
+  }
+
+  if (!has_values) {
+    return false;
+  }
+
+  switch (constraint.type) {
+
+    case ScanConstraintType::EQUAL_TO:
+      return
+          compareValues(type_, min, value) <= 0 &&
+          compareValues(type_, max, value) >= 0;
+
+    case ScanConstraintType::NOT_EQUAL_TO:
+      return
+          compareValues(type_, min, value) != 0 ||
+          compareValues(type_, max, value) != 0;
+
+    case ScanConstraintType::LESS_THAN:
+      return compareValues(type_, min, value) < 0;
+
+    case ScanConstraintType::LESS_THAN_OR_EQUAL_TO:
+      return compareValues(type_, min, value) <= 0;
+
+    case ScanConstraintType::GREATER_THAN:
+      return compareValues(type_, max, value) > 0;
+
+    case ScanConstraintType::GREATER_THAN_OR_EQUAL_TO:
+      return compareValues(type_, max, value) >= 0;
+
+  }
+
+  return true;
+}
+
+void CSTableColumnStats::encode(OutputStream* os) const {
+  os->appendUInt8(type_);
+  os->appendVarUInt(blocks_.size());
+  for (const auto& block : blocks_) {
+    os->appendVarUInt(block.begin);
+    os->appendVarUInt(block.end);
+    os->appendUInt8(block.has_values);
+    os->appendUInt8(block.has_null);
+    os->appendUInt8(block.has_unordered);
+    if (block.has_values) {
+      block.min.encode(os);
+      block.max.encode(os);
+    }
+  }
+}
+
+RefPtr<CSTableColumnStats> CSTableColumnStats::decode(InputStream* is) {
+  RefPtr<CSTableColumnStats> stats(
+      new CSTableColumnStats((sql_type) is->readUInt8()));
+
+  auto num_blocks = is->readVarUInt();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    auto begin = is->readVarUInt();
+    auto end = is->readVarUInt();
+
+    Block block(begin, end);
+    block.has_values = is->readUInt8();
+    block.has_null = is->readUInt8();
+    block.has_unordered = is->readUInt8();
+    if (block.has_values) {
+      block.min.decode(is);
+      block.max.decode(is);
+    }
+
+    stats->addBlock(std::move(block));
+  }
+
+  return stats;
+}
+
+CSTableColumnStatsCache::CSTableColumnStatsCache(
+    size_t records_per_block /* = CSTableColumnStats::kRecordsPerBlock */) :
+    records_per_block_(records_per_block),
+    cstable_size_(0),
+    cstable_mtime_(0) {}
+
+size_t CSTableColumnStatsCache::recordsPerBlock() const {
+  return records_per_block_;
+}
+
+Option<RefPtr<CSTableColumnStats>> CSTableColumnStatsCache::get(
+    const String& column,
+    sql_type type) const {
+  std::unique_lock<std::mutex> lk(mutex_);
+
+  auto iter = stats_.find(column);
+  if (iter == stats_.end() || iter->second->type() != type) {
+    return None<RefPtr<CSTableColumnStats>>();
+  }
+
+  return Some(iter->second);
+}
+
+void CSTableColumnStatsCache::put(
+    const String& column,
+    RefPtr<CSTableColumnStats> stats) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  stats_[column] = stats;
+
+  if (!sidecar_file_.isEmpty()) {
+    storeSidecarFile();
+  }
+}
+
+void CSTableColumnStatsCache::checkFile(
+    const String& cstable_file,
+    uint64_t num_records) {
+  std::unique_lock<std::mutex> lk(mutex_);
+
+  struct stat st;
+  if (::stat(cstable_file.c_str(), &st) != 0) {
+    RAISEF(kNotFoundError, "file not found: '$0'", cstable_file);
+  }
+
+  if (uint64_t(st.st_size) == cstable_size_ &&
+      uint64_t(st.st_mtime) == cstable_mtime_ &&
+      (cstable_num_records_.isEmpty() ||
+       cstable_num_records_.get() == num_records)) {
+    cstable_num_records_ = Some(num_records);
+    return;
+  }
+
+  /* the sidecar file is rewritten with the new file's size and mtime on the
+     next put */
+  stats_.clear();
+  cstable_size_ = st.st_size;
+  cstable_mtime_ = st.st_mtime;
+  cstable_num_records_ = Some(num_records);
+}
+
+void CSTableColumnStatsCache::setSidecarFile(
+    const String& sidecar_file,
+    const String& cstable_file) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  sidecar_file_ = Some(sidecar_file);
+
+  struct stat st;
+  if (::stat(cstable_file.c_str(), &st) != 0) {
+    RAISEF(kNotFoundError, "file not found: '$0'", cstable_file);
+  }
+
+  cstable_size_ = st.st_size;
+  cstable_mtime_ = st.st_mtime;
+
+  loadSidecarFile();
+}
+
+void CSTableColumnStatsCache::loadSidecarFile() {
+  if (!FileUtil::exists(sidecar_file_.get())) {
+    return;
+  }
+
+  HashMap<String, RefPtr<CSTableColumnStats>> stats;
+  try {
+    auto is = FileInputStream::openFile(sidecar_file_.get());
+    if (is->readVarUInt() != kSidecarVersion ||
+        is->readVarUInt() != cstable_size_ ||
+        is->readVarUInt() != cstable_mtime_ ||
+        is->readVarUInt() != records_per_block_) {
+      return;
+    }
+
+    auto num_columns = is->readVarUInt();
+    for (size_t i = 0; i < num_columns; ++i) {
+      auto column = is->readLenencString();
+      stats.emplace(column, CSTableColumnStats::decode(is.get()));
+    }
+  } catch (const std::exception& e) {
+    /* a corrupt sidecar file is ignored and overwritten by the next put */
+    return;
+  }
+
+  for (const auto& s : stats) {
+    stats_[s.first] = s.second;
+  }
+}
+
+void CSTableColumnStatsCache::storeSidecarFile() {
+  const auto& filename = sidecar_file_.get();
+
+  /* write to a temporary file first so that a concurrent reader never sees a
+     partial file */
+  auto tmpfile = StringUtil::format(
+      "$0.$1.tmp",
+      filename,
+      Random::singleton()->hex128());
+
+  try {
+    {
+      auto os = FileOutputStream::openFile(tmpfile);
+      os->appendVarUInt(kSidecarVersion);
+      os->appendVarUInt(cstable_size_);
+      os->appendVarUInt(cstable_mtime_);
+      os->appendVarUInt(records_per_block_);
+      os->appendVarUInt(stats_.size());
+      for (const auto& s : stats_) {
+        os->appendLenencString(s.first);
+        s.second->encode(os.get());
+      }
+    }
+
+    FileUtil::mv(tmpfile, filename);
+  } catch (const std::exception& e) {
+    if (FileUtil::exists(tmpfile)) {
+      FileUtil::rm(tmpfile);
+    }
+  }
+}
+
+} // namespace csql
@@ -0,0 +1,126 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <mutex>
+#include <stx/stdtypes.h>
+#include <stx/autoref.h>
+#include <stx/io/inputstream.h>
+#include <stx/io/outputstream.h>
+#include <csql/svalue.h>
+#include <csql/qtree/SequentialScanNode.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Min/max statistics for a single column of a cstable file, recorded for
+ * consecutive blocks of kRecordsPerBlock records. The values are recorded as
+ * the scan sees them (i.e. after conversion to the column's sql type) so that
+ * mayMatch can mirror the semantics of the eq/lt/lte/gt/gte expressions.
+ */
+class CSTableColumnStats : public RefCounted {
+public:
+
+  static const size_t kRecordsPerBlock;
+
+  struct Block {
+    Block(size_t begin, size_t end);
+
+    void addValue(const SValue& value, sql_type type);
+
+    size_t begin;
+    size_t end;
+    bool has_values;
+    bool has_null;
+    bool has_unordered;
+    SValue min;
+    SValue max;
+  };
+
+  CSTableColumnStats(sql_type type);
+
+  sql_type type() const;
+  const Vector<Block>& blocks() const;
+
+  void addBlock(Block block);
+
+  /**
+   * Returns false if no row in the block can satisfy the constraint, true
+   * otherwise
+   */
+  bool mayMatch(const Block& block, const ScanConstraint& constraint) const;
+
+  /**
+   * Returns true if the stats can be used to evaluate constraints on columns
+   * of the provided type
+   */
+  static bool isSupportedType(sql_type type);
+
+  void encode(OutputStream* os) const;
+  static RefPtr<CSTableColumnStats> decode(InputStream* is);
+
+protected:
+  sql_type type_;
+  Vector<Block> blocks_;
+};
+
+/**
+ * Keeps the column stats of one cstable file around between scans. The stats
+ * are computed for blocks of records_per_block records.
+ */
+class CSTableColumnStatsCache : public RefCounted {
+public:
+
+  CSTableColumnStatsCache(
+      size_t records_per_block = CSTableColumnStats::kRecordsPerBlock);
+
+  size_t recordsPerBlock() const;
+
+  Option<RefPtr<CSTableColumnStats>> get(
+      const String& column,
+      sql_type type) const;
+
+  void put(const String& column, RefPtr<CSTableColumnStats> stats);
+
+  /**
+   * Drops all cached stats if the provided cstable file's size, modification
+   * time or number of records differ from the file the stats were computed
+   * for. Scans call this before they use the cache.
+   */
+  void checkFile(const String& cstable_file, uint64_t num_records);
+
+  /**
+   * Persist the stats of the provided cstable file in a sidecar file so that
+   * they survive restarts. Stats that were stored in the sidecar file are
+   * loaded immediately unless the cstable file's size or modification time
+   * changed since they were written; the sidecar file is rewritten whenever new
+   * stats are added. Failing to read or write the sidecar file is not an error,
+   * the stats are then recomputed on the next scan.
+   */
+  void setSidecarFile(const String& sidecar_file, const String& cstable_file);
+
+protected:
+
+  static const uint64_t kSidecarVersion;
+
+  void loadSidecarFile();
+  void storeSidecarFile();
+
+  size_t records_per_block_;
+  Option<String> sidecar_file_;
+  uint64_t cstable_size_;
+  uint64_t cstable_mtime_;
+  Option<uint64_t> cstable_num_records_;
+  mutable std::mutex mutex_;
+  HashMap<String, RefPtr<CSTableColumnStats>> stats_;
+};
+
+} // namespace csql
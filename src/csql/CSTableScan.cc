@@ -11,6 +11,8 @@
 #include <csql/qtree/ColumnReferenceNode.h>
 #include <csql/runtime/defaultruntime.h>
 #include <csql/runtime/compiler.h>
+#include <csql/runtime/runtime.h>
+#include <csql/tasks/limit.h>
 #include <stx/ieee754.h>
 #include <stx/logging.h>
 
@@ -18,6 +20,9 @@ using namespace stx;
 
 namespace csql {
 
+const size_t CSTableScan::kMinRecordsPerMorsel = 8192;
+const size_t CSTableScan::kMorselsPerThread = 4;
+
 CSTableScan::CSTableScan(
     Transaction* txn,
     RefPtr<SequentialScanNode> stmt,
@@ -32,7 +37,11 @@ CSTableScan::CSTableScan(
     colindex_(0),
     aggr_strategy_(stmt_->aggregationStrategy()),
     rows_scanned_(0),
-    opened_(false) {
+    opened_(false),
+    parallelism_(1),
+    min_records_per_morsel_(kMinRecordsPerMorsel),
+    range_begin_(0),
+    range_end_(size_t(-1)) {
   column_names_ = stmt_->outputColumns();
 }
 
@@ -50,7 +59,11 @@ CSTableScan::CSTableScan(
     colindex_(0),
     aggr_strategy_(stmt_->aggregationStrategy()),
     rows_scanned_(0),
-    opened_(false) {
+    opened_(false),
+    parallelism_(1),
+    min_records_per_morsel_(kMinRecordsPerMorsel),
+    range_begin_(0),
+    range_end_(size_t(-1)) {
   column_names_ = stmt_->outputColumns();
 }
 
@@ -68,7 +81,8 @@ void CSTableScan::open() {
 
   auto where_expr = stmt_->whereExpression();
   if (!where_expr.isEmpty()) {
-    findColumns(where_expr.get(), &column_names);
+    findColumns(where_expr.get(), &where_columns_);
+    column_names.insert(where_columns_.begin(), where_columns_.end());
   }
 
   for (const auto& col : column_names) {
@@ -117,6 +131,11 @@ void CSTableScan::open() {
     resolveColumns(where_expr.get());
     where_expr_ = runtime_->buildValueExpression(txn_, where_expr.get());
   }
+
+  if (!stmt_->limit().isEmpty() &&
+      aggr_strategy_ == AggregationStrategy::NO_AGGREGATION) {
+    output_ = Limit::limitOutput(stmt_->limit().get(), output_);
+  }
 }
 
 void CSTableScan::onInputsReady() {
@@ -136,233 +155,596 @@ void CSTableScan::onInputsReady() {
 }
 
 void CSTableScan::scan() {
-  uint64_t select_level = 0;
-  uint64_t fetch_level = 0;
-  bool filter_pred = true;
+  size_t total_records = cstable_->numRecords();
+  findRecordRanges(total_records);
+
+  auto begin = std::min(range_begin_, total_records);
+  auto end = std::min(range_end_, total_records);
+
+  /* only AGGREGATE_ALL scans are split into morsels: their partial states
+     are merged at the end, while the rows of other scans would have to be
+     buffered until all preceding morsels are complete */
+  if (parallelism_ > 1 &&
+      aggr_strategy_ == AggregationStrategy::AGGREGATE_ALL &&
+      !cstable_filename_.empty() &&
+      !filter_fn_ &&
+      end - begin >= min_records_per_morsel_ * 2) {
+    scanParallel(begin, end);
+    return;
+  }
+
+  Vector<VM::Instance*> instances;
+  for (auto& e : select_list_) {
+    instances.emplace_back(&e.instance);
+  }
+
+  size_t pos = 0;
+  if (!scanRanges(
+          &columns_,
+          instances,
+          &pos,
+          begin,
+          end,
+          output_,
+          &rows_scanned_)) {
+    return;
+  }
 
-  Vector<SValue> in_row(colindex_, SValue{});
   Vector<SValue> out_row(select_list_.size(), SValue{});
+  switch (aggr_strategy_) {
+    case AggregationStrategy::AGGREGATE_ALL:
+      for (int i = 0; i < select_list_.size(); ++i) {
+        VM::result(
+            txn_,
+            select_list_[i].compiled.program(),
+            &select_list_[i].instance,
+            &out_row[i]);
+      }
 
-  size_t num_records = 0;
-  size_t total_records = cstable_->numRecords();
-  while (num_records < total_records) {
-    ++rows_scanned_;
-    uint64_t next_level = 0;
+      output_(out_row.data(), out_row.size());
+      break;
 
-    if (fetch_level == 0) {
-      if (num_records < total_records && filter_fn_) {
-        filter_pred = filter_fn_();
+    default:
+      break;
+
+  }
+}
+
+void CSTableScan::scanParallel(size_t begin, size_t end) {
+  size_t num_records = end - begin;
+  size_t num_morsels = std::min(
+      parallelism_ * kMorselsPerThread,
+      num_records / min_records_per_morsel_);
+  size_t num_workers = std::min(parallelism_, num_morsels);
+
+  auto queue = std::make_shared<MorselQueue>();
+  for (size_t i = 0; i < num_morsels; ++i) {
+    Morsel morsel;
+    morsel.begin = begin + (num_records * i) / num_morsels;
+    morsel.end = begin + (num_records * (i + 1)) / num_morsels;
+    queue->morsels.emplace_back(morsel);
+  }
+
+  for (size_t i = 0; i < num_workers; ++i) {
+    auto worker = mkScoped(new MorselWorker());
+    worker->pos = 0;
+    worker->rows_scanned = 0;
+    for (const auto& e : select_list_) {
+      worker->instances.emplace_back(
+          VM::allocInstance(txn_, e.compiled.program(), &worker->scratch));
+    }
+
+    queue->workers.emplace_back(std::move(worker));
+  }
+
+  /* morsels are handed out in record order, so each worker only ever moves
+     its column readers forward. the calling thread works off morsels too, so
+     the scan makes progress even if the thread pool is saturated */
+  auto run_worker = [this, queue] (MorselWorker* worker) {
+    try {
+      for (;;) {
+        auto idx = queue->next++;
+        if (idx >= queue->morsels.size()) {
+          break;
+        }
+
+        scanMorsel(worker, queue->morsels[idx]);
       }
+    } catch (...) {
+      worker->error = std::current_exception();
+      queue->next = queue->morsels.size();
     }
 
-    for (auto& col : columns_) {
-      auto nextr = col.second.reader->nextRepetitionLevel();
+    std::unique_lock<std::mutex> lk(queue->mutex);
+    ++queue->num_completed;
+    queue->cv.notify_all();
+  };
 
-      if (nextr >= fetch_level) {
-        auto& reader = col.second.reader;
-
-        uint64_t r;
-        uint64_t d;
-
-        switch (col.second.reader->type()) {
-
-          case cstable::ColumnType::STRING: {
-            String v;
-            reader->readString(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue();
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newString(v);
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newFloat(v);
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newInteger(v);
-                  break;
-                case SQL_BOOL:
-                  in_row[col.second.index] = SValue::newBool(v);
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-              }
-            }
+  auto sched = txn_->getRuntime()->scheduler();
+  for (size_t i = 1; i < num_workers; ++i) {
+    auto worker = queue->workers[i].get();
+    sched->run([run_worker, worker] { run_worker(worker); });
+  }
 
-            break;
-          }
+  run_worker(queue->workers[0].get());
+
+  {
+    std::unique_lock<std::mutex> lk(queue->mutex);
+    queue->cv.wait(lk, [queue] {
+      return queue->num_completed == queue->workers.size();
+    });
+  }
+
+  std::exception_ptr error;
+  for (auto& worker : queue->workers) {
+    rows_scanned_ += worker->rows_scanned;
+    if (worker->error && !error) {
+      error = worker->error;
+    }
+  }
+
+  if (!error) {
+    for (auto& worker : queue->workers) {
+      for (int i = 0; i < select_list_.size(); ++i) {
+        VM::merge(
+            txn_,
+            select_list_[i].compiled.program(),
+            &select_list_[i].instance,
+            &worker->instances[i]);
+      }
+    }
+
+    Vector<SValue> out_row(select_list_.size(), SValue{});
+    for (int i = 0; i < select_list_.size(); ++i) {
+      VM::result(
+          txn_,
+          select_list_[i].compiled.program(),
+          &select_list_[i].instance,
+          &out_row[i]);
+    }
+
+    output_(out_row.data(), out_row.size());
+  }
+
+  for (auto& worker : queue->workers) {
+    for (int i = 0; i < worker->instances.size(); ++i) {
+      VM::freeInstance(
+          txn_,
+          select_list_[i].compiled.program(),
+          &worker->instances[i]);
+    }
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void CSTableScan::scanMorsel(MorselWorker* worker, const Morsel& morsel) {
+  if (worker->cstable.get() == nullptr) {
+    worker->cstable = cstable::CSTableReader::openFile(cstable_filename_);
+    for (const auto& col : columns_) {
+      worker->columns.emplace(
+          col.first,
+          ColumnRef(
+              worker->cstable->getColumnReader(col.first),
+              col.second.index,
+              col.second.type));
+    }
+  }
+
+  Vector<VM::Instance*> instances;
+  for (auto& instance : worker->instances) {
+    instances.emplace_back(&instance);
+  }
+
+  scanRanges(
+      &worker->columns,
+      instances,
+      &worker->pos,
+      morsel.begin,
+      morsel.end,
+      [] (const SValue* row, int row_len) -> bool {
+        return true;
+      },
+      &worker->rows_scanned);
+}
+
+void CSTableScan::findRecordRanges(size_t total_records) {
+  auto records_per_block = recordsPerBlock();
+  auto num_blocks = (total_records + records_per_block - 1) / records_per_block;
+  Vector<bool> block_matches(num_blocks, true);
+
+  if (column_stats_cache_.get() != nullptr && !cstable_filename_.empty()) {
+    column_stats_cache_->checkFile(cstable_filename_, total_records);
+  }
+
+  /* the filter function must see every record, so we can't skip any */
+  if (!filter_fn_) {
+    for (const auto& constraint : stmt_->constraints()) {
+      auto col = columns_.find(constraint.column_name);
+      if (col == columns_.end() ||
+          !CSTableColumnStats::isSupportedType(col->second.type)) {
+        continue;
+      }
+
+      auto stats = getColumnStats(constraint.column_name, col->second);
+      const auto& blocks = stats->blocks();
+      if (blocks.size() != num_blocks) {
+        continue;
+      }
+
+      for (size_t i = 0; i < num_blocks; ++i) {
+        if (block_matches[i] && !stats->mayMatch(blocks[i], constraint)) {
+          block_matches[i] = false;
+        }
+      }
+    }
+  }
+
+  record_ranges_.clear();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    if (!block_matches[i]) {
+      continue;
+    }
+
+    auto begin = i * records_per_block;
+    auto end = std::min(begin + records_per_block, total_records);
+    if (!record_ranges_.empty() && record_ranges_.back().second == begin) {
+      record_ranges_.back().second = end;
+    } else {
+      record_ranges_.emplace_back(begin, end);
+    }
+  }
+}
+
+RefPtr<CSTableColumnStats> CSTableScan::getColumnStats(
+    const String& column_name,
+    const ColumnRef& column) {
+  if (column_stats_cache_.get() != nullptr) {
+    auto cached = column_stats_cache_->get(column_name, column.type);
+    if (!cached.isEmpty()) {
+      return cached.get();
+    }
+  }
+
+  ColumnRef col(
+      cstable_->getColumnReader(column_name),
+      column.index,
+      column.type);
+
+  RefPtr<CSTableColumnStats> stats(new CSTableColumnStats(column.type));
+  auto records_per_block = recordsPerBlock();
+  auto total_records = cstable_->numRecords();
+  for (size_t begin = 0; begin < total_records; begin += records_per_block) {
+    CSTableColumnStats::Block block(
+        begin,
+        std::min(begin + records_per_block, total_records));
+
+    for (size_t i = block.begin; i < block.end; ++i) {
+      do {
+        SValue value;
+        readValue(col, &value);
+        block.addValue(value, column.type);
+      } while (col.reader->nextRepetitionLevel() > 0);
+    }
+
+    stats->addBlock(std::move(block));
+  }
+
+  if (column_stats_cache_.get() != nullptr) {
+    column_stats_cache_->put(column_name, stats);
+  }
+
+  return stats;
+}
+
+size_t CSTableScan::recordsPerBlock() const {
+  if (column_stats_cache_.get() != nullptr) {
+    return column_stats_cache_->recordsPerBlock();
+  } else {
+    return CSTableColumnStats::kRecordsPerBlock;
+  }
+}
+
+bool CSTableScan::scanRanges(
+    HashMap<String, ColumnRef>* columns,
+    const Vector<VM::Instance*>& instances,
+    size_t* pos,
+    size_t begin,
+    size_t end,
+    RowSinkFn output,
+    size_t* rows_scanned) {
+  for (const auto& range : record_ranges_) {
+    auto range_begin = std::max(range.first, begin);
+    auto range_end = std::min(range.second, end);
+    if (range_begin >= range_end) {
+      continue;
+    }
 
-          case cstable::ColumnType::UNSIGNED_INT: {
-            uint64_t v = 0;
-            reader->readUnsignedInt(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue();
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newInteger(v).toString();
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newFloat(v);
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newInteger(v);
-                  break;
-                case SQL_BOOL:
-                  in_row[col.second.index] = SValue::newBool(v);
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-              }
-            }
+    if (range_begin > *pos) {
+      for (auto& col : *columns) {
+        skipRecords(col.second.reader.get(), range_begin - *pos);
+      }
+    }
+
+    *pos = range_begin;
+    if (!scanRecords(
+            columns,
+            instances,
+            range_end - range_begin,
+            output,
+            rows_scanned)) {
+      return false;
+    }
+
+    *pos = range_end;
+  }
+
+  return true;
+}
+
+void CSTableScan::skipRecords(cstable::ColumnReader* reader, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    do {
+      reader->skipValue();
+    } while (reader->nextRepetitionLevel() > 0);
+  }
+}
 
+void CSTableScan::readValue(const ColumnRef& column, SValue* value) {
+  auto& reader = column.reader;
+
+  uint64_t r;
+  uint64_t d;
+
+  switch (column.reader->type()) {
+
+    case cstable::ColumnType::STRING: {
+      String v;
+      reader->readString(&r, &d, &v);
+
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue();
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
             break;
-          }
+          case SQL_STRING:
+            *value = SValue::newString(v);
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newFloat(v);
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newInteger(v);
+            break;
+          case SQL_BOOL:
+            *value = SValue::newBool(v);
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+        }
+      }
+
+      break;
+    }
 
-          case cstable::ColumnType::SIGNED_INT: {
-            int64_t v = 0;
-            reader->readSignedInt(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue();
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newInteger(v).toString();
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newFloat(v);
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newInteger(v);
-                  break;
-                case SQL_BOOL:
-                  in_row[col.second.index] = SValue::newBool(v);
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-              }
-            }
+    case cstable::ColumnType::UNSIGNED_INT: {
+      uint64_t v = 0;
+      reader->readUnsignedInt(&r, &d, &v);
 
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue();
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
             break;
-          }
+          case SQL_STRING:
+            *value = SValue::newInteger(v).toString();
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newFloat(v);
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newInteger(v);
+            break;
+          case SQL_BOOL:
+            *value = SValue::newBool(v);
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+        }
+      }
+
+      break;
+    }
 
-          case cstable::ColumnType::BOOLEAN: {
-            bool v = 0;
-            reader->readBoolean(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue(SValue::BoolType(false));
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newBool(v).toString();
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newFloat(v);
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newInteger(v);
-                  break;
-                case SQL_BOOL:
-                  in_row[col.second.index] = SValue::newBool(v);
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-              }
-            }
+    case cstable::ColumnType::SIGNED_INT: {
+      int64_t v = 0;
+      reader->readSignedInt(&r, &d, &v);
 
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue();
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
             break;
-          }
+          case SQL_STRING:
+            *value = SValue::newInteger(v).toString();
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newFloat(v);
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newInteger(v);
+            break;
+          case SQL_BOOL:
+            *value = SValue::newBool(v);
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+        }
+      }
 
-          case cstable::ColumnType::FLOAT: {
-            double v = 0;
-            reader->readFloat(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue();
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newFloat(v).toString();
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newFloat(v);
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newInteger(v);
-                  break;
-                case SQL_BOOL:
-                  in_row[col.second.index] = SValue::newBool(v);
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-              }
-            }
+      break;
+    }
 
+    case cstable::ColumnType::BOOLEAN: {
+      bool v = 0;
+      reader->readBoolean(&r, &d, &v);
+
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue(SValue::BoolType(false));
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
             break;
-          }
+          case SQL_STRING:
+            *value = SValue::newBool(v).toString();
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newFloat(v);
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newInteger(v);
+            break;
+          case SQL_BOOL:
+            *value = SValue::newBool(v);
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+        }
+      }
+
+      break;
+    }
 
-          case cstable::ColumnType::DATETIME: {
-            UnixTime v;
-            reader->readDateTime(&r, &d, &v);
-
-            if (d < reader->maxDefinitionLevel()) {
-              in_row[col.second.index] = SValue();
-            } else {
-              switch (col.second.type) {
-                case SQL_NULL:
-                  in_row[col.second.index] = SValue::newNull();
-                  break;
-                case SQL_STRING:
-                  in_row[col.second.index] = SValue::newTimestamp(v).toString();
-                  break;
-                case SQL_FLOAT:
-                  in_row[col.second.index] = SValue::newTimestamp(v).toFloat();
-                  break;
-                case SQL_INTEGER:
-                  in_row[col.second.index] = SValue::newTimestamp(v).toInteger();
-                  break;
-                case SQL_TIMESTAMP:
-                  in_row[col.second.index] = SValue::newTimestamp(v);
-                  break;
-                default:
-                  RAISE(kIllegalStateError);
-              }
-            }
+    case cstable::ColumnType::FLOAT: {
+      double v = 0;
+      reader->readFloat(&r, &d, &v);
 
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue();
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
             break;
-          }
+          case SQL_STRING:
+            *value = SValue::newFloat(v).toString();
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newFloat(v);
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newInteger(v);
+            break;
+          case SQL_BOOL:
+            *value = SValue::newBool(v);
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+        }
+      }
 
-          case cstable::ColumnType::SUBRECORD:
-            RAISE(kIllegalStateError);
+      break;
+    }
 
+    case cstable::ColumnType::DATETIME: {
+      UnixTime v;
+      reader->readDateTime(&r, &d, &v);
+
+      if (d < reader->maxDefinitionLevel()) {
+        *value = SValue();
+      } else {
+        switch (column.type) {
+          case SQL_NULL:
+            *value = SValue::newNull();
+            break;
+          case SQL_STRING:
+            *value = SValue::newTimestamp(v).toString();
+            break;
+          case SQL_FLOAT:
+            *value = SValue::newTimestamp(v).toFloat();
+            break;
+          case SQL_INTEGER:
+            *value = SValue::newTimestamp(v).toInteger();
+            break;
+          case SQL_TIMESTAMP:
+            *value = SValue::newTimestamp(v);
+            break;
+          default:
+            RAISE(kIllegalStateError);
         }
       }
 
+      break;
+    }
+
+    case cstable::ColumnType::SUBRECORD:
+      RAISE(kIllegalStateError);
+
+  }
+}
+
+bool CSTableScan::scanRecords(
+    HashMap<String, ColumnRef>* columns,
+    const Vector<VM::Instance*>& instances,
+    size_t total_records,
+    RowSinkFn output,
+    size_t* rows_scanned) {
+  bool is_flat = true;
+  for (const auto& col : *columns) {
+    if (col.second.reader->maxRepetitionLevel() > 0) {
+      is_flat = false;
+      break;
+    }
+  }
+
+  if (is_flat) {
+    return scanFlatRecords(
+        columns,
+        instances,
+        total_records,
+        output,
+        rows_scanned);
+  }
+
+  uint64_t select_level = 0;
+  uint64_t fetch_level = 0;
+  bool filter_pred = true;
+
+  Vector<SValue> in_row(colindex_, SValue{});
+  Vector<SValue> out_row(select_list_.size(), SValue{});
+
+  size_t num_records = 0;
+  while (num_records < total_records) {
+    ++(*rows_scanned);
+    uint64_t next_level = 0;
+
+    if (fetch_level == 0) {
+      if (num_records < total_records && filter_fn_) {
+        filter_pred = filter_fn_();
+      }
+    }
+
+    for (auto& col : *columns) {
+      auto nextr = col.second.reader->nextRepetitionLevel();
+
+      if (nextr >= fetch_level) {
+        readValue(col.second, &in_row[col.second.index]);
+      }
+
       next_level = std::max(
           next_level,
           col.second.reader->nextRepetitionLevel());
@@ -392,7 +774,7 @@ void CSTableScan::scan() {
           VM::accumulate(
               txn_,
               select_list_[i].compiled.program(),
-              &select_list_[i].instance,
+              instances[i],
               in_row.size(),
               in_row.data());
         }
@@ -413,17 +795,17 @@ void CSTableScan::scan() {
             VM::result(
                 txn_,
                 select_list_[i].compiled.program(),
-                &select_list_[i].instance,
+                instances[i],
                 &out_row[i]);
 
             VM::reset(
                 txn_,
                 select_list_[i].compiled.program(),
-                &select_list_[i].instance);
+                instances[i]);
           }
 
-          if (!output_(out_row.data(), out_row.size())) {
-            return;
+          if (!output(out_row.data(), out_row.size())) {
+            return false;
           }
 
           break;
@@ -438,8 +820,8 @@ void CSTableScan::scan() {
                 &out_row[i]);
           }
 
-          if (!output_(out_row.data(), out_row.size())) {
-            return;
+          if (!output(out_row.data(), out_row.size())) {
+            return false;
           }
 
           break;
@@ -451,37 +833,179 @@ void CSTableScan::scan() {
       select_level = std::min(select_level, fetch_level);
     }
 
-    for (const auto& col : columns_) {
+    for (const auto& col : *columns) {
       if (col.second.reader->maxRepetitionLevel() >= select_level) {
         in_row[col.second.index] = SValue();
       }
     }
   }
 
-  switch (aggr_strategy_) {
-    case AggregationStrategy::AGGREGATE_ALL:
+  return true;
+}
+
+bool CSTableScan::scanFlatRecords(
+    HashMap<String, ColumnRef>* columns,
+    const Vector<VM::Instance*>& instances,
+    size_t total_records,
+    RowSinkFn output,
+    size_t* rows_scanned) {
+  Vector<ColumnRef*> where_columns;
+  Vector<ColumnRef*> other_columns;
+  for (auto& col : *columns) {
+    if (where_columns_.count(col.first) > 0) {
+      where_columns.emplace_back(&col.second);
+    } else {
+      other_columns.emplace_back(&col.second);
+    }
+  }
+
+  auto batch_size = VM::kDefaultBatchSize;
+  Vector<Vector<SValue>> batch(colindex_, Vector<SValue>(batch_size));
+  Vector<const SValue*> batch_columns;
+  for (const auto& col : batch) {
+    batch_columns.emplace_back(col.data());
+  }
+
+  Vector<SValue> where_result(batch_size);
+  Vector<Vector<SValue>> out_columns(
+      select_list_.size(),
+      Vector<SValue>(batch_size));
+  Vector<SValue> in_row(colindex_, SValue{});
+  Vector<SValue> out_row(select_list_.size(), SValue{});
+
+  for (size_t pos = 0; pos < total_records; ) {
+    auto nrecords = std::min(batch_size, total_records - pos);
+    pos += nrecords;
+    *rows_scanned += nrecords;
+
+    for (size_t n = 0; n < nrecords; ++n) {
+      for (auto col : where_columns) {
+        readValue(*col, &batch[col->index][n]);
+      }
+    }
+
+    if (where_expr_.program() != nullptr) {
+      VM::evaluateBatch(
+          txn_,
+          where_expr_.program(),
+          nrecords,
+          colindex_,
+          batch_columns.data(),
+          where_result.data());
+    }
+
+    /* decode the remaining columns of matching records only. matching
+       records are moved to the front of the batch */
+    size_t nmatches = 0;
+    for (size_t n = 0; n < nrecords; ++n) {
+      bool where_pred = true;
+      if (filter_fn_) {
+        where_pred = filter_fn_();
+      }
+
+      if (where_pred && where_expr_.program() != nullptr) {
+        where_pred = where_result[n].getBool();
+      }
+
+      if (!where_pred) {
+        for (auto col : other_columns) {
+          col->reader->skipValue();
+        }
+
+        continue;
+      }
+
+      if (nmatches != n) {
+        for (auto col : where_columns) {
+          batch[col->index][nmatches] = std::move(batch[col->index][n]);
+        }
+      }
+
+      for (auto col : other_columns) {
+        readValue(*col, &batch[col->index][nmatches]);
+      }
+
+      ++nmatches;
+    }
+
+    if (aggr_strategy_ == AggregationStrategy::NO_AGGREGATION) {
       for (int i = 0; i < select_list_.size(); ++i) {
-        VM::result(
+        VM::evaluateBatch(
             txn_,
             select_list_[i].compiled.program(),
-            &select_list_[i].instance,
-            &out_row[i]);
+            nmatches,
+            colindex_,
+            batch_columns.data(),
+            out_columns[i].data());
       }
 
-      output_(out_row.data(), out_row.size());
-      break;
+      for (size_t n = 0; n < nmatches; ++n) {
+        for (int i = 0; i < select_list_.size(); ++i) {
+          out_row[i] = std::move(out_columns[i][n]);
+        }
 
-    default:
-      break;
+        if (!output(out_row.data(), out_row.size())) {
+          return false;
+        }
+      }
+
+      continue;
+    }
+
+    for (size_t n = 0; n < nmatches; ++n) {
+      for (size_t i = 0; i < colindex_; ++i) {
+        std::swap(in_row[i], batch[i][n]);
+      }
+
+      for (int i = 0; i < select_list_.size(); ++i) {
+        VM::accumulate(
+            txn_,
+            select_list_[i].compiled.program(),
+            instances[i],
+            in_row.size(),
+            in_row.data());
+      }
+
+      switch (aggr_strategy_) {
+
+        case AggregationStrategy::AGGREGATE_WITHIN_RECORD_FLAT:
+        case AggregationStrategy::AGGREGATE_WITHIN_RECORD_DEEP:
+          for (int i = 0; i < select_list_.size(); ++i) {
+            VM::result(
+                txn_,
+                select_list_[i].compiled.program(),
+                instances[i],
+                &out_row[i]);
 
+            VM::reset(
+                txn_,
+                select_list_[i].compiled.program(),
+                instances[i]);
+          }
+
+          if (!output(out_row.data(), out_row.size())) {
+            return false;
+          }
+
+          break;
+
+        default:
+          break;
+
+      }
+    }
   }
+
+  return true;
 }
 
 void CSTableScan::scanWithoutColumns() {
   Vector<SValue> out_row(select_list_.size(), SValue{});
 
   size_t total_records = cstable_->numRecords();
-  for (size_t i = 0; i < total_records; ++i) {
+  auto begin = std::min(range_begin_, total_records);
+  auto end = std::min(range_end_, total_records);
+  for (size_t i = begin; i < end; ++i) {
     bool where_pred = true;
     if (where_expr_.program() != nullptr) {
       SValue where_tmp;
@@ -621,6 +1145,23 @@ void CSTableScan::setFilter(Function<bool ()> filter_fn) {
   filter_fn_ = filter_fn;
 }
 
+void CSTableScan::setParallelism(
+    size_t max_threads,
+    size_t min_records_per_morsel /* = kMinRecordsPerMorsel */) {
+  parallelism_ = std::max(max_threads, size_t(1));
+  min_records_per_morsel_ = std::max(min_records_per_morsel, size_t(1));
+}
+
+void CSTableScan::setRecordRange(size_t begin, size_t end) {
+  range_begin_ = begin;
+  range_end_ = end;
+}
+
+void CSTableScan::setColumnStatsCache(
+    RefPtr<CSTableColumnStatsCache> cache) {
+  column_stats_cache_ = cache;
+}
+
 void CSTableScan::setColumnType(String column, sql_type type) {
   const auto& col = columns_.find(column);
   if (col == columns_.end()) {
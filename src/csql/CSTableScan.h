@@ -8,9 +8,12 @@
  * <http://www.gnu.org/licenses/>.
  */
 #pragma once
+#include <mutex>
+#include <condition_variable>
 #include <stx/stdtypes.h>
 #include <stx/protobuf/MessageSchema.h>
 #include <csql/qtree/SequentialScanNode.h>
+#include <csql/CSTableColumnStats.h>
 #include <csql/runtime/compiler.h>
 #include <csql/runtime/defaultruntime.h>
 #include <csql/runtime/TableExpression.h>
@@ -53,6 +56,34 @@ public:
   void setFilter(Function<bool ()> filter_fn);
   void setColumnType(String column, sql_type type);
 
+  /**
+   * Split an AGGREGATE_ALL scan into record ranges ("morsels") of at least
+   * min_records_per_morsel records that are scanned by up to max_threads
+   * threads of the runtime's thread pool and merged at the end. Only takes
+   * effect for scans that were constructed with a filename and have no filter
+   * set. Other scans emit rows as they go and are always serial.
+   */
+  void setParallelism(
+      size_t max_threads,
+      size_t min_records_per_morsel = kMinRecordsPerMorsel);
+
+  /**
+   * Only scan the records in [begin, end). Used to split one scan into
+   * several tasks (see SequentialScanNode::isPartitionable)
+   */
+  void setRecordRange(size_t begin, size_t end);
+
+  /**
+   * Keep the per-block column stats that are used to skip record ranges that
+   * can't match the scan constraints in the provided cache. Without a cache
+   * the stats are recomputed on every scan. The cache also determines the
+   * block size.
+   */
+  void setColumnStatsCache(RefPtr<CSTableColumnStatsCache> cache);
+
+  static const size_t kMinRecordsPerMorsel;
+  static const size_t kMorselsPerThread;
+
 protected:
 
   struct ColumnRef {
@@ -78,9 +109,87 @@ protected:
     VM::Instance instance;
   };
 
+  struct Morsel {
+    size_t begin;
+    size_t end;
+  };
+
+  /**
+   * Per-thread scan state. The column readers can't seek, so a worker keeps
+   * its readers open across morsels and skips forward from its current
+   * position (pos) to the start of the next morsel
+   */
+  struct MorselWorker {
+    RefPtr<cstable::CSTableReader> cstable;
+    HashMap<String, ColumnRef> columns;
+    size_t pos;
+    ScratchMemory scratch;
+    Vector<VM::Instance> instances;
+    size_t rows_scanned;
+    std::exception_ptr error;
+  };
+
+  struct MorselQueue {
+    MorselQueue() : next(0), num_completed(0) {}
+    Vector<Morsel> morsels;
+    Vector<ScopedPtr<MorselWorker>> workers;
+    std::atomic<size_t> next;
+    size_t num_completed;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
   void scan();
+  void scanParallel(size_t begin, size_t end);
+  void scanMorsel(MorselWorker* worker, const Morsel& morsel);
   void scanWithoutColumns();
 
+  void findRecordRanges(size_t total_records);
+
+  RefPtr<CSTableColumnStats> getColumnStats(
+      const String& column_name,
+      const ColumnRef& column);
+
+  size_t recordsPerBlock() const;
+
+  /**
+   * Scans the matching record ranges within [begin, end). The column readers
+   * are positioned at record *pos, which is advanced as records are read or
+   * skipped
+   */
+  bool scanRanges(
+      HashMap<String, ColumnRef>* columns,
+      const Vector<VM::Instance*>& instances,
+      size_t* pos,
+      size_t begin,
+      size_t end,
+      RowSinkFn output,
+      size_t* rows_scanned);
+
+  bool scanRecords(
+      HashMap<String, ColumnRef>* columns,
+      const Vector<VM::Instance*>& instances,
+      size_t total_records,
+      RowSinkFn output,
+      size_t* rows_scanned);
+
+  /**
+   * Scan path for tables without repeated columns: reads the records in
+   * batches of VM::kDefaultBatchSize and evaluates the WHERE and select
+   * expressions for a whole batch with VM::evaluateBatch. The columns
+   * referenced by the WHERE expression are decoded first; the remaining
+   * columns are only decoded for records that match
+   */
+  bool scanFlatRecords(
+      HashMap<String, ColumnRef>* columns,
+      const Vector<VM::Instance*>& instances,
+      size_t total_records,
+      RowSinkFn output,
+      size_t* rows_scanned);
+
+  static void skipRecords(cstable::ColumnReader* reader, size_t n);
+  static void readValue(const ColumnRef& column, SValue* value);
+
   void findColumns(
       RefPtr<ValueExpressionNode> expr,
       Set<String>* column_names) const;
@@ -102,12 +211,19 @@ protected:
   HashMap<String, ColumnRef> columns_;
   Vector<ExpressionRef> select_list_;
   ValueExpression where_expr_;
+  Set<String> where_columns_;
   size_t colindex_;
   AggregationStrategy aggr_strategy_;
   Option<SHA1Hash> cache_key_;
   size_t rows_scanned_;
   Function<bool ()> filter_fn_;
   bool opened_;
+  size_t parallelism_;
+  size_t min_records_per_morsel_;
+  size_t range_begin_;
+  size_t range_end_;
+  RefPtr<CSTableColumnStatsCache> column_stats_cache_;
+  Vector<std::pair<size_t, size_t>> record_ranges_;
 };
 
 
@@ -19,7 +19,10 @@ CSTableScanProvider::CSTableScanProvider(
     const String& table_name,
     const String& cstable_file) :
     table_name_(table_name),
-    cstable_file_(cstable_file) {}
+    cstable_file_(cstable_file),
+    scan_parallelism_(1),
+    min_records_per_morsel_(CSTableScan::kMinRecordsPerMorsel),
+    column_stats_(new CSTableColumnStatsCache()) {}
 
 TaskIDList CSTableScanProvider::buildSequentialScan(
     Transaction* txn,
@@ -29,21 +32,67 @@ TaskIDList CSTableScanProvider::buildSequentialScan(
     RAISEF(kNotFoundError, "table not found: '$0'", node->tableName());
   }
 
+  /* split scans whose consumer doesn't depend on the row order into one task
+     per record range, so that they can run concurrently */
+  size_t total_records = 0;
+  size_t num_partitions = 1;
+  if (scan_parallelism_ > 1 &&
+      node->isPartitionable() &&
+      node->limit().isEmpty() &&
+      node->aggregationStrategy() != AggregationStrategy::AGGREGATE_ALL) {
+    total_records =
+        cstable::CSTableReader::openFile(cstable_file_)->numRecords();
+
+    num_partitions = std::max(
+        std::min(scan_parallelism_, total_records / min_records_per_morsel_),
+        size_t(1));
+  }
+
   auto self = mkRef(const_cast<CSTableScanProvider*>(this));
-  auto task_factory = [self, node] (
-      Transaction* txn,
-      RowSinkFn output) -> RefPtr<Task> {
-    return new CSTableScan(
-        txn,
-        node,
-        self->cstable_file_,
-        txn->getRuntime()->queryBuilder().get(),
-        output);
-  };
-
-  auto task = new TaskDAGNode(new SimpleTableExpressionFactory(task_factory));
   TaskIDList output;
-  output.emplace_back(tasks->addTask(task));
+  for (size_t i = 0; i < num_partitions; ++i) {
+    auto begin = (total_records * i) / num_partitions;
+    auto end = (total_records * (i + 1)) / num_partitions;
+
+    auto task_factory = [self, node, num_partitions, begin, end] (
+        Transaction* txn,
+        RowSinkFn output) -> RefPtr<Task> {
+      auto scan = new CSTableScan(
+          txn,
+          node,
+          self->cstable_file_,
+          txn->getRuntime()->queryBuilder().get(),
+          output);
+
+      scan->setParallelism(
+          self->scan_parallelism_,
+          self->min_records_per_morsel_);
+      scan->setColumnStatsCache(self->column_stats_);
+
+      String cache_key;
+      if (!self->source_key_.isEmpty()) {
+        cache_key = StringUtil::format(
+            "$0~$1",
+            self->source_key_.get().toString(),
+            node->toString());
+      }
+
+      if (num_partitions > 1) {
+        scan->setRecordRange(begin, end);
+        cache_key += StringUtil::format("~$0-$1", begin, end);
+      }
+
+      if (!self->source_key_.isEmpty()) {
+        scan->setCacheKey(SHA1::compute(cache_key));
+      }
+
+      return scan;
+    };
+
+    auto task = new TaskDAGNode(new SimpleTableExpressionFactory(task_factory));
+    output.emplace_back(tasks->addTask(task));
+  }
+
   return output;
 }
 
@@ -56,6 +105,21 @@ TaskIDList CSTableScanProvider::buildSequentialScan(
 //      mkScoped(
 //}
 
+void CSTableScanProvider::setScanParallelism(
+    size_t max_threads,
+    size_t min_records_per_morsel /* = CSTableScan::kMinRecordsPerMorsel */) {
+  scan_parallelism_ = max_threads;
+  min_records_per_morsel_ = min_records_per_morsel;
+}
+
+void CSTableScanProvider::setColumnStatsFile(const String& filename) {
+  column_stats_->setSidecarFile(filename, cstable_file_);
+}
+
+void CSTableScanProvider::setCacheKey(const SHA1Hash& source_key) {
+  source_key_ = Some(source_key);
+}
+
 void CSTableScanProvider::listTables(
     Function<void (const csql::TableInfo& table)> fn) const {
   fn(tableInfo());
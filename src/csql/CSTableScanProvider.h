@@ -9,7 +9,10 @@
  */
 #pragma once
 #include <stx/stdtypes.h>
+#include <stx/SHA1.h>
 #include <csql/runtime/tablerepository.h>
+#include <csql/CSTableColumnStats.h>
+#include <csql/CSTableScan.h>
 #include <cstable/CSTableReader.h>
 
 using namespace stx;
@@ -35,9 +38,37 @@ public:
 
   csql::TableInfo tableInfo() const;
 
+  /**
+   * Scan each table with up to max_threads threads, see
+   * CSTableScan::setParallelism. Partitionable scans (see
+   * SequentialScanNode::isPartitionable) are split into up to max_threads
+   * tasks of at least min_records_per_morsel records each
+   */
+  void setScanParallelism(
+      size_t max_threads,
+      size_t min_records_per_morsel = CSTableScan::kMinRecordsPerMorsel);
+
+  /**
+   * Persist the per-block column stats of the cstable file in the provided
+   * sidecar file (e.g. "<cstable_file>.stats") instead of recomputing them on
+   * the first scan of every process, see CSTableColumnStatsCache
+   */
+  void setColumnStatsFile(const String& filename);
+
+  /**
+   * Mark the cstable file as immutable. Scans of this table then get a cache
+   * key derived from the provided source key and the scan's query tree, so
+   * their results can be reused from the runtime's cache dir
+   */
+  void setCacheKey(const SHA1Hash& source_key);
+
 protected:
   const String table_name_;
   const String cstable_file_;
+  size_t scan_parallelism_;
+  size_t min_records_per_morsel_;
+  Option<SHA1Hash> source_key_;
+  RefPtr<CSTableColumnStatsCache> column_stats_;
 };
 
 
@@ -13,11 +13,29 @@ using namespace stx;
 
 namespace csql {
 
-PureFunction::PureFunction() : call(nullptr) {}
+PureFunction::PureFunction() :
+    call(nullptr),
+    vcall(nullptr),
+    prepare(nullptr) {}
 
 PureFunction::PureFunction(
     void (*_call)(sql_txn* ctx, int argc, SValue* in, SValue* out)) :
-    call(_call) {}
+    call(_call),
+    vcall(nullptr),
+    prepare(nullptr) {}
+
+PureFunction::PureFunction(
+    void (*_call)(sql_txn* ctx, int argc, SValue* in, SValue* out),
+    void (*_vcall)(
+        sql_txn* ctx,
+        int argc,
+        const SValue** in,
+        size_t nrows,
+        SValue* out),
+    PreparedFunction* (*_prepare)(int argc, const SValue** literals)) :
+    call(_call),
+    vcall(_vcall),
+    prepare(_prepare) {}
 
 SFunction::SFunction() :
     type(FN_PURE),
@@ -24,13 +24,53 @@ enum kFunctionType {
   FN_AGGREGATE
 };
 
+/**
+ * A pure function that was specialized for a set of literal arguments (see
+ * PureFunction::prepare). It is called with the same arguments as the
+ * original function, including the literal ones
+ */
+class PreparedFunction {
+public:
+  virtual ~PreparedFunction() {}
+  virtual void call(sql_txn* ctx, int argc, SValue* in, SValue* out) = 0;
+};
+
 /**
  * A pure/stateless expression that returns a single return value
+ *
+ * The optional vcall method evaluates the function for a batch of rows. It
+ * receives one column buffer of nrows values per argument and writes nrows
+ * values to out
+ *
+ * The optional prepare method is called once at compile time for every call
+ * that has at least one literal argument. literals[i] points to the value of
+ * the i-th argument if it is a literal and is null otherwise. It may return
+ * a PreparedFunction that is called instead of the call method (the caller
+ * takes ownership) or null if it can't specialize the call. Batch evaluation
+ * still uses vcall for prepared calls if the function has one
  */
 struct PureFunction {
   PureFunction();
   PureFunction(void (*_call)(sql_txn* ctx, int argc, SValue* in, SValue* out));
+  PureFunction(
+      void (*_call)(sql_txn* ctx, int argc, SValue* in, SValue* out),
+      void (*_vcall)(
+          sql_txn* ctx,
+          int argc,
+          const SValue** in,
+          size_t nrows,
+          SValue* out),
+      PreparedFunction* (*_prepare)(int argc, const SValue** literals) =
+          nullptr);
+
   void (*call)(sql_txn* ctx, int argc, SValue* in, SValue* out);
+  void (*vcall)(
+      sql_txn* ctx,
+      int argc,
+      const SValue** in,
+      size_t nrows,
+      SValue* out);
+  PreparedFunction* (*prepare)(int argc, const SValue** literals);
 };
 
 /**
@@ -50,15 +50,31 @@ void installDefaultSymbols(SymbolTable* rt) {
   //    &expressions::maxExprFree);
 
   /* expressions/boolean.h */
-  rt->registerFunction("eq",  PureFunction(&expressions::eqExpr));
-  rt->registerFunction("neq", PureFunction(&expressions::neqExpr));
-  rt->registerFunction("logical_and", PureFunction(&expressions::andExpr));
-  rt->registerFunction("logical_or", PureFunction(&expressions::orExpr));
+  rt->registerFunction(
+      "eq",
+      PureFunction(&expressions::eqExpr, &expressions::eqExprBatch));
+  rt->registerFunction(
+      "neq",
+      PureFunction(&expressions::neqExpr, &expressions::neqExprBatch));
+  rt->registerFunction(
+      "logical_and",
+      PureFunction(&expressions::andExpr, &expressions::andExprBatch));
+  rt->registerFunction(
+      "logical_or",
+      PureFunction(&expressions::orExpr, &expressions::orExprBatch));
   rt->registerFunction("neg", PureFunction(&expressions::negExpr));
-  rt->registerFunction("lt",  PureFunction(&expressions::ltExpr));
-  rt->registerFunction("lte", PureFunction(&expressions::lteExpr));
-  rt->registerFunction("gt",  PureFunction(&expressions::gtExpr));
-  rt->registerFunction("gte", PureFunction(&expressions::gteExpr));
+  rt->registerFunction(
+      "lt",
+      PureFunction(&expressions::ltExpr, &expressions::ltExprBatch));
+  rt->registerFunction(
+      "lte",
+      PureFunction(&expressions::lteExpr, &expressions::lteExprBatch));
+  rt->registerFunction(
+      "gt",
+      PureFunction(&expressions::gtExpr, &expressions::gtExprBatch));
+  rt->registerFunction(
+      "gte",
+      PureFunction(&expressions::gteExpr, &expressions::gteExprBatch));
   rt->registerFunction("isnull", PureFunction(&expressions::isNullExpr));
 
   /* expressions/conversion.h */
@@ -80,19 +96,59 @@ void installDefaultSymbols(SymbolTable* rt) {
   rt->registerFunction("time_at", PureFunction(&expressions::timeAtExpr));
 
   /* expressions/math.h */
-  rt->registerFunction("add", PureFunction(&expressions::addExpr));
-  rt->registerFunction("sub", PureFunction(&expressions::subExpr));
-  rt->registerFunction("mul", PureFunction(&expressions::mulExpr));
-  rt->registerFunction("div", PureFunction(&expressions::divExpr));
+  rt->registerFunction(
+      "add",
+      PureFunction(
+          &expressions::addExpr,
+          &expressions::addExprBatch,
+          &expressions::addExprPrepare));
+  rt->registerFunction(
+      "sub",
+      PureFunction(
+          &expressions::subExpr,
+          &expressions::subExprBatch,
+          &expressions::subExprPrepare));
+  rt->registerFunction(
+      "mul",
+      PureFunction(
+          &expressions::mulExpr,
+          &expressions::mulExprBatch,
+          &expressions::mulExprPrepare));
+  rt->registerFunction(
+      "div",
+      PureFunction(
+          &expressions::divExpr,
+          &expressions::divExprBatch,
+          &expressions::divExprPrepare));
   rt->registerFunction("mod", PureFunction(&expressions::modExpr));
-  rt->registerFunction("pow", PureFunction(&expressions::powExpr));
+  rt->registerFunction(
+      "pow",
+      PureFunction(
+          &expressions::powExpr,
+          nullptr,
+          &expressions::powExprPrepare));
 
-  rt->registerFunction("round", PureFunction(&expressions::roundExpr));
+  rt->registerFunction(
+      "round",
+      PureFunction(
+          &expressions::roundExpr,
+          nullptr,
+          &expressions::roundExprPrepare));
   rt->registerFunction("truncate", PureFunction(&expressions::truncateExpr));
 
   /* expressions/string.h */
-  rt->registerFunction("startswith", PureFunction(&expressions::startsWithExpr));
-  rt->registerFunction("endswith", PureFunction(&expressions::endsWithExpr));
+  rt->registerFunction(
+      "startswith",
+      PureFunction(
+          &expressions::startsWithExpr,
+          nullptr,
+          &expressions::startsWithExprPrepare));
+  rt->registerFunction(
+      "endswith",
+      PureFunction(
+          &expressions::endsWithExpr,
+          nullptr,
+          &expressions::endsWithExprPrepare));
   rt->registerFunction("uppercase", PureFunction(&expressions::upperCaseExpr));
   rt->registerFunction("ucase", PureFunction(&expressions::upperCaseExpr));
   rt->registerFunction("lowercase", PureFunction(&expressions::lowerCaseExpr));
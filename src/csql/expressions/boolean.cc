@@ -406,5 +406,187 @@ void isNullExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   }
 }
 
+static void checkBatchArgs(const char* name, int argc) {
+  if (argc != 2) {
+    RAISE(
+        kRuntimeError,
+        "wrong number of arguments for %s. expected: 2, got: %i",
+        name,
+        argc);
+  }
+}
+
+void eqExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  checkBatchArgs("eq", argc);
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    if (lhs[i].isNumeric() && rhs[i].isNumeric()) {
+      out[i] = SValue::newBool(lhs[i].getFloat() == rhs[i].getFloat());
+    } else {
+      SValue args[2] = { lhs[i], rhs[i] };
+      eqExpr(ctx, 2, args, out + i);
+    }
+  }
+}
+
+void neqExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  eqExprBatch(ctx, argc, argv, nrows, out);
+  for (size_t i = 0; i < nrows; ++i) {
+    out[i] = SValue(!out[i].getValue<bool>());
+  }
+}
+
+void andExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  checkBatchArgs("AND", argc);
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    out[i] = SValue(lhs[i].getBool() && rhs[i].getBool());
+  }
+}
+
+void orExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  checkBatchArgs("or", argc);
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    out[i] = SValue(lhs[i].getBool() || rhs[i].getBool());
+  }
+}
+
+/**
+ * Applies a comparison operator to two column buffers. Integer/timestamp and
+ * float operands are compared inline with the same conversions as the scalar
+ * implementation; all other rows are handed to the scalar implementation
+ */
+template <typename CompareOp>
+static void compareBatch(
+    const char* name,
+    void (*scalar_fn)(sql_txn* ctx, int argc, SValue* argv, SValue* out),
+    CompareOp op,
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  checkBatchArgs(name, argc);
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    auto lhs_type = lhs[i].getType();
+    auto rhs_type = rhs[i].getType();
+    bool lhs_int = lhs_type == SQL_INTEGER || lhs_type == SQL_TIMESTAMP;
+    bool rhs_int = rhs_type == SQL_INTEGER || rhs_type == SQL_TIMESTAMP;
+
+    if (lhs_int && rhs_int) {
+      out[i] = SValue(op(lhs[i].getInteger(), rhs[i].getInteger()));
+      continue;
+    }
+
+    if ((lhs_int || lhs_type == SQL_FLOAT) &&
+        (rhs_int || rhs_type == SQL_FLOAT)) {
+      out[i] = SValue(op(lhs[i].getFloat(), rhs[i].getFloat()));
+      continue;
+    }
+
+    SValue args[2] = { lhs[i], rhs[i] };
+    scalar_fn(ctx, 2, args, out + i);
+  }
+}
+
+struct LessThan {
+  template <typename T> bool operator()(T a, T b) const { return a < b; }
+};
+
+struct LessThanOrEqual {
+  template <typename T> bool operator()(T a, T b) const { return a <= b; }
+};
+
+struct GreaterThan {
+  template <typename T> bool operator()(T a, T b) const { return a > b; }
+};
+
+struct GreaterThanOrEqual {
+  template <typename T> bool operator()(T a, T b) const { return a >= b; }
+};
+
+void ltExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  compareBatch("ltExpr", &ltExpr, LessThan(), ctx, argc, argv, nrows, out);
+}
+
+void lteExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  compareBatch(
+      "lteExpr",
+      &lteExpr,
+      LessThanOrEqual(),
+      ctx,
+      argc,
+      argv,
+      nrows,
+      out);
+}
+
+void gtExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  compareBatch("gtExpr", &gtExpr, GreaterThan(), ctx, argc, argv, nrows, out);
+}
+
+void gteExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  compareBatch(
+      "gteExpr",
+      &gteExpr,
+      GreaterThanOrEqual(),
+      ctx,
+      argc,
+      argv,
+      nrows,
+      out);
+}
+
+
 }
 }
@@ -26,6 +26,63 @@ void gtExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void gteExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void isNullExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 
+/* vectorized variants, see PureFunction::vcall */
+void eqExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void neqExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void andExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void orExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void ltExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void lteExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void gtExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void gteExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
 }
 }
 #endif
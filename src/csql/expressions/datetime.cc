@@ -134,11 +134,7 @@ void fromTimestamp(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   }
 }
 
-void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
-  checkArgs("DATE_TRUNC", argc, 2);
-
-  auto time_suffix = argv[0].getString();
-  uint64_t val = argv[1].getTimestamp().unixMicros();
+Option<uint64_t> parseTruncPrecision(String time_suffix) {
   unsigned long long dur = 1;
 
   if (StringUtil::isNumber(time_suffix.substr(0, 1))) {
@@ -147,14 +143,16 @@ void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
     time_suffix = time_suffix.substr(sz);
   }
 
+  if (dur == 0) {
+    return None<uint64_t>();
+  }
+
   if (time_suffix == "ms" ||
       time_suffix == "msec" ||
       time_suffix == "msecs" ||
       time_suffix == "millisecond" ||
       time_suffix == "milliseconds") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerMilli * dur)) * kMicrosPerMilli * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerMilli * dur);
   }
 
   if (time_suffix == "s" ||
@@ -162,9 +160,7 @@ void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
       time_suffix == "secs" ||
       time_suffix == "second" ||
       time_suffix == "seconds") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerSecond * dur)) * kMicrosPerSecond * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerSecond * dur);
   }
 
   if (time_suffix == "m" ||
@@ -172,153 +168,121 @@ void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
       time_suffix == "mins" ||
       time_suffix == "minute" ||
       time_suffix == "minutes") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerMinute * dur)) * kMicrosPerMinute * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerMinute * dur);
   }
 
   if (time_suffix == "h" ||
       time_suffix == "hour" ||
       time_suffix == "hours") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerHour * dur)) * kMicrosPerHour * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerHour * dur);
   }
 
   if (time_suffix == "d" ||
       time_suffix == "day" ||
       time_suffix == "days") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerDay * dur)) * kMicrosPerDay * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerDay * dur);
   }
 
   if (time_suffix == "w" ||
       time_suffix == "week" ||
       time_suffix == "weeks") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerWeek * dur)) * kMicrosPerWeek * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerWeek * dur);
   }
 
-  if (time_suffix == "m" ||
-      time_suffix == "month" ||
+  if (time_suffix == "month" ||
       time_suffix == "months") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerDay * 31 * dur)) * kMicrosPerDay * 31 * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerDay * 31 * dur);
   }
 
   if (time_suffix == "y" ||
       time_suffix == "year" ||
       time_suffix == "years") {
-    *out = SValue(SValue::TimeType(
-        (uint64_t(val) / (kMicrosPerYear * dur)) * kMicrosPerYear * dur));
-    return;
+    return Some<uint64_t>(kMicrosPerYear * dur);
   }
 
-  RAISE(
-      kRuntimeError,
-      "unknown time precision %s",
-      time_suffix.c_str());
+  return None<uint64_t>();
 }
 
-void dateAddExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
-  checkArgs("DATE_ADD", argc, 3);
+void dateTrunc(uint64_t precision, const SValue& time, SValue* out) {
+  uint64_t val = time.getTimestamp().unixMicros();
+  *out = SValue(SValue::TimeType((val / precision) * precision));
+}
 
-  SValue val = argv[0];
-  auto date = val.getTimestamp();
-  auto unit = argv[2].getString();
+void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
+  checkArgs("DATE_TRUNC", argc, 2);
+
+  auto time_suffix = argv[0].getString();
+  auto precision = parseTruncPrecision(time_suffix);
+  if (precision.isEmpty()) {
+    RAISE(
+        kRuntimeError,
+        "unknown time precision %s",
+        time_suffix.c_str());
+  }
+
+  dateTrunc(precision.get(), argv[1], out);
+}
+
+Option<uint64_t> parseDateAddUnit(String unit) {
   StringUtil::toLower(&unit);
 
   if (unit == "second") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerSecond)));
-      return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerSecond);
   }
 
   if (unit == "minute") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerMinute)));
-        return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerMinute);
   }
 
   if (unit == "hour") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerHour)));
-      return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerHour);
   }
 
   if (unit == "day") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerDay)));
-      return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerDay);
   }
 
   if (unit == "week") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerWeek)));
-      return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerWeek);
   }
 
   if (unit == "month") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerDay * 31)));
-      return;
-    }
-
-    RAISEF(
-        kRuntimeError,
-        "DATE_ADD: invalid expression $0 for unit $1",
-        argv[1].getString(),
-        argv[2].getString());
+    return Some<uint64_t>(kMicrosPerDay * 31);
   }
 
   if (unit == "year") {
-    if (argv[1].isConvertibleToNumeric()) {
-      *out = SValue(SValue::TimeType(
-          uint64_t(date) + (argv[1].getFloat() * kMicrosPerYear)));
+    return Some<uint64_t>(kMicrosPerYear);
+  }
+
+  return None<uint64_t>();
+}
+
+bool dateAdd(
+    uint64_t unit,
+    const SValue& date,
+    const SValue& amount,
+    SValue* out) {
+  auto time = date.getTimestamp();
+  if (!amount.isConvertibleToNumeric()) {
+    return false;
+  }
+
+  *out = SValue(SValue::TimeType(
+      uint64_t(time) + (amount.getFloat() * unit)));
+  return true;
+}
+
+void dateAddExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
+  checkArgs("DATE_ADD", argc, 3);
+
+  SValue val = argv[0];
+  auto date = val.getTimestamp();
+  auto unit = argv[2].getString();
+  StringUtil::toLower(&unit);
+
+  auto unit_micros = parseDateAddUnit(unit);
+  if (!unit_micros.isEmpty()) {
+    if (dateAdd(unit_micros.get(), val, argv[1], out)) {
       return;
     }
 
@@ -20,6 +20,29 @@ void nowExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void fromTimestamp(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void dateTruncExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void dateAddExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
+
+/**
+ * Returns the length in microseconds of a DATE_TRUNC precision like "5min" or
+ * "hour", or None if the precision is unknown
+ */
+Option<uint64_t> parseTruncPrecision(String precision);
+
+/**
+ * Returns the length in microseconds of a single field DATE_ADD unit like
+ * "second" or "day", or None for unknown and multi field units
+ */
+Option<uint64_t> parseDateAddUnit(String unit);
+
+/**
+ * DATE_TRUNC/DATE_ADD with a pre-resolved precision/unit. dateAdd returns
+ * false if the amount isn't numeric
+ */
+void dateTrunc(uint64_t precision, const SValue& time, SValue* out);
+bool dateAdd(
+    uint64_t unit,
+    const SValue& date,
+    const SValue& amount,
+    SValue* out);
 void dateSubExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void timeAtExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 
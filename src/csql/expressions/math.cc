@@ -198,22 +198,72 @@ void powExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   }
 }
 
+static double roundToPrecision(double value, double scale) {
+  return round(value * scale) / scale;
+}
+
 void roundExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
-  switch (argc) {
+  if (argc != 1 && argc != 2) {
+    RAISE(
+        kRuntimeError,
+        "wrong number of arguments for ROUND. expected: 1 or 2, got: %i", argc);
+  }
 
-    // round to integer
-    case 1:
-      RAISE(kNotYetImplementedError);
+  SValue* val = argv;
+  switch (val->getType()) {
+    case SQL_INTEGER:
+    case SQL_FLOAT:
+      break;
+    case SQL_NULL:
+      *out = SValue();
+      return;
+    default:
+      RAISE(kRuntimeError, "can't ROUND %s", val->getTypeName());
+  }
 
-    // round to arbitrary precision float
-    case 2:
-      RAISE(kNotYetImplementedError);
+  // round to integer
+  if (argc == 1) {
+    *out = SValue(SValue::IntegerType(round(val->getFloat())));
+    return;
+  }
 
-    default:
-      RAISE(
-          kRuntimeError,
-          "wrong number of arguments for ROUND. expected: 1 or 2, got: %i", argc);
+  // round to the specified number of decimal places
+  auto scale = pow(10.0, (double) argv[1].getInteger());
+  *out = SValue(SValue::FloatType(roundToPrecision(val->getFloat(), scale)));
+}
+
+/**
+ * ROUND with a literal number of decimal places: the scale is only computed
+ * once
+ */
+class PreparedRound : public PreparedFunction {
+public:
+
+  PreparedRound(int64_t precision) : scale_(pow(10.0, (double) precision)) {}
+
+  void call(sql_txn* ctx, int argc, SValue* argv, SValue* out) override {
+    switch (argv[0].getType()) {
+      case SQL_INTEGER:
+      case SQL_FLOAT:
+        *out = SValue(
+            SValue::FloatType(roundToPrecision(argv[0].getFloat(), scale_)));
+        return;
+      default:
+        roundExpr(ctx, argc, argv, out);
+        return;
+    }
   }
+
+protected:
+  double scale_;
+};
+
+PreparedFunction* roundExprPrepare(int argc, const SValue** literals) {
+  if (argc != 2 || literals[1] == nullptr) {
+    return nullptr;
+  }
+
+  return new PreparedRound(literals[1]->getInteger());
 }
 
 void truncateExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
@@ -246,6 +296,269 @@ void truncateExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   }
 }
 
+/**
+ * Binary arithmetic operator with one literal operand. The literal is
+ * converted to a number once. Rows where the other operand is an integer or
+ * float are computed inline; all other rows are handed to the scalar
+ * implementation. If integer_op is null, the result is always a float
+ */
+class PreparedArithmetic : public PreparedFunction {
+public:
+
+  PreparedArithmetic(
+      void (*scalar_fn)(sql_txn* ctx, int argc, SValue* argv, SValue* out),
+      int64_t (*integer_op)(int64_t a, int64_t b),
+      double (*float_op)(double a, double b),
+      size_t literal_idx,
+      const SValue& literal) :
+      scalar_fn_(scalar_fn),
+      integer_op_(integer_op),
+      float_op_(float_op),
+      literal_idx_(literal_idx),
+      literal_(literal.toNumeric()) {}
+
+  void call(sql_txn* ctx, int argc, SValue* argv, SValue* out) override {
+    if (argc != 2) {
+      scalar_fn_(ctx, argc, argv, out);
+      return;
+    }
+
+    const auto& val = argv[1 - literal_idx_];
+    const auto& lhs = literal_idx_ == 0 ? literal_ : val;
+    const auto& rhs = literal_idx_ == 0 ? val : literal_;
+
+    switch (val.getType()) {
+      case SQL_INTEGER:
+        if (integer_op_ && literal_.getType() == SQL_INTEGER) {
+          *out = SValue(
+              SValue::IntegerType(
+                  integer_op_(lhs.getInteger(), rhs.getInteger())));
+          return;
+        }
+        /* fallthrough */
+
+      case SQL_FLOAT:
+        *out = SValue(
+            SValue::FloatType(float_op_(lhs.getFloat(), rhs.getFloat())));
+        return;
+
+      default:
+        scalar_fn_(ctx, argc, argv, out);
+        return;
+    }
+  }
+
+protected:
+  void (*scalar_fn_)(sql_txn* ctx, int argc, SValue* argv, SValue* out);
+  int64_t (*integer_op_)(int64_t a, int64_t b);
+  double (*float_op_)(double a, double b);
+  size_t literal_idx_;
+  SValue literal_;
+};
+
+static PreparedFunction* prepareArithmetic(
+    void (*scalar_fn)(sql_txn* ctx, int argc, SValue* argv, SValue* out),
+    int64_t (*integer_op)(int64_t a, int64_t b),
+    double (*float_op)(double a, double b),
+    int argc,
+    const SValue** literals) {
+  if (argc != 2) {
+    return nullptr;
+  }
+
+  /* NULL and non-numeric literals are left to the scalar implementation */
+  for (size_t i = 0; i < 2; ++i) {
+    if (literals[i] &&
+        !literals[1 - i] &&
+        literals[i]->getType() != SQL_NULL &&
+        literals[i]->isConvertibleToNumeric()) {
+      return new PreparedArithmetic(
+          scalar_fn,
+          integer_op,
+          float_op,
+          i,
+          *literals[i]);
+    }
+  }
+
+  return nullptr;
+}
+
+PreparedFunction* addExprPrepare(int argc, const SValue** literals) {
+  return prepareArithmetic(
+      &addExpr,
+      [] (int64_t a, int64_t b) -> int64_t { return a + b; },
+      [] (double a, double b) -> double { return a + b; },
+      argc,
+      literals);
+}
+
+PreparedFunction* subExprPrepare(int argc, const SValue** literals) {
+  return prepareArithmetic(
+      &subExpr,
+      [] (int64_t a, int64_t b) -> int64_t { return a - b; },
+      [] (double a, double b) -> double { return a - b; },
+      argc,
+      literals);
+}
+
+PreparedFunction* mulExprPrepare(int argc, const SValue** literals) {
+  return prepareArithmetic(
+      &mulExpr,
+      [] (int64_t a, int64_t b) -> int64_t { return a * b; },
+      [] (double a, double b) -> double { return a * b; },
+      argc,
+      literals);
+}
+
+PreparedFunction* divExprPrepare(int argc, const SValue** literals) {
+  return prepareArithmetic(
+      &divExpr,
+      nullptr,
+      [] (double a, double b) -> double { return a / b; },
+      argc,
+      literals);
+}
+
+PreparedFunction* powExprPrepare(int argc, const SValue** literals) {
+  return prepareArithmetic(
+      &powExpr,
+      [] (int64_t a, int64_t b) -> int64_t {
+        return pow(a, b);
+      },
+      [] (double a, double b) -> double { return pow(a, b); },
+      argc,
+      literals);
+}
+
+/**
+ * Applies a binary arithmetic operator to two column buffers. Rows where both
+ * operands are integers or floats are computed inline; all other rows are
+ * handed to the scalar implementation
+ */
+template <typename IntegerOp, typename FloatOp>
+static void arithmeticBatch(
+    const char* name,
+    void (*scalar_fn)(sql_txn* ctx, int argc, SValue* argv, SValue* out),
+    IntegerOp integer_op,
+    FloatOp float_op,
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  if (argc != 2) {
+    RAISE(
+        kRuntimeError,
+        "wrong number of arguments for %s. expected: 2, got: %i",
+        name,
+        argc);
+  }
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    auto lhs_type = lhs[i].getType();
+    auto rhs_type = rhs[i].getType();
+
+    if (lhs_type == SQL_INTEGER && rhs_type == SQL_INTEGER) {
+      out[i] = SValue(
+          SValue::IntegerType(
+              integer_op(lhs[i].getInteger(), rhs[i].getInteger())));
+      continue;
+    }
+
+    if ((lhs_type == SQL_INTEGER || lhs_type == SQL_FLOAT) &&
+        (rhs_type == SQL_INTEGER || rhs_type == SQL_FLOAT)) {
+      out[i] = SValue(
+          SValue::FloatType(
+              float_op(lhs[i].getFloat(), rhs[i].getFloat())));
+      continue;
+    }
+
+    SValue args[2] = { lhs[i], rhs[i] };
+    scalar_fn(ctx, 2, args, out + i);
+  }
+}
+
+void addExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  arithmeticBatch(
+      "add",
+      &addExpr,
+      [] (int64_t a, int64_t b) { return a + b; },
+      [] (double a, double b) { return a + b; },
+      ctx,
+      argc,
+      argv,
+      nrows,
+      out);
+}
+
+void subExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  arithmeticBatch(
+      "sub",
+      &subExpr,
+      [] (int64_t a, int64_t b) { return a - b; },
+      [] (double a, double b) { return a - b; },
+      ctx,
+      argc,
+      argv,
+      nrows,
+      out);
+}
+
+void mulExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  arithmeticBatch(
+      "mul",
+      &mulExpr,
+      [] (int64_t a, int64_t b) { return a * b; },
+      [] (double a, double b) { return a * b; },
+      ctx,
+      argc,
+      argv,
+      nrows,
+      out);
+}
+
+void divExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out) {
+  if (argc != 2) {
+    RAISE(
+        kRuntimeError,
+        "wrong number of arguments for div. expected: 2, got: %i", argc);
+  }
+
+  auto lhs = argv[0];
+  auto rhs = argv[1];
+  for (size_t i = 0; i < nrows; ++i) {
+    if (lhs[i].isNumeric() && rhs[i].isNumeric()) {
+      out[i] = SValue(SValue::FloatType(lhs[i].getFloat() / rhs[i].getFloat()));
+    } else {
+      SValue args[2] = { lhs[i], rhs[i] };
+      divExpr(ctx, 2, args, out + i);
+    }
+  }
+}
+
 
 }
 }
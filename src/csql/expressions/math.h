@@ -10,6 +10,7 @@
 #ifndef _FNORDMETRIC_SQL_EXPRESSIONS_MATH_H
 #define _FNORDMETRIC_SQL_EXPRESSIONS_MATH_H
 #include <csql/svalue.h>
+#include <csql/SFunction.h>
 #include <csql/Transaction.h>
 
 namespace csql {
@@ -25,6 +26,43 @@ void powExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void roundExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 void truncateExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 
+/* literal argument specializations, see PureFunction::prepare */
+PreparedFunction* addExprPrepare(int argc, const SValue** literals);
+PreparedFunction* subExprPrepare(int argc, const SValue** literals);
+PreparedFunction* mulExprPrepare(int argc, const SValue** literals);
+PreparedFunction* divExprPrepare(int argc, const SValue** literals);
+PreparedFunction* powExprPrepare(int argc, const SValue** literals);
+PreparedFunction* roundExprPrepare(int argc, const SValue** literals);
+
+/* vectorized variants, see PureFunction::vcall */
+void addExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void subExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void mulExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
+void divExprBatch(
+    sql_txn* ctx,
+    int argc,
+    const SValue** argv,
+    size_t nrows,
+    SValue* out);
+
 }
 }
 #endif
@@ -7,6 +7,7 @@
  * copy of the GNU General Public License along with this program. If not, see
  * <http://www.gnu.org/licenses/>.
  */
+#include <string.h>
 #include <csql/expressions/string.h>
 #include <stx/stringutil.h>
 
@@ -38,6 +39,67 @@ void endsWithExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   *out = SValue(SValue::BoolType(val));
 }
 
+/**
+ * STARTSWITH/ENDSWITH with a literal pattern. String subjects are compared
+ * in place without copying them
+ */
+class PreparedAffixMatch : public PreparedFunction {
+public:
+
+  PreparedAffixMatch(
+      const char* symbol,
+      const String& affix,
+      bool suffix) :
+      symbol_(symbol),
+      affix_(affix),
+      suffix_(suffix) {}
+
+  void call(sql_txn* ctx, int argc, SValue* argv, SValue* out) override {
+    checkArgs(symbol_, argc, 2);
+
+    String str;
+    const char* data;
+    size_t size;
+    if (argv[0].getType() == SQL_STRING) {
+      data = argv[0].getStringData();
+      size = argv[0].getStringSize();
+    } else {
+      str = argv[0].getString();
+      data = str.data();
+      size = str.size();
+    }
+
+    bool val = false;
+    if (size >= affix_.size()) {
+      auto begin = suffix_ ? data + size - affix_.size() : data;
+      val = memcmp(begin, affix_.data(), affix_.size()) == 0;
+    }
+
+    *out = SValue(SValue::BoolType(val));
+  }
+
+protected:
+  const char* symbol_;
+  String affix_;
+  bool suffix_;
+};
+
+PreparedFunction* startsWithExprPrepare(int argc, const SValue** literals) {
+  if (argc != 2 || literals[1] == nullptr) {
+    return nullptr;
+  }
+
+  return new PreparedAffixMatch("STARTSWITH", literals[1]->getString(), false);
+}
+
+PreparedFunction* endsWithExprPrepare(int argc, const SValue** literals) {
+  if (argc != 2 || literals[1] == nullptr) {
+    return nullptr;
+  }
+
+  return new PreparedAffixMatch("ENDSWITH", literals[1]->getString(), true);
+}
+
 void upperCaseExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out) {
   checkArgs("UPPERCASE", argc, 1);
   auto val = argv[0].getString();
@@ -9,14 +9,17 @@
  */
 #pragma once
 #include <csql/svalue.h>
+#include <csql/SFunction.h>
 #include <csql/Transaction.h>
 
 namespace csql {
 namespace expressions {
 
 void startsWithExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
+PreparedFunction* startsWithExprPrepare(int argc, const SValue** literals);
 
 void endsWithExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
+PreparedFunction* endsWithExprPrepare(int argc, const SValue** literals);
 
 void upperCaseExpr(sql_txn* ctx, int argc, SValue* argv, SValue* out);
 
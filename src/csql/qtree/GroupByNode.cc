@@ -41,6 +41,11 @@ GroupByNode::GroupByNode(
     group_exprs_.emplace_back(e->deepCopyAs<ValueExpressionNode>());
   }
 
+  if (!other.having_expr_.isEmpty()) {
+    having_expr_ = Some(
+        other.having_expr_.get()->deepCopyAs<ValueExpressionNode>());
+  }
+
   addChild(&table_);
 }
 
@@ -87,8 +92,53 @@ Vector<TaskID> GroupByNode::build(Transaction* txn, TaskDAG* tree) const {
   auto input = table_.asInstanceOf<TableExpressionNode>()->build(txn, tree);
 
   TaskIDList output;
+
+  /* with more than one input task (e.g. a partitioned scan), aggregate each
+     input separately in a partial group by. the partial results are hash
+     partitioned by group key and each partition is merged by its own merge
+     task */
+  if (input.size() > 1) {
+    auto num_partitions = input.size();
+    Vector<TaskID> partial_tasks;
+    for (const auto& in_task_id : input) {
+      auto partial_task = mkRef(new TaskDAGNode(
+          new PartialGroupByFactory(
+              selectList(),
+              groupExpressions(),
+              havingExpression(),
+              num_partitions)));
+
+      TaskDAGNode::Dependency in_dep;
+      in_dep.task_id = in_task_id;
+      partial_task->addDependency(in_dep);
+      partial_tasks.emplace_back(tree->addTask(partial_task));
+    }
+
+    for (size_t i = 0; i < num_partitions; ++i) {
+      auto merge_task = mkRef(new TaskDAGNode(
+          new GroupByMergeFactory(
+              selectList(),
+              groupExpressions(),
+              havingExpression())));
+
+      for (const auto& partial_task_id : partial_tasks) {
+        TaskDAGNode::Dependency partial_dep;
+        partial_dep.task_id = partial_task_id;
+        partial_dep.partition = Some(i);
+        merge_task->addDependency(partial_dep);
+      }
+
+      output.emplace_back(tree->addTask(merge_task));
+    }
+
+    return output;
+  }
+
   auto out_task = mkRef(new TaskDAGNode(
-      new GroupByFactory(selectList(), groupExpressions())));
+      new GroupByFactory(
+          selectList(),
+          groupExpressions(),
+          havingExpression())));
   for (const auto& in_task_id : input) {
     TaskDAGNode::Dependency dep;
     dep.task_id = in_task_id;
@@ -103,6 +153,14 @@ Vector<RefPtr<ValueExpressionNode>> GroupByNode::groupExpressions() const {
   return group_exprs_;
 }
 
+Option<RefPtr<ValueExpressionNode>> GroupByNode::havingExpression() const {
+  return having_expr_;
+}
+
+void GroupByNode::setHavingExpression(RefPtr<ValueExpressionNode> expr) {
+  having_expr_ = Some(expr);
+}
+
 RefPtr<QueryTreeNode> GroupByNode::inputTable() const {
   return table_;
 }
@@ -123,7 +181,13 @@ String GroupByNode::toString() const {
     str += " " + e->toString();
   }
 
-  str += ") (subexpr " + table_->toString() + "))";
+  str += ")";
+
+  if (!having_expr_.isEmpty()) {
+    str += " (having " + having_expr_.get()->toString() + ")";
+  }
+
+  str += " (subexpr " + table_->toString() + "))";
 
   return str;
 }
@@ -35,6 +35,13 @@ public:
 
   Vector<RefPtr<ValueExpressionNode>> groupExpressions() const;
 
+  /**
+   * The HAVING expression is evaluated on the aggregated groups; groups for
+   * which it isn't true are not emitted
+   */
+  Option<RefPtr<ValueExpressionNode>> havingExpression() const;
+  void setHavingExpression(RefPtr<ValueExpressionNode> expr);
+
   RefPtr<QueryTreeNode> inputTable() const;
 
   RefPtr<QueryTreeNode> deepCopy() const override;
@@ -51,6 +58,7 @@ protected:
   Vector<RefPtr<SelectListNode>> select_list_;
   Vector<String> column_names_;
   Vector<RefPtr<ValueExpressionNode>> group_exprs_;
+  Option<RefPtr<ValueExpressionNode>> having_expr_;
   RefPtr<QueryTreeNode> table_;
 };
 
@@ -0,0 +1,170 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/qtree/GroupOverTimewindowNode.h>
+#include <csql/qtree/ColumnReferenceNode.h>
+#include <csql/qtree/OrderByNode.h>
+#include <csql/qtree/SubqueryNode.h>
+#include <csql/tasks/group_over_timewindow.h>
+
+using namespace stx;
+
+namespace csql {
+
+const char GroupOverTimewindowNode::kWindowStartColumn[] = "window_start";
+
+GroupOverTimewindowNode::GroupOverTimewindowNode(
+    Vector<RefPtr<SelectListNode>> select_list,
+    Vector<RefPtr<ValueExpressionNode>> group_exprs,
+    RefPtr<ValueExpressionNode> time_expr,
+    uint64_t window,
+    uint64_t step,
+    RefPtr<QueryTreeNode> table) :
+    GroupByNode(select_list, group_exprs, table),
+    time_expr_(time_expr),
+    window_(window),
+    step_(step) {}
+
+GroupOverTimewindowNode::GroupOverTimewindowNode(
+    const GroupOverTimewindowNode& other) :
+    GroupByNode(other),
+    time_expr_(other.time_expr_->deepCopyAs<ValueExpressionNode>()),
+    window_(other.window_),
+    step_(other.step_) {}
+
+RefPtr<ValueExpressionNode> GroupOverTimewindowNode::timeExpression() const {
+  return time_expr_;
+}
+
+uint64_t GroupOverTimewindowNode::window() const {
+  return window_;
+}
+
+uint64_t GroupOverTimewindowNode::step() const {
+  return step_;
+}
+
+static bool isOrderedBy(
+    RefPtr<QueryTreeNode> table,
+    RefPtr<ValueExpressionNode> expr) {
+  auto subquery = dynamic_cast<SubqueryNode*>(table.get());
+  if (subquery) {
+    auto colref = dynamic_cast<ColumnReferenceNode*>(expr.get());
+    if (!colref || !colref->hasColumnIndex()) {
+      return false;
+    }
+
+    auto select_list = subquery->selectList();
+    auto idx = colref->columnIndex();
+    if (idx >= select_list.size()) {
+      return false;
+    }
+
+    return isOrderedBy(subquery->subquery(), select_list[idx]->expression());
+  }
+
+  auto order_by = dynamic_cast<OrderByNode*>(table.get());
+  if (order_by) {
+    const auto& sort_specs = order_by->sortSpecs();
+    return
+        !sort_specs.empty() &&
+        !sort_specs[0].descending &&
+        sort_specs[0].expr->toSQL() == expr->toSQL();
+  }
+
+  return false;
+}
+
+bool GroupOverTimewindowNode::isInputOrdered() const {
+  return isOrderedBy(table_, time_expr_);
+}
+
+Vector<String> GroupOverTimewindowNode::outputColumns() const {
+  Vector<String> columns;
+  columns.emplace_back(kWindowStartColumn);
+  columns.insert(columns.end(), column_names_.begin(), column_names_.end());
+  return columns;
+}
+
+size_t GroupOverTimewindowNode::getColumnIndex(
+    const String& column_name,
+    bool allow_add /* = false */) {
+  if (column_name == kWindowStartColumn) {
+    return 0;
+  }
+
+  auto idx = GroupByNode::getColumnIndex(column_name, allow_add);
+  if (idx == size_t(-1)) {
+    return -1;
+  }
+
+  /* the select list starts after the window_start column */
+  return idx + 1;
+}
+
+Vector<TaskID> GroupOverTimewindowNode::build(
+    Transaction* txn,
+    TaskDAG* tree) const {
+  auto input = table_.asInstanceOf<TableExpressionNode>()->build(txn, tree);
+
+  /* all inputs go into a single task since the windows can only be emitted
+     in order of time */
+  auto out_task = mkRef(new TaskDAGNode(
+      new GroupOverTimewindowFactory(
+          selectList(),
+          groupExpressions(),
+          havingExpression(),
+          time_expr_,
+          window_,
+          step_,
+          input.size() == 1 && isInputOrdered())));
+
+  for (const auto& in_task_id : input) {
+    TaskDAGNode::Dependency dep;
+    dep.task_id = in_task_id;
+    out_task->addDependency(dep);
+  }
+
+  TaskIDList output;
+  output.emplace_back(tree->addTask(out_task));
+  return output;
+}
+
+RefPtr<QueryTreeNode> GroupOverTimewindowNode::deepCopy() const {
+  return new GroupOverTimewindowNode(*this);
+}
+
+String GroupOverTimewindowNode::toString() const {
+  String str = "(group-over-timewindow (select-list";
+
+  for (const auto& e : select_list_) {
+    str += " " + e->toString();
+  }
+
+  str += ") (group-list";
+  for (const auto& e : group_exprs_) {
+    str += " " + e->toString();
+  }
+
+  str += StringUtil::format(
+      ") (time $0) (window $1) (step $2)",
+      time_expr_->toString(),
+      window_,
+      step_);
+
+  if (!having_expr_.isEmpty()) {
+    str += " (having " + having_expr_.get()->toString() + ")";
+  }
+
+  str += " (subexpr " + table_->toString() + "))";
+
+  return str;
+}
+
+} // namespace csql
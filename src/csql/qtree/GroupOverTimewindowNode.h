@@ -0,0 +1,73 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <csql/qtree/GroupByNode.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * GROUP OVER TIMEWINDOW(time_expr, window, step) BY group_exprs: aggregates
+ * the input per time window and group. window and step are in microseconds.
+ * If the input is known to be in ascending order of the time expression (see
+ * isInputOrdered), windows are emitted as soon as they are complete.
+ *
+ * The start time of each window is returned as an implicit first column named
+ * window_start, followed by the select list
+ */
+class GroupOverTimewindowNode : public GroupByNode {
+public:
+
+  GroupOverTimewindowNode(
+      Vector<RefPtr<SelectListNode>> select_list,
+      Vector<RefPtr<ValueExpressionNode>> group_exprs,
+      RefPtr<ValueExpressionNode> time_expr,
+      uint64_t window,
+      uint64_t step,
+      RefPtr<QueryTreeNode> table);
+
+  GroupOverTimewindowNode(const GroupOverTimewindowNode& other);
+
+  RefPtr<ValueExpressionNode> timeExpression() const;
+
+  uint64_t window() const;
+
+  uint64_t step() const;
+
+  /**
+   * Returns true if the input table is an ORDER BY whose first sort key is
+   * the time expression in ascending order, possibly behind subqueries that
+   * pass the time column through
+   */
+  bool isInputOrdered() const;
+
+  Vector<String> outputColumns() const override;
+
+  size_t getColumnIndex(
+      const String& column_name,
+      bool allow_add = false) override;
+
+  RefPtr<QueryTreeNode> deepCopy() const override;
+
+  String toString() const override;
+
+  Vector<TaskID> build(Transaction* txn, TaskDAG* tree) const override;
+
+  static const char kWindowStartColumn[];
+
+protected:
+  RefPtr<ValueExpressionNode> time_expr_;
+  uint64_t window_;
+  uint64_t step_;
+};
+
+} // namespace csql
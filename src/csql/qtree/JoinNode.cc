@@ -11,6 +11,7 @@
 #include <csql/qtree/ColumnReferenceNode.h>
 #include <csql/qtree/QueryTreeUtil.h>
 #include <csql/tasks/nested_loop_join.h>
+#include <csql/tasks/hash_join.h>
 
 using namespace stx;
 
@@ -49,6 +50,13 @@ JoinNode::JoinNode(
     select_list_.emplace_back(e->deepCopyAs<SelectListNode>());
   }
 
+  for (const auto& k : other.equi_join_keys_) {
+    EquiJoinKey key;
+    key.base_key = k.base_key->deepCopyAs<ValueExpressionNode>();
+    key.joined_key = k.joined_key->deepCopyAs<ValueExpressionNode>();
+    equi_join_keys_.emplace_back(key);
+  }
+
   if (!other.where_expr_.isEmpty()) {
     where_expr_ = Some(
         other.where_expr_.get()->deepCopyAs<ValueExpressionNode>());
@@ -169,6 +177,14 @@ Option<RefPtr<ValueExpressionNode>> JoinNode::joinCondition() const {
   return join_cond_;
 }
 
+const Vector<JoinNode::EquiJoinKey>& JoinNode::equiJoinKeys() const {
+  return equi_join_keys_;
+}
+
+void JoinNode::setEquiJoinKeys(const Vector<EquiJoinKey>& keys) {
+  equi_join_keys_ = keys;
+}
+
 Vector<TaskID> JoinNode::build(Transaction* txn, TaskDAG* tree) const {
   auto base_table_tasks =
       base_table_.asInstanceOf<TableExpressionNode>()->build(txn, tree);
@@ -187,15 +203,31 @@ Vector<TaskID> JoinNode::build(Transaction* txn, TaskDAG* tree) const {
     joined_table_tasks_idset.emplace(task_id);
   }
 
-  auto out_task = mkRef(new TaskDAGNode(
-      new NestedLoopJoinFactory(
-          join_type_,
-          base_table_tasks_idset,
-          joined_table_tasks_idset,
-          input_map_,
-          selectList(),
-          joinCondition(),
-          whereExpression())));
+  TableExpressionFactoryRef join_factory;
+  if (join_type_ != JoinType::CARTESIAN && !equi_join_keys_.empty()) {
+    join_factory = mkRef<TaskFactory>(
+        new HashJoinFactory(
+            join_type_,
+            base_table_tasks_idset,
+            joined_table_tasks_idset,
+            input_map_,
+            selectList(),
+            equi_join_keys_,
+            joinCondition(),
+            whereExpression()));
+  } else {
+    join_factory = mkRef<TaskFactory>(
+        new NestedLoopJoinFactory(
+            join_type_,
+            base_table_tasks_idset,
+            joined_table_tasks_idset,
+            input_map_,
+            selectList(),
+            joinCondition(),
+            whereExpression()));
+  }
+
+  auto out_task = mkRef(new TaskDAGNode(join_factory));
 
   for (const auto& in_task_id : input_tasks_idset) {
     TaskDAGNode::Dependency dep;
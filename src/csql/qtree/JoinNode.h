@@ -32,6 +32,16 @@ public:
     size_t column_idx;
   };
 
+  /**
+   * A pair of expressions from an equality conjunct in the join condition
+   * where one side only references the base table and the other side only
+   * references the joined table
+   */
+  struct EquiJoinKey {
+    RefPtr<ValueExpressionNode> base_key;
+    RefPtr<ValueExpressionNode> joined_key;
+  };
+
   JoinNode(
       JoinType join_type,
       RefPtr<QueryTreeNode> base_table,
@@ -66,6 +76,12 @@ public:
   Option<RefPtr<ValueExpressionNode>> whereExpression() const;
   Option<RefPtr<ValueExpressionNode>> joinCondition() const;
 
+  /**
+   * If the join keys are non-empty, the join is executed as a hash join
+   */
+  const Vector<EquiJoinKey>& equiJoinKeys() const;
+  void setEquiJoinKeys(const Vector<EquiJoinKey>& keys);
+
   RefPtr<QueryTreeNode> deepCopy() const override;
 
   String toString() const override;
@@ -83,6 +99,7 @@ protected:
   Vector<RefPtr<SelectListNode>> select_list_;
   Option<RefPtr<ValueExpressionNode>> where_expr_;
   Option<RefPtr<ValueExpressionNode>> join_cond_;
+  Vector<EquiJoinKey> equi_join_keys_;
 };
 
 } // namespace csql
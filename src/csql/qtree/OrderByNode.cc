@@ -9,6 +9,7 @@
  */
 #include <csql/qtree/OrderByNode.h>
 #include <csql/tasks/orderby.h>
+#include <csql/tasks/topn.h>
 
 using namespace stx;
 
@@ -18,6 +19,7 @@ OrderByNode::OrderByNode(
     Vector<SortSpec> sort_specs,
     RefPtr<QueryTreeNode> table) :
     sort_specs_(sort_specs),
+    offset_(0),
     table_(table) {
   addChild(&table_);
 }
@@ -55,7 +57,15 @@ TaskIDList OrderByNode::build(Transaction* txn, TaskDAG* tree) const {
   }
 
   TaskIDList output;
-  auto out_task = mkRef(new TaskDAGNode(new OrderByFactory(sort_exprs, ncols)));
+  TableExpressionFactoryRef factory;
+  if (limit_.isEmpty()) {
+    factory = mkRef<TaskFactory>(new OrderByFactory(sort_exprs, ncols));
+  } else {
+    factory = mkRef<TaskFactory>(
+        new TopNFactory(sort_exprs, limit_.get(), offset_));
+  }
+
+  auto out_task = mkRef(new TaskDAGNode(factory));
   for (const auto& in_task_id : input) {
     TaskDAGNode::Dependency dep;
     dep.task_id = in_task_id;
@@ -70,10 +80,29 @@ const Vector<OrderByNode::SortSpec>& OrderByNode::sortSpecs() const {
   return sort_specs_;
 }
 
+void OrderByNode::setLimit(size_t limit, size_t offset /* = 0 */) {
+  limit_ = Some(limit);
+  offset_ = offset;
+}
+
+Option<size_t> OrderByNode::limit() const {
+  return limit_;
+}
+
+size_t OrderByNode::offset() const {
+  return offset_;
+}
+
 RefPtr<QueryTreeNode> OrderByNode::deepCopy() const {
-  return new OrderByNode(
+  auto copy = new OrderByNode(
       sort_specs_,
       table_->deepCopy().asInstanceOf<QueryTreeNode>());
+
+  if (!limit_.isEmpty()) {
+    copy->setLimit(limit_.get(), offset_);
+  }
+
+  return copy;
 }
 
 String OrderByNode::toString() const {
@@ -85,6 +114,10 @@ String OrderByNode::toString() const {
         spec.descending ? "DESC" : "ASC");
   }
 
+  if (!limit_.isEmpty()) {
+    str += StringUtil::format(" (limit $0 $1)", limit_.get(), offset_);
+  }
+
   str += " (subexpr " + table_->toString() + "))";
 
   return str;
@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <stx/stdtypes.h>
+#include <stx/option.h>
 #include <csql/qtree/TableExpressionNode.h>
 #include <csql/qtree/ValueExpressionNode.h>
 
@@ -36,6 +37,14 @@ public:
 
   const Vector<SortSpec>& sortSpecs() const;
 
+  /**
+   * Only return the rows in [offset, offset + limit) of the sorted result. If
+   * a limit is set, the node is executed as a bounded Top-N sort
+   */
+  void setLimit(size_t limit, size_t offset = 0);
+  Option<size_t> limit() const;
+  size_t offset() const;
+
   RefPtr<QueryTreeNode> deepCopy() const override;
 
   String toString() const override;
@@ -48,6 +57,8 @@ public:
 
 protected:
   Vector<SortSpec> sort_specs_;
+  Option<size_t> limit_;
+  size_t offset_;
   size_t max_output_column_index_;
   RefPtr<QueryTreeNode> table_;
 };
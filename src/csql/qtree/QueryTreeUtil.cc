@@ -10,6 +10,11 @@
 #include <csql/runtime/runtime.h>
 #include <csql/qtree/QueryTreeUtil.h>
 #include <csql/qtree/ColumnReferenceNode.h>
+#include <csql/qtree/CallExpressionNode.h>
+#include <csql/qtree/IfExpressionNode.h>
+#include <csql/qtree/LikeExpressionNode.h>
+#include <csql/qtree/LiteralExpressionNode.h>
+#include <csql/qtree/RegexExpressionNode.h>
 #include <stx/logging.h>
 
 using namespace stx;
@@ -247,4 +252,200 @@ Option<ScanConstraint> QueryTreeUtil::findConstraint(
   return None<ScanConstraint>();
 }
 
+struct SharedExpressionState {
+  Transaction* txn;
+  size_t input_width;
+  HashMap<String, size_t> counts;
+  HashMap<String, size_t> slots;
+  Vector<RefPtr<ValueExpressionNode>> shared;
+};
+
+static bool isLogicalOperator(ValueExpressionNode* expr) {
+  auto call_expr = dynamic_cast<CallExpressionNode*>(expr);
+  return call_expr && (
+      call_expr->symbol() == "logical_and" ||
+      call_expr->symbol() == "logical_or");
+}
+
+/**
+ * Returns the arguments of the provided expression that are evaluated
+ * whenever the expression itself is evaluated
+ */
+static Vector<RefPtr<ValueExpressionNode>> unconditionalArguments(
+    RefPtr<ValueExpressionNode> expr) {
+  auto if_expr = dynamic_cast<IfExpressionNode*>(expr.get());
+  if (if_expr) {
+    return Vector<RefPtr<ValueExpressionNode>> { if_expr->conditional() };
+  }
+
+  if (isLogicalOperator(expr.get())) {
+    return Vector<RefPtr<ValueExpressionNode>>{};
+  }
+
+  return expr->arguments();
+}
+
+static void inspectSubexpressions(
+    Transaction* txn,
+    RefPtr<ValueExpressionNode> expr,
+    bool* has_column,
+    bool* has_aggregate) {
+  if (dynamic_cast<ColumnReferenceNode*>(expr.get())) {
+    *has_column = true;
+  }
+
+  auto call_expr = dynamic_cast<CallExpressionNode*>(expr.get());
+  if (call_expr) {
+    auto symbol = txn->getSymbolTable()->lookup(call_expr->symbol());
+    if (symbol.isAggregate()) {
+      *has_aggregate = true;
+    }
+  }
+
+  for (const auto& arg : expr->arguments()) {
+    inspectSubexpressions(txn, arg, has_column, has_aggregate);
+  }
+}
+
+/**
+ * An expression can be shared if it computes something from at least one
+ * input column and doesn't contain an aggregate function
+ */
+static bool isShareableExpression(
+    Transaction* txn,
+    RefPtr<ValueExpressionNode> expr) {
+  if (dynamic_cast<ColumnReferenceNode*>(expr.get()) ||
+      dynamic_cast<LiteralExpressionNode*>(expr.get())) {
+    return false;
+  }
+
+  bool has_column = false;
+  bool has_aggregate = false;
+  inspectSubexpressions(txn, expr, &has_column, &has_aggregate);
+  return has_column && !has_aggregate;
+}
+
+static void countSubexpressions(
+    RefPtr<ValueExpressionNode> expr,
+    SharedExpressionState* state) {
+  if (isShareableExpression(state->txn, expr)) {
+    ++state->counts[expr->toSQL()];
+  }
+
+  for (const auto& arg : unconditionalArguments(expr)) {
+    countSubexpressions(arg, state);
+  }
+}
+
+static RefPtr<ValueExpressionNode> rewriteSharedExpression(
+    RefPtr<ValueExpressionNode> expr,
+    SharedExpressionState* state);
+
+static RefPtr<ValueExpressionNode> rewriteSharedArguments(
+    RefPtr<ValueExpressionNode> expr,
+    SharedExpressionState* state) {
+  auto if_expr = dynamic_cast<IfExpressionNode*>(expr.get());
+  if (if_expr) {
+    return new IfExpressionNode(
+        rewriteSharedExpression(if_expr->conditional(), state),
+        if_expr->trueBranch(),
+        if_expr->falseBranch());
+  }
+
+  if (isLogicalOperator(expr.get())) {
+    return expr;
+  }
+
+  auto call_expr = dynamic_cast<CallExpressionNode*>(expr.get());
+  if (call_expr) {
+    Vector<RefPtr<ValueExpressionNode>> args;
+    for (const auto& arg : call_expr->arguments()) {
+      args.emplace_back(rewriteSharedExpression(arg, state));
+    }
+
+    return new CallExpressionNode(call_expr->symbol(), args);
+  }
+
+  auto regex_expr = dynamic_cast<RegexExpressionNode*>(expr.get());
+  if (regex_expr) {
+    return new RegexExpressionNode(
+        rewriteSharedExpression(regex_expr->subject(), state),
+        regex_expr->pattern());
+  }
+
+  auto like_expr = dynamic_cast<LikeExpressionNode*>(expr.get());
+  if (like_expr) {
+    return new LikeExpressionNode(
+        rewriteSharedExpression(like_expr->subject(), state),
+        like_expr->pattern());
+  }
+
+  return expr;
+}
+
+static RefPtr<ValueExpressionNode> rewriteSharedExpression(
+    RefPtr<ValueExpressionNode> expr,
+    SharedExpressionState* state) {
+  if (!isShareableExpression(state->txn, expr)) {
+    return rewriteSharedArguments(expr, state);
+  }
+
+  auto key = expr->toSQL();
+  if (state->counts[key] < 2) {
+    return rewriteSharedArguments(expr, state);
+  }
+
+  auto slot = state->slots.find(key);
+  if (slot == state->slots.end()) {
+    /* nested shared expressions get the lower slots */
+    auto shared_expr = rewriteSharedArguments(expr, state);
+    slot = state->slots.emplace(key, state->shared.size()).first;
+    state->shared.emplace_back(shared_expr);
+  }
+
+  return new ColumnReferenceNode(state->input_width + slot->second);
+}
+
+Vector<RefPtr<ValueExpressionNode>> QueryTreeUtil::extractSharedExpressions(
+    Transaction* txn,
+    Vector<RefPtr<ValueExpressionNode>>* exprs,
+    size_t* input_width,
+    Vector<size_t>* num_required) {
+  SharedExpressionState state;
+  state.txn = txn;
+  state.input_width = 0;
+
+  bool resolved = true;
+  for (const auto& e : *exprs) {
+    findColumns(e, [&] (const RefPtr<ColumnReferenceNode>& col) {
+      if (!col->hasColumnIndex()) {
+        resolved = false;
+        return;
+      }
+
+      auto idx = col->columnIndex();
+      if (idx != size_t(-1)) {
+        state.input_width = std::max(state.input_width, idx + 1);
+      }
+    });
+  }
+
+  *input_width = state.input_width;
+  num_required->assign(exprs->size(), 0);
+  if (!resolved) {
+    return state.shared;
+  }
+
+  for (const auto& e : *exprs) {
+    countSubexpressions(e, &state);
+  }
+
+  for (size_t i = 0; i < exprs->size(); ++i) {
+    (*exprs)[i] = rewriteSharedExpression((*exprs)[i], &state);
+    (*num_required)[i] = state.shared.size();
+  }
+
+  return state.shared;
+}
+
 } // namespace csql
@@ -94,6 +94,31 @@ public:
    */
   static Option<ScanConstraint> findConstraint(
       RefPtr<ValueExpressionNode> expr);
+
+  /**
+   * Finds the subexpressions that occur more than once in the provided
+   * expressions (which must all be evaluated against the same input row) and
+   * replaces every occurrence with a reference to a new input column.
+   *
+   * Returns the shared expressions in evaluation order. The n-th shared
+   * expression is referenced as column input_width + n, where input_width is
+   * one more than the largest column index referenced by the provided
+   * expressions. A shared expression may reference the shared expressions
+   * before it. num_required[i] is set to the number of shared expressions
+   * that must be evaluated before the i-th expression can be evaluated.
+   *
+   * Subexpressions that are only evaluated conditionally (the branches of an
+   * IF and the operands of AND/OR) are never shared so that no expression is
+   * evaluated for more rows than before.
+   *
+   * This method does not modify the provided expression trees but replaces
+   * them with rewritten copies
+   */
+  static Vector<RefPtr<ValueExpressionNode>> extractSharedExpressions(
+      Transaction* txn,
+      Vector<RefPtr<ValueExpressionNode>>* exprs,
+      size_t* input_width,
+      Vector<size_t>* num_required);
 };
 
 
@@ -50,7 +50,8 @@ SequentialScanNode::SequentialScanNode(
     table_provider_(table_provider),
     select_list_(select_list),
     where_expr_(where_expr),
-    aggr_strategy_(aggr_strategy) {
+    aggr_strategy_(aggr_strategy),
+    partitionable_(false) {
   for (const auto& col : table_info.columns) {
     table_columns_.emplace_back(col.column_name);
   }
@@ -65,7 +66,9 @@ SequentialScanNode::SequentialScanNode(
     table_name_(other.table_name_),
     output_columns_(other.output_columns_),
     aggr_strategy_(other.aggr_strategy_),
-    constraints_(other.constraints_) {
+    constraints_(other.constraints_),
+    limit_(other.limit_),
+    partitionable_(other.partitionable_) {
   for (const auto& e : other.select_list_) {
     select_list_.emplace_back(e->deepCopyAs<SelectListNode>());
   }
@@ -224,13 +227,37 @@ void SequentialScanNode::setAggregationStrategy(AggregationStrategy strategy) {
   aggr_strategy_ = strategy;
 }
 
+Option<size_t> SequentialScanNode::limit() const {
+  return limit_;
+}
+
+void SequentialScanNode::setLimit(size_t limit) {
+  limit_ = Some(limit);
+}
+
+bool SequentialScanNode::isPartitionable() const {
+  return partitionable_;
+}
+
+void SequentialScanNode::setPartitionable(bool partitionable) {
+  partitionable_ = partitionable;
+}
+
 Vector<TaskID> SequentialScanNode::build(
     Transaction* txn,
     TaskDAG* tree) const {
-  return table_provider_->buildSequentialScan(
+  Vector<TaskID> task_ids;
+  if (tree->getNodeTasks(this, &task_ids)) {
+    return task_ids;
+  }
+
+  task_ids = table_provider_->buildSequentialScan(
       txn,
       mkRef(const_cast<SequentialScanNode*>(this)),
       tree);
+
+  tree->setNodeTasks(this, task_ids);
+  return task_ids;
 }
 
 RefPtr<QueryTreeNode> SequentialScanNode::deepCopy() const {
@@ -273,6 +300,14 @@ String SequentialScanNode::toString() const {
     str += StringUtil::format(" (where $0)", where_expr_.get()->toString());
   }
 
+  if (!limit_.isEmpty()) {
+    str += StringUtil::format(" (limit $0)", limit_.get());
+  }
+
+  if (partitionable_) {
+    str += " (partitionable)";
+  }
+
   str += ")";
   return str;
 }
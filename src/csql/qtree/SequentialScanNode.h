@@ -127,6 +127,22 @@ public:
   AggregationStrategy aggregationStrategy() const;
   void setAggregationStrategy(AggregationStrategy strategy);
 
+  /**
+   * Returns the maximum number of rows the scan has to produce if a LIMIT
+   * (without ORDER BY) was pushed down into the scan
+   */
+  Option<size_t> limit() const;
+  void setLimit(size_t limit);
+
+  /**
+   * Returns true if the consumer of the scan depends neither on the order of
+   * the rows nor on receiving them from a single task. The storage engine may
+   * then split the scan into several tasks that each return a subset of the
+   * rows (e.g. for the partial aggregations of a GroupByNode)
+   */
+  bool isPartitionable() const;
+  void setPartitionable(bool partitionable);
+
   RefPtr<QueryTreeNode> deepCopy() const override;
 
   String toString() const override;
@@ -148,6 +164,8 @@ protected:
   Option<RefPtr<ValueExpressionNode>> where_expr_;
   AggregationStrategy aggr_strategy_;
   Vector<ScanConstraint> constraints_;
+  Option<size_t> limit_;
+  bool partitionable_;
 };
 
 } // namespace csql
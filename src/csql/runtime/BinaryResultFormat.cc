@@ -8,14 +8,22 @@
  * copy of the GNU General Public License along with this program. If not, see
  * <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
 #include <csql/runtime/BinaryResultFormat.h>
 #include <stx/logging.h>
+#include <stx/io/outputstream.h>
 
 namespace csql {
 
 BinaryResultFormat::BinaryResultFormat(
-    WriteCallback write_cb) :
-    write_cb_(write_cb) {
+    WriteCallback write_cb,
+    BinaryResultEncoding encoding,
+    size_t batch_size) :
+    write_cb_(write_cb),
+    encoding_(encoding),
+    batch_size_(std::max(batch_size, size_t(1))),
+    batch_rows_(0),
+    batch_cols_(0) {
   sendHeader();
 }
 
@@ -57,16 +65,40 @@ void BinaryResultFormat::formatResults(
   });
 
   try {
-    for (int i = 0; i < query->numStatements(); ++i) {
-      auto stmt = query->getStatement(i);
+    /* the rows of the first statement are sent as they are produced. the rows
+       of different tables can't be interleaved, so the rows of all other
+       statements are buffered until the query is complete */
+    Vector<Vector<Vector<SValue>>> buffered(query->numStatements());
+    for (size_t i = 0; i < query->numStatements(); ++i) {
+      if (i == 0) {
+        sendTableHeader(query->getStatementOutputColumns(i));
+        query->onOutputRow(
+            i,
+            [this] (const SValue* argv, int argc) -> bool {
+          sendRow(argc, argv);
+          return true;
+        });
+      } else {
+        auto rows = &buffered[i];
+        query->onOutputRow(
+            i,
+            [rows] (const SValue* argv, int argc) -> bool {
+          rows->emplace_back(argv, argv + argc);
+          return true;
+        });
+      }
+    }
+
+    query->execute();
+    flushBatch();
 
-      auto table_expr = dynamic_cast<TableExpression*>(stmt);
-      if (table_expr) {
-        sendTable(table_expr, context);
-        continue;
+    for (size_t i = 1; i < query->numStatements(); ++i) {
+      sendTableHeader(query->getStatementOutputColumns(i));
+      for (const auto& row : buffered[i]) {
+        sendRow(row.size(), row.data());
       }
 
-      RAISE(kRuntimeError, "can't render DRAW statement in BinaryFormat")
+      flushBatch();
     }
   } catch (const StandardException& e) {
     stx::logError("sql", e, "SQL execution failed");
@@ -74,38 +106,124 @@ void BinaryResultFormat::formatResults(
   }
 }
 
-void BinaryResultFormat::sendTable(
-    TableExpression* stmt,
-    ExecutionContext* context) {
+void BinaryResultFormat::sendTableHeader(const Vector<String>& columns) {
+  stx::util::BinaryMessageWriter writer;
+  writer.appendUInt8(0xf1);
+  writer.appendVarUInt(columns.size());
+  for (const auto& col : columns) {
+    writer.appendLenencString(col);
+  }
 
-  // table header
-  {
-    stx::util::BinaryMessageWriter writer;
-    writer.appendUInt8(0xf1);
+  write_cb_(writer.data(), writer.size());
+}
 
-    auto columns = stmt->columnNames();
-    writer.appendVarUInt(columns.size());
-    for (const auto& col : columns) {
-      writer.appendLenencString(col);
+void BinaryResultFormat::sendRow(int argc, const SValue* argv) {
+  if (encoding_ == BinaryResultEncoding::ROWS) {
+    frame_buf_.clear();
+    auto writer = StringOutputStream::fromString(&frame_buf_);
+    writer->appendUInt8(0xf2);
+    writer->appendVarUInt(argc);
+    for (int n = 0; n < argc; ++n) {
+      argv[n].encode(writer.get());
     }
 
-    write_cb_(writer.data(), writer.size());
+    write_cb_(&frame_buf_[0], frame_buf_.size());
+    return;
   }
 
-  stmt->execute(
-      context,
-      [this] (int argc, const csql::SValue* argv) -> bool {
-    Buffer buf;
-    BufferOutputStream writer(&buf);
-    writer.appendUInt8(0xf2);
-    writer.appendVarUInt(argc);
-    for (int n = 0; n < argc; ++n) {
-      argv[n].encode(&writer);
+  if (batch_rows_ > 0 && argc != batch_cols_) {
+    flushBatch();
+  }
+
+  batch_cols_ = argc;
+  batch_.insert(batch_.end(), argv, argv + argc);
+  if (++batch_rows_ >= batch_size_) {
+    flushBatch();
+  }
+}
+
+void BinaryResultFormat::flushBatch() {
+  if (batch_rows_ == 0) {
+    return;
+  }
+
+  body_buf_.clear();
+  auto body = StringOutputStream::fromString(&body_buf_);
+  uint8_t evtype;
+  switch (encoding_) {
+    case BinaryResultEncoding::ROW_BATCHES:
+      evtype = 0xf5;
+      encodeRowBatch(body.get());
+      break;
+    case BinaryResultEncoding::COLUMN_BATCHES:
+      evtype = 0xf6;
+      encodeColumnBatch(body.get());
+      break;
+    default:
+      RAISE(kIllegalStateError, "invalid batch encoding");
+  }
+
+  frame_buf_.clear();
+  auto writer = StringOutputStream::fromString(&frame_buf_);
+  writer->appendUInt8(evtype);
+  writer->appendVarUInt(batch_rows_);
+  writer->appendVarUInt(batch_cols_);
+  writer->appendVarUInt(body_buf_.size());
+  frame_buf_.append(body_buf_);
+
+  write_cb_(&frame_buf_[0], frame_buf_.size());
+
+  batch_.clear();
+  batch_rows_ = 0;
+}
+
+void BinaryResultFormat::encodeRowBatch(OutputStream* os) {
+  for (const auto& v : batch_) {
+    v.encode(os);
+  }
+}
+
+void BinaryResultFormat::encodeColumnBatch(OutputStream* os) {
+  for (size_t col = 0; col < batch_cols_; ++col) {
+    auto type = batch_[col].getType();
+    for (size_t row = 1; row < batch_rows_; ++row) {
+      if (batch_[row * batch_cols_ + col].getType() != type) {
+        type = sql_type(0xff);
+        break;
+      }
     }
 
-    write_cb_(buf.data(), buf.size());
-    return true;
-  });
+    /* NULL values are encoded with their type byte so that every value
+       takes at least one byte */
+    if (type == SQL_NULL) {
+      type = sql_type(0xff);
+    }
+
+    os->appendUInt8(type);
+    for (size_t row = 0; row < batch_rows_; ++row) {
+      const auto& v = batch_[row * batch_cols_ + col];
+      switch (type) {
+        case SQL_STRING:
+          os->appendLenencString(v.getStringData(), v.getStringSize());
+          break;
+        case SQL_FLOAT:
+          os->appendDouble(v.getFloat());
+          break;
+        case SQL_INTEGER:
+          os->appendUInt64(v.getInteger());
+          break;
+        case SQL_BOOL:
+          os->appendUInt8(v.getBool() ? 1 : 0);
+          break;
+        case SQL_TIMESTAMP:
+          os->appendUInt64(v.getTimestamp().unixMicros());
+          break;
+        default:
+          v.encode(os);
+          break;
+      }
+    }
+  }
 }
 
 }
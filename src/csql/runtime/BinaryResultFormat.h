@@ -46,17 +46,56 @@
  *       %0xf4
  *       <lenenc_str>               // error message
  *
+ *   <row_batch_event> :=
+ *       %0xf5
+ *       <lenenc_int>               // number of rows
+ *       <lenenc_int>               // number of fields per row
+ *       <lenenc_int>               // size of the row data in bytes
+ *       <svalue>*                  // svalues, row by row
+ *
+ *   <column_batch_event> :=
+ *       %0xf6
+ *       <lenenc_int>               // number of rows
+ *       <lenenc_int>               // number of columns
+ *       <lenenc_int>               // size of the column data in bytes
+ *       <column>*
+ *
+ *   <column> :=
+ *       <uint8> <value>*           // all values have the sql_type given by
+ *                                  // the first byte; values are encoded
+ *                                  // like svalues without the type byte
+ *     / %0xff <svalue>*            // values of mixed types or NULLs
+ *
+ *   Every value of a batch is encoded with at least one byte, so the number
+ *   of rows times the number of fields never exceeds the size of the data.
+ *
  *   <footer>
  *       %0xff
  *
  */
 namespace csql {
 
+enum class BinaryResultEncoding {
+  ROWS, // one row_event per row
+  ROW_BATCHES, // one row_batch_event per batch of rows
+  COLUMN_BATCHES // one column_batch_event per batch of rows
+};
+
 class BinaryResultFormat : public ResultFormat {
 public:
   typedef Function<void (void* data, size_t size)> WriteCallback;
 
-  BinaryResultFormat(WriteCallback write_cb);
+  static const size_t kDefaultBatchSize = 1024;
+
+  /**
+   * In the batch encodings, up to batch_size rows are buffered and sent to
+   * the write callback in a single event
+   */
+  BinaryResultFormat(
+      WriteCallback write_cb,
+      BinaryResultEncoding encoding = BinaryResultEncoding::ROWS,
+      size_t batch_size = kDefaultBatchSize);
+
   ~BinaryResultFormat();
 
   void formatResults(
@@ -72,11 +111,21 @@ protected:
   void sendHeader();
   void sendFooter();
 
-  void sendTable(
-      TableExpression* stmt,
-      ExecutionContext* context);
+  void sendTableHeader(const Vector<String>& columns);
+
+  void sendRow(int argc, const SValue* argv);
+  void flushBatch();
+  void encodeRowBatch(OutputStream* os);
+  void encodeColumnBatch(OutputStream* os);
 
   WriteCallback write_cb_;
+  BinaryResultEncoding encoding_;
+  size_t batch_size_;
+  Vector<SValue> batch_;
+  size_t batch_rows_;
+  size_t batch_cols_;
+  String body_buf_;
+  String frame_buf_;
 };
 
 }
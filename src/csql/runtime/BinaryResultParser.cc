@@ -29,6 +29,14 @@ void BinaryResultParser::onRow(
   on_row_ = fn;
 }
 
+void BinaryResultParser::onRowBlock(
+    stx::Function<void (
+        size_t nrows,
+        size_t ncols,
+        const SValue* values)> fn) {
+  on_row_block_ = fn;
+}
+
 void BinaryResultParser::onProgress(
     stx::Function<void (const ExecutionStatus& status)> fn) {
   on_progress_ = fn;
@@ -75,6 +83,17 @@ void BinaryResultParser::parse(const char* data, size_t size) {
         break;
       }
 
+      case 0xf5:
+      case 0xf6: {
+        size_t res = parseBatch(buf_.structAt<void>(cur), end - cur);
+        if (res > 0) {
+          cur += res;
+        } else {
+          eof = true;
+        }
+        break;
+      }
+
       case 0xf3: {
         size_t res = parseProgress(buf_.structAt<void>(cur), end - cur);
         if (res > 0) {
@@ -144,6 +163,83 @@ size_t BinaryResultParser::parseTableHeader(const void* data, size_t size) {
   return reader.position();
 }
 
+/**
+ * Reads a value of the provided type (encoded without the type byte)
+ */
+static bool readValue(
+    util::BinaryMessageReader* reader,
+    uint8_t type,
+    SValue* value) {
+  switch (type) {
+    case SQL_STRING: {
+      String val;
+      if (!reader->maybeReadLenencString(&val)) {
+        return false;
+      }
+
+      *value = SValue(val);
+      return true;
+    }
+
+    case SQL_FLOAT: {
+      double val;
+      if (!reader->maybeReadDouble(&val)) {
+        return false;
+      }
+
+      *value = SValue(SValue::FloatType(val));
+      return true;
+    }
+
+    case SQL_INTEGER: {
+      uint64_t val;
+      if (!reader->maybeReadUInt64(&val)) {
+        return false;
+      }
+
+      *value = SValue(SValue::IntegerType(val));
+      return true;
+    }
+
+    case SQL_BOOL: {
+      uint8_t val;
+      if (!reader->maybeReadUInt8(&val)) {
+        return false;
+      }
+
+      *value = SValue(SValue::BoolType(val == 1));
+      return true;
+    }
+
+    case SQL_TIMESTAMP: {
+      uint64_t val;
+      if (!reader->maybeReadUInt64(&val)) {
+        return false;
+      }
+
+      *value = SValue(SValue::TimeType(val));
+      return true;
+    }
+
+    case SQL_NULL:
+      *value = SValue();
+      return true;
+
+    default:
+      RAISEF(kParseError, "invalid value type: $0", type);
+
+  }
+}
+
+static bool readSValue(util::BinaryMessageReader* reader, SValue* value) {
+  uint8_t type;
+  if (!reader->maybeReadUInt8(&type)) {
+    return false;
+  }
+
+  return readValue(reader, type, value);
+}
+
 size_t BinaryResultParser::parseRow(const void* data, size_t size) {
   util::BinaryMessageReader reader(data, size);
 
@@ -157,77 +253,96 @@ size_t BinaryResultParser::parseRow(const void* data, size_t size) {
     return 0;
   }
 
-  Vector<SValue> row;
+  block_.resize(ncols);
   for (uint64_t i = 0; i < ncols; ++i) {
-    uint8_t stype;
-    if (!reader.maybeReadUInt8(&stype)) {
+    if (!readSValue(&reader, &block_[i])) {
       return 0;
     }
+  }
 
-    switch (stype) {
-      case SQL_STRING: {
-        String val;
-        if (reader.maybeReadLenencString(&val)) {
-          row.emplace_back(SValue(val));
-          break;
-        } else {
-          return 0;
-        }
-      }
+  emitRows(1, ncols, block_.data(), false);
+  return reader.position();
+}
 
-      case SQL_FLOAT: {
-        double val;
-        if (reader.maybeReadDouble(&val)) {
-          row.emplace_back(SValue(SValue::FloatType(val)));
-          break;
-        } else {
-          return 0;
-        }
-      }
+size_t BinaryResultParser::parseBatch(const void* data, size_t size) {
+  util::BinaryMessageReader reader(data, size);
 
-      case SQL_INTEGER: {
-        uint64_t val;
-        if (reader.maybeReadUInt64(&val)) {
-          row.emplace_back(SValue(SValue::IntegerType(val)));
-          break;
-        } else {
-          return 0;
-        }
-      }
+  uint8_t type;
+  if (!reader.maybeReadUInt8(&type)) {
+    return 0;
+  }
 
-      case SQL_BOOL: {
-        uint8_t val;
-        if (reader.maybeReadUInt8(&val)) {
-          row.emplace_back(SValue(SValue::BoolType(val == 1)));
-          break;
-        } else {
-          return 0;
-        }
+  uint64_t nrows;
+  uint64_t ncols;
+  uint64_t body_size;
+  if (!reader.maybeReadVarUInt(&nrows) ||
+      !reader.maybeReadVarUInt(&ncols) ||
+      !reader.maybeReadVarUInt(&body_size)) {
+    return 0;
+  }
+
+  /* every value takes at least one byte, so a batch with more values than
+     bytes is corrupt (this also rejects nrows * ncols overflows) */
+  if (nrows > 0 && (ncols == 0 || nrows > body_size / ncols)) {
+    RAISE(kParseError, "invalid row batch");
+  }
+
+  /* wait until the batch is complete */
+  auto begin = reader.position();
+  if (size - begin < body_size) {
+    return 0;
+  }
+
+  block_.resize(nrows * ncols);
+  util::BinaryMessageReader body((const char*) data + begin, body_size);
+
+  bool complete = true;
+  if (type == 0xf5) {
+    for (auto& v : block_) {
+      complete = complete && readSValue(&body, &v);
+    }
+  } else {
+    for (uint64_t col = 0; complete && col < ncols; ++col) {
+      uint8_t col_type;
+      if (!body.maybeReadUInt8(&col_type)) {
+        complete = false;
+        break;
       }
 
-      case SQL_TIMESTAMP: {
-        uint64_t val;
-        if (reader.maybeReadUInt64(&val)) {
-          row.emplace_back(SValue(SValue::TimeType(val)));
-          break;
+      for (uint64_t row = 0; complete && row < nrows; ++row) {
+        auto value = &block_[row * ncols + col];
+        if (col_type == 0xff) {
+          complete = readSValue(&body, value);
         } else {
-          return 0;
+          complete = readValue(&body, col_type, value);
         }
       }
+    }
+  }
 
-      case SQL_NULL: {
-        row.emplace_back(SValue());
-        break;
-      }
+  if (!complete) {
+    RAISE(kParseError, "truncated row batch");
+  }
 
-    }
+  emitRows(nrows, ncols, block_.data(), true);
+  return begin + body_size;
+}
+
+void BinaryResultParser::emitRows(
+    size_t nrows,
+    size_t ncols,
+    const SValue* values,
+    bool is_batch) {
+  if (on_row_block_ && (is_batch || !on_row_)) {
+    on_row_block_(nrows, ncols, values);
+    return;
   }
 
   if (on_row_) {
-    on_row_(row.size(), row.data());
+    for (size_t i = 0; i < nrows; ++i) {
+      on_row_(ncols, values + i * ncols);
+    }
   }
-
-  return reader.position();
 }
 
 size_t BinaryResultParser::parseProgress(const void* data, size_t size) {
@@ -31,6 +31,18 @@ public:
 
   void onTableHeader(stx::Function<void (const Vector<String>& columns)> fn);
   void onRow(stx::Function<void (int argc, const SValue* argv)> fn);
+
+  /**
+   * Receives the rows of a batch event as one block of nrows * ncols values
+   * (row by row). If no row block callback is set, the rows of a batch are
+   * passed to the row callback one by one and vice versa
+   */
+  void onRowBlock(
+      stx::Function<void (
+          size_t nrows,
+          size_t ncols,
+          const SValue* values)> fn);
+
   void onProgress(stx::Function<void (const ExecutionStatus& status)> fn);
   void onError(stx::Function<void (const String& error)> fn);
 
@@ -42,15 +54,26 @@ protected:
 
   size_t parseTableHeader(const void* data, size_t size);
   size_t parseRow(const void* data, size_t size);
+  size_t parseBatch(const void* data, size_t size);
+  void emitRows(
+      size_t nrows,
+      size_t ncols,
+      const SValue* values,
+      bool is_batch);
   size_t parseProgress(const void* data, size_t size);
   size_t parseError(const void* data, size_t size);
 
   stx::Buffer buf_;
   stx::Function<void (const Vector<String>& columns)> on_table_header_;
   stx::Function<void (int argc, const SValue* argv)> on_row_;
+  stx::Function<void (
+      size_t nrows,
+      size_t ncols,
+      const SValue* values)> on_row_block_;
   stx::Function<void (const ExecutionStatus& status)> on_progress_;
   stx::Function<void (const String& error)> on_error_;
 
+  Vector<SValue> block_;
   bool got_header_;
   bool got_footer_;
 };
@@ -0,0 +1,194 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/runtime/GroupHashMap.h>
+
+using namespace stx;
+
+namespace csql {
+
+GroupHashMap::GroupHashMap(
+    size_t key_len,
+    size_t value_len) :
+    key_len_(key_len),
+    value_len_(value_len),
+    arena_(new ScratchMemory()),
+    index_(0, KeyHash(), KeyEq(key_len * kWordsPerColumn)),
+    probe_(key_len * kWordsPerColumn, 0) {}
+
+VM::Instance* GroupHashMap::findOrInsert(const SValue* key, bool* inserted) {
+  encodeKey(key, probe_.data());
+
+  KeyRef probe;
+  probe.words = probe_.data();
+  probe.hash = hashKey(probe.words);
+
+  auto iter = index_.find(probe);
+  if (iter != index_.end()) {
+    *inserted = false;
+    return groups_[iter->second].instances;
+  }
+
+  auto nwords = key_len_ * kWordsPerColumn;
+  auto key_words = (uint64_t*) arena_->alloc(sizeof(uint64_t) * nwords);
+  memcpy(key_words, probe_.data(), sizeof(uint64_t) * nwords);
+
+  Group group;
+  group.key = key_words;
+  group.instances = (VM::Instance*) arena_->alloc(
+      sizeof(VM::Instance) * value_len_);
+
+  KeyRef key_ref;
+  key_ref.words = key_words;
+  key_ref.hash = probe.hash;
+  index_.emplace(key_ref, groups_.size());
+  groups_.emplace_back(group);
+
+  *inserted = true;
+  return group.instances;
+}
+
+size_t GroupHashMap::size() const {
+  return groups_.size();
+}
+
+VM::Instance* GroupHashMap::getGroup(size_t group_idx) const {
+  return groups_[group_idx].instances;
+}
+
+void GroupHashMap::getKey(size_t group_idx, SValue* key) const {
+  auto words = groups_[group_idx].key;
+
+  for (size_t i = 0; i < key_len_; ++i) {
+    auto type = (sql_type) words[i * kWordsPerColumn];
+    auto bits = words[i * kWordsPerColumn + 1];
+
+    switch (type) {
+      case SQL_NULL:
+        key[i] = SValue();
+        break;
+      case SQL_INTEGER:
+        key[i] = SValue(SValue::IntegerType(bits));
+        break;
+      case SQL_TIMESTAMP:
+        key[i] = SValue(SValue::TimeType(bits));
+        break;
+      case SQL_BOOL:
+        key[i] = SValue(SValue::BoolType(bits != 0));
+        break;
+      case SQL_FLOAT: {
+        double v;
+        memcpy(&v, &bits, sizeof(v));
+        key[i] = SValue(SValue::FloatType(v));
+        break;
+      }
+      case SQL_STRING:
+        key[i] = SValue(String(strings_[bits].data, strings_[bits].size));
+        break;
+    }
+  }
+}
+
+void GroupHashMap::clear() {
+  index_.clear();
+  groups_.clear();
+  string_ids_.clear();
+  strings_.clear();
+  arena_.reset(new ScratchMemory());
+}
+
+void GroupHashMap::encodeKey(const SValue* key, uint64_t* words) {
+  for (size_t i = 0; i < key_len_; ++i) {
+    auto type = key[i].getType();
+    uint64_t bits = 0;
+
+    switch (type) {
+      case SQL_NULL:
+        break;
+      case SQL_INTEGER:
+      case SQL_TIMESTAMP:
+        bits = key[i].getInteger();
+        break;
+      case SQL_BOOL:
+        bits = key[i].getBool() ? 1 : 0;
+        break;
+      case SQL_FLOAT: {
+        auto v = key[i].getFloat();
+        memcpy(&bits, &v, sizeof(v));
+        break;
+      }
+      case SQL_STRING: {
+        StringRef str;
+        str.data = key[i].getStringData();
+        str.size = key[i].getStringSize();
+
+        auto iter = string_ids_.find(str);
+        if (iter == string_ids_.end()) {
+          /* keep the arena word-aligned for the key words */
+          auto data = (char*) arena_->alloc((str.size + 7) & ~size_t(7));
+          memcpy(data, str.data, str.size);
+          str.data = data;
+
+          bits = strings_.size();
+          string_ids_.emplace(str, bits);
+          strings_.emplace_back(str);
+        } else {
+          bits = iter->second;
+        }
+        break;
+      }
+    }
+
+    words[i * kWordsPerColumn] = type;
+    words[i * kWordsPerColumn + 1] = bits;
+  }
+}
+
+size_t GroupHashMap::hashKey(const uint64_t* words) const {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < key_len_ * kWordsPerColumn; ++i) {
+    h ^= words[i];
+    h *= 1099511628211ull;
+    h ^= h >> 32;
+  }
+
+  return h;
+}
+
+size_t GroupHashMap::StringRefHash::operator()(const StringRef& str) const {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < str.size; ++i) {
+    h ^= (unsigned char) str.data[i];
+    h *= 1099511628211ull;
+  }
+
+  return h;
+}
+
+bool GroupHashMap::StringRefEq::operator()(
+    const StringRef& a,
+    const StringRef& b) const {
+  return a.size == b.size && memcmp(a.data, b.data, a.size) == 0;
+}
+
+size_t GroupHashMap::KeyHash::operator()(const KeyRef& key) const {
+  return key.hash;
+}
+
+GroupHashMap::KeyEq::KeyEq(size_t _len) : len(_len) {}
+
+bool GroupHashMap::KeyEq::operator()(
+    const KeyRef& a,
+    const KeyRef& b) const {
+  return
+      a.hash == b.hash &&
+      memcmp(a.words, b.words, sizeof(uint64_t) * len) == 0;
+}
+
+} // namespace csql
@@ -0,0 +1,102 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <unordered_map>
+#include <stx/stdtypes.h>
+#include <csql/svalue.h>
+#include <csql/runtime/vm.h>
+#include <csql/runtime/ScratchMemory.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Maps GROUP BY keys to a contiguous block of aggregate instances
+ *
+ * Keys are hashed and compared by their typed binary value: integer,
+ * timestamp, bool and float key columns are stored as fixed-width words and
+ * string key columns are interned to a fixed-width id. Keys and instance
+ * blocks are allocated from an arena. Groups are numbered in the order in
+ * which they were first inserted
+ */
+class GroupHashMap {
+public:
+
+  GroupHashMap(size_t key_len, size_t value_len);
+
+  /**
+   * Returns the instance block for the provided key, which must contain
+   * key_len values. If the group did not exist yet, a new (uninitialized)
+   * instance block is returned and *inserted is set to true
+   */
+  VM::Instance* findOrInsert(const SValue* key, bool* inserted);
+
+  size_t size() const;
+
+  VM::Instance* getGroup(size_t group_idx) const;
+  void getKey(size_t group_idx, SValue* key) const;
+
+  void clear();
+
+protected:
+
+  static const size_t kWordsPerColumn = 2;
+
+  struct KeyRef {
+    const uint64_t* words;
+    size_t hash;
+  };
+
+  struct KeyHash {
+    size_t operator()(const KeyRef& key) const;
+  };
+
+  struct KeyEq {
+    KeyEq(size_t len);
+    bool operator()(const KeyRef& a, const KeyRef& b) const;
+    size_t len;
+  };
+
+  struct Group {
+    const uint64_t* key;
+    VM::Instance* instances;
+  };
+
+  /* interned strings are stored in the arena and looked up by their bytes so
+     that probing a string key doesn't allocate */
+  struct StringRef {
+    const char* data;
+    size_t size;
+  };
+
+  struct StringRefHash {
+    size_t operator()(const StringRef& str) const;
+  };
+
+  struct StringRefEq {
+    bool operator()(const StringRef& a, const StringRef& b) const;
+  };
+
+  void encodeKey(const SValue* key, uint64_t* words);
+  size_t hashKey(const uint64_t* words) const;
+
+  size_t key_len_;
+  size_t value_len_;
+  ScopedPtr<ScratchMemory> arena_;
+  std::unordered_map<KeyRef, size_t, KeyHash, KeyEq> index_;
+  Vector<Group> groups_;
+  Vector<uint64_t> probe_;
+  std::unordered_map<StringRef, uint64_t, StringRefHash, StringRefEq>
+      string_ids_;
+  Vector<StringRef> strings_;
+};
+
+} // namespace csql
@@ -7,6 +7,7 @@
  * copy of the GNU General Public License along with this program. If not, see
  * <http://www.gnu.org/licenses/>.
  */
+#include <string.h>
 #include <stx/exception.h>
 #include <csql/runtime/LikePattern.h>
 
@@ -14,12 +15,191 @@ using namespace stx;
 
 namespace csql {
 
-LikePattern::LikePattern(const String& pattern) : pattern_(pattern) {}
+LikePattern::Segment::Segment() : has_wildcards(false) {}
+
+LikePattern::LikePattern(const String& pattern) : pattern_(pattern) {
+  segments_.emplace_back();
+
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    auto c = pattern[i];
+
+    switch (c) {
+
+      case '%':
+        segments_.emplace_back();
+        continue;
+
+      case '_':
+        segments_.back().chars += c;
+        segments_.back().wildcard.emplace_back(true);
+        segments_.back().has_wildcards = true;
+        continue;
+
+      case '\\':
+        if (i + 1 < pattern.size()) {
+          c = pattern[++i];
+        }
+        /* fallthrough */
+
+      default:
+        segments_.back().chars += c;
+        segments_.back().wildcard.emplace_back(false);
+        continue;
+
+    }
+  }
+
+  const auto& first = segments_.front();
+  const auto& last = segments_.back();
+
+  bool all_empty = true;
+  for (const auto& s : segments_) {
+    if (!s.chars.empty()) {
+      all_empty = false;
+    }
+  }
+
+  if (segments_.size() == 1 && !first.has_wildcards) {
+    type_ = MatchType::EXACT;
+  } else if (all_empty) {
+    type_ = MatchType::ANY;
+  } else if (
+      segments_.size() == 2 &&
+      last.chars.empty() &&
+      !first.has_wildcards) {
+    type_ = MatchType::PREFIX;
+  } else if (
+      segments_.size() == 2 &&
+      first.chars.empty() &&
+      !last.has_wildcards) {
+    type_ = MatchType::SUFFIX;
+  } else if (
+      segments_.size() == 3 &&
+      first.chars.empty() &&
+      last.chars.empty() &&
+      !segments_[1].has_wildcards) {
+    type_ = MatchType::CONTAINS;
+  } else {
+    type_ = MatchType::GENERIC;
+  }
+}
 
 bool LikePattern::match(const String& subject) const {
-  RAISE(
-      kNotYetImplementedError,
-      "LIKE is not yet implemented, use REGEX instead");
+  return match(subject.data(), subject.size());
+}
+
+bool LikePattern::match(const char* data, size_t size) const {
+  switch (type_) {
+
+    case MatchType::EXACT: {
+      const auto& s = segments_.front().chars;
+      return size == s.size() && memcmp(data, s.data(), size) == 0;
+    }
+
+    case MatchType::PREFIX: {
+      const auto& s = segments_.front().chars;
+      return size >= s.size() && memcmp(data, s.data(), s.size()) == 0;
+    }
+
+    case MatchType::SUFFIX: {
+      const auto& s = segments_.back().chars;
+      return
+          size >= s.size() &&
+          memcmp(data + size - s.size(), s.data(), s.size()) == 0;
+    }
+
+    case MatchType::CONTAINS: {
+      const auto& s = segments_[1].chars;
+      return memmem(data, size, s.data(), s.size()) != nullptr;
+    }
+
+    case MatchType::ANY:
+      return true;
+
+    case MatchType::GENERIC:
+      return matchGeneric(data, size);
+
+  }
+
+  return false;
+}
+
+/**
+ * The first segment must match at the start of the subject and the last one
+ * at its end. Matching each segment in between at its leftmost position is
+ * sufficient since the '%' around it can absorb anything.
+ */
+bool LikePattern::matchGeneric(const char* data, size_t size) const {
+  const auto& first = segments_.front();
+  const auto& last = segments_.back();
+
+  if (segments_.size() == 1) {
+    return size == first.chars.size() && matchSegment(first, data);
+  }
+
+  if (size < first.chars.size() + last.chars.size()) {
+    return false;
+  }
+
+  if (!matchSegment(first, data) ||
+      !matchSegment(last, data + size - last.chars.size())) {
+    return false;
+  }
+
+  auto begin = data + first.chars.size();
+  auto end = data + size - last.chars.size();
+  for (size_t i = 1; i + 1 < segments_.size(); ++i) {
+    const auto& segment = segments_[i];
+    if (segment.chars.empty()) {
+      continue;
+    }
+
+    auto pos = findSegment(segment, begin, end);
+    if (pos == nullptr) {
+      return false;
+    }
+
+    begin = pos + segment.chars.size();
+  }
+
+  return true;
+}
+
+bool LikePattern::matchSegment(const Segment& segment, const char* data) {
+  if (!segment.has_wildcards) {
+    return memcmp(data, segment.chars.data(), segment.chars.size()) == 0;
+  }
+
+  for (size_t i = 0; i < segment.chars.size(); ++i) {
+    if (!segment.wildcard[i] && data[i] != segment.chars[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const char* LikePattern::findSegment(
+    const Segment& segment,
+    const char* begin,
+    const char* end) {
+  auto len = segment.chars.size();
+  if (begin + len > end) {
+    return nullptr;
+  }
+
+  if (!segment.has_wildcards) {
+    return static_cast<const char*>(
+        memmem(begin, end - begin, segment.chars.data(), len));
+  }
+
+  for (auto cur = begin; cur + len <= end; ++cur) {
+    if (matchSegment(segment, cur)) {
+      return cur;
+    }
+  }
+
+  return nullptr;
 }
 
 } // namespace csql
@@ -14,15 +14,55 @@ using namespace stx;
 
 namespace csql {
 
+/**
+ * A LIKE pattern, compiled once into a matcher. '%' matches any sequence of
+ * bytes, '_' matches any single byte and a backslash escapes the following
+ * character. Patterns that are a plain string, a prefix, a suffix or a
+ * substring are matched with memcmp/memmem, everything else is split into
+ * the runs between the '%' wildcards which are then matched left to right.
+ */
 class LikePattern {
 public:
 
   LikePattern(const String& pattern);
 
   bool match(const String& subject) const;
+  bool match(const char* data, size_t size) const;
 
 protected:
+
+  enum class MatchType {
+    EXACT,
+    PREFIX,
+    SUFFIX,
+    CONTAINS,
+    ANY,
+    GENERIC
+  };
+
+  /**
+   * The characters between two '%' wildcards. Positions where wildcard is
+   * true match any single byte
+   */
+  struct Segment {
+    Segment();
+    String chars;
+    Vector<bool> wildcard;
+    bool has_wildcards;
+  };
+
+  static bool matchSegment(const Segment& segment, const char* data);
+
+  static const char* findSegment(
+      const Segment& segment,
+      const char* begin,
+      const char* end);
+
+  bool matchGeneric(const char* data, size_t size) const;
+
   String pattern_;
+  Vector<Segment> segments_;
+  MatchType type_;
 };
 
 } // namespace csql
@@ -0,0 +1,479 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+#include <stx/exception.h>
+#include <csql/runtime/RegexPattern.h>
+
+#ifndef HAVE_PCRE
+#error "PCRE is required"
+#endif
+
+using namespace stx;
+
+namespace csql {
+
+static bool isMetaCharacter(char c) {
+  switch (c) {
+    case '.':
+    case '[':
+    case ']':
+    case '(':
+    case ')':
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+    case '}':
+    case '|':
+    case '^':
+    case '$':
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Returns the index of the ']' that closes the character class starting at
+ * pattern[begin]
+ */
+static size_t skipCharacterClass(const String& pattern, size_t begin) {
+  auto i = begin + 1;
+  if (i < pattern.size() && pattern[i] == '^') {
+    ++i;
+  }
+
+  if (i < pattern.size() && pattern[i] == ']') {
+    ++i;
+  }
+
+  for (; i < pattern.size(); ++i) {
+    if (pattern[i] == '\\') {
+      ++i;
+    } else if (pattern[i] == ']') {
+      return i;
+    }
+  }
+
+  return pattern.size();
+}
+
+/**
+ * Returns the index of the last character of the escape sequence starting at
+ * pattern[begin], including arguments like the digits of "\x41" and "\101"
+ * or the name in "\p{Lu}" and "\k<name>"
+ */
+static size_t skipEscape(const String& pattern, size_t begin) {
+  auto i = begin + 1;
+  if (i >= pattern.size()) {
+    return begin;
+  }
+
+  auto skip_until = [&pattern] (size_t i, char close) -> size_t {
+    while (i + 1 < pattern.size() && pattern[i] != close) {
+      ++i;
+    }
+
+    return i;
+  };
+
+  auto next = i + 1 < pattern.size() ? pattern[i + 1] : '\0';
+  switch (pattern[i]) {
+
+    case 'x':
+      if (next == '{') {
+        return skip_until(i + 1, '}');
+      }
+
+      for (size_t n = 0; n < 2 && i + 1 < pattern.size(); ++n) {
+        if (!isxdigit(pattern[i + 1])) {
+          break;
+        }
+
+        ++i;
+      }
+
+      return i;
+
+    case 'c':
+      return std::min(i + 1, pattern.size() - 1);
+
+    case 'p':
+    case 'P':
+      if (next != '{') {
+        return std::min(i + 1, pattern.size() - 1);
+      }
+
+      return skip_until(i + 1, '}');
+
+    case 'o':
+    case 'N':
+      return next == '{' ? skip_until(i + 1, '}') : i;
+
+    case 'k':
+    case 'g':
+      switch (next) {
+        case '{':
+          return skip_until(i + 1, '}');
+        case '<':
+          return skip_until(i + 1, '>');
+        case '\'':
+          return skip_until(i + 2, '\'');
+        case '-':
+        case '+':
+          ++i;
+          break;
+      }
+      break;
+
+  }
+
+  /* back references and octal escapes */
+  while (i + 1 < pattern.size() && isdigit(pattern[i + 1])) {
+    ++i;
+  }
+
+  return i;
+}
+
+/**
+ * Splits the pattern at '|' characters that are not escaped, returns false if
+ * the pattern contains groups or character classes
+ */
+static bool splitAlternatives(const String& pattern, Vector<String>* parts) {
+  String cur;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    switch (pattern[i]) {
+
+      case '\\':
+        cur += pattern[i];
+        if (i + 1 < pattern.size()) {
+          cur += pattern[++i];
+        }
+        break;
+
+      case '|':
+        parts->emplace_back(cur);
+        cur.clear();
+        break;
+
+      case '(':
+      case '[':
+        return false;
+
+      default:
+        cur += pattern[i];
+        break;
+
+    }
+  }
+
+  parts->emplace_back(cur);
+  return true;
+}
+
+RegexPattern::RegexPattern(
+    const String& pattern) :
+    pattern_(pattern),
+    regex_(nullptr),
+    type_(MatchType::GENERIC) {
+  const char* error;
+  int error_offset;
+  regex_ = pcre_compile(pattern.c_str(), 0, &error, &error_offset, nullptr);
+  if (regex_ == nullptr) {
+    RAISEF(
+        kParseError,
+        "invalid regular expression '$0': $1 at offset $2",
+        pattern,
+        error,
+        error_offset);
+  }
+
+  /* inline options like (?i) change how literals match */
+  if (pattern.find("(?") != String::npos) {
+    return;
+  }
+
+  auto body = pattern;
+  bool anchored_begin = false;
+  bool anchored_end = false;
+
+  if (!body.empty() && body[0] == '^') {
+    anchored_begin = true;
+    body.erase(0, 1);
+  }
+
+  if (!body.empty() && body.back() == '$') {
+    size_t nescapes = 0;
+    for (auto i = body.size() - 1; i > 0 && body[i - 1] == '\\'; --i) {
+      ++nescapes;
+    }
+
+    if (nescapes % 2 == 0) {
+      anchored_end = true;
+      body.pop_back();
+    }
+  }
+
+  String literal;
+  if (parseLiteral(body, &literal)) {
+    if (anchored_begin && anchored_end) {
+      type_ = MatchType::EXACT;
+    } else if (anchored_begin) {
+      type_ = MatchType::PREFIX;
+    } else if (anchored_end) {
+      type_ = MatchType::SUFFIX;
+    } else {
+      type_ = MatchType::CONTAINS;
+    }
+
+    literals_.emplace_back(literal);
+    return;
+  }
+
+  Vector<String> alternatives;
+  if (!anchored_begin &&
+      !anchored_end &&
+      splitAlternatives(pattern, &alternatives) &&
+      alternatives.size() > 1) {
+    bool all_literal = true;
+    for (const auto& alt : alternatives) {
+      String alt_literal;
+      if (alt.empty() || !parseLiteral(alt, &alt_literal)) {
+        all_literal = false;
+        break;
+      }
+
+      literals_.emplace_back(alt_literal);
+    }
+
+    if (all_literal) {
+      type_ = MatchType::ANY_OF;
+      return;
+    }
+
+    literals_.clear();
+  }
+
+  required_literal_ = findRequiredLiteral(pattern);
+}
+
+RegexPattern::~RegexPattern() {
+  pcre_free(regex_);
+}
+
+bool RegexPattern::match(const String& subject) const {
+  return match(subject.data(), subject.size());
+}
+
+bool RegexPattern::match(const char* data, size_t size) const {
+  switch (type_) {
+
+    case MatchType::CONTAINS: {
+      const auto& l = literals_[0];
+      return
+          l.empty() ||
+          memmem(data, size, l.data(), l.size()) != nullptr;
+    }
+
+    case MatchType::PREFIX: {
+      const auto& l = literals_[0];
+      return size >= l.size() && memcmp(data, l.data(), l.size()) == 0;
+    }
+
+    case MatchType::SUFFIX:
+      return matchEnd(data, size, literals_[0]);
+
+    case MatchType::EXACT: {
+      const auto& l = literals_[0];
+      if (size == l.size() + 1 && data[l.size()] == '\n') {
+        --size;
+      }
+
+      return size == l.size() && memcmp(data, l.data(), l.size()) == 0;
+    }
+
+    case MatchType::ANY_OF:
+      for (const auto& l : literals_) {
+        if (memmem(data, size, l.data(), l.size()) != nullptr) {
+          return true;
+        }
+      }
+
+      return false;
+
+    case MatchType::GENERIC: {
+      const auto& l = required_literal_;
+      if (!l.empty() && memmem(data, size, l.data(), l.size()) == nullptr) {
+        return false;
+      }
+
+      return pcre_exec(regex_, nullptr, data, size, 0, 0, nullptr, 0) >= 0;
+    }
+
+  }
+
+  return false;
+}
+
+const String& RegexPattern::requiredLiteral() const {
+  return required_literal_;
+}
+
+/**
+ * '$' also matches before a newline at the end of the subject
+ */
+bool RegexPattern::matchEnd(
+    const char* data,
+    size_t size,
+    const String& literal) {
+  if (size > 0 && data[size - 1] == '\n') {
+    auto n = size - 1;
+    if (n >= literal.size() &&
+        memcmp(data + n - literal.size(), literal.data(), literal.size()) == 0) {
+      return true;
+    }
+  }
+
+  return
+      size >= literal.size() &&
+      memcmp(data + size - literal.size(), literal.data(), literal.size()) == 0;
+}
+
+bool RegexPattern::parseLiteral(const String& str, String* literal) {
+  for (size_t i = 0; i < str.size(); ++i) {
+    auto c = str[i];
+
+    if (c == '\\') {
+      if (i + 1 >= str.size() || isalnum(str[i + 1])) {
+        return false;
+      }
+
+      *literal += str[++i];
+      continue;
+    }
+
+    if (isMetaCharacter(c)) {
+      return false;
+    }
+
+    *literal += c;
+  }
+
+  return true;
+}
+
+/**
+ * Finds the longest run of literal characters outside of groups, character
+ * classes and alternations. A character that is followed by a quantifier that
+ * allows zero repetitions is not part of the run.
+ */
+String RegexPattern::findRequiredLiteral(const String& pattern) {
+  /* \Q...\E quotes metacharacters */
+  if (pattern.find('|') != String::npos ||
+      pattern.find("\\Q") != String::npos) {
+    return "";
+  }
+
+  String best;
+  String cur;
+  auto end_run = [&best, &cur] {
+    if (cur.size() > best.size()) {
+      best = cur;
+    }
+
+    cur.clear();
+  };
+
+  size_t depth = 0;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    auto c = pattern[i];
+
+    if (depth > 0) {
+      switch (c) {
+        case '\\':
+          i = skipEscape(pattern, i);
+          break;
+        case '[':
+          i = skipCharacterClass(pattern, i);
+          break;
+        case '(':
+          ++depth;
+          break;
+        case ')':
+          --depth;
+          break;
+      }
+
+      continue;
+    }
+
+    switch (c) {
+
+      case '\\':
+        if (i + 1 < pattern.size() && !isalnum(pattern[i + 1])) {
+          cur += pattern[++i];
+        } else {
+          i = skipEscape(pattern, i);
+          end_run();
+        }
+        break;
+
+      case '(':
+        ++depth;
+        end_run();
+        break;
+
+      case '[':
+        i = skipCharacterClass(pattern, i);
+        end_run();
+        break;
+
+      case '*':
+      case '?':
+        if (!cur.empty()) {
+          cur.pop_back();
+        }
+        end_run();
+        break;
+
+      case '{':
+        if (!cur.empty()) {
+          cur.pop_back();
+        }
+        end_run();
+
+        while (i < pattern.size() && pattern[i] != '}') {
+          ++i;
+        }
+        break;
+
+      case '+':
+      case '.':
+      case '^':
+      case '$':
+      case ')':
+        end_run();
+        break;
+
+      default:
+        cur += c;
+        break;
+
+    }
+  }
+
+  end_run();
+  return best;
+}
+
+} // namespace csql
@@ -0,0 +1,67 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <pcre.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * A REGEX pattern that is analyzed once when the X_REGEX instruction is
+ * compiled. Plain literals, anchored literals ("^abc", "abc$", "^abc$") and
+ * alternations of literals ("abc|def") are matched with memcmp/memmem
+ * without running PCRE. For all other patterns we extract a literal that
+ * every match must contain (if any) and only run PCRE on subjects that
+ * contain it. PCRE runs directly on the subject's buffer.
+ */
+class RegexPattern {
+public:
+
+  RegexPattern(const String& pattern);
+  ~RegexPattern();
+
+  RegexPattern(const RegexPattern& other) = delete;
+  RegexPattern& operator=(const RegexPattern& other) = delete;
+
+  bool match(const String& subject) const;
+  bool match(const char* data, size_t size) const;
+
+  /**
+   * Returns the literal that every matching subject must contain or an empty
+   * string if there is none
+   */
+  const String& requiredLiteral() const;
+
+protected:
+
+  enum class MatchType {
+    CONTAINS,
+    PREFIX,
+    SUFFIX,
+    EXACT,
+    ANY_OF,
+    GENERIC
+  };
+
+  static bool parseLiteral(const String& str, String* literal);
+  static String findRequiredLiteral(const String& pattern);
+
+  static bool matchEnd(const char* data, size_t size, const String& literal);
+
+  String pattern_;
+  pcre* regex_;
+  MatchType type_;
+  Vector<String> literals_;
+  String required_literal_;
+};
+
+} // namespace csql
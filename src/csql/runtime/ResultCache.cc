@@ -0,0 +1,149 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <sys/stat.h>
+#include <stx/io/fileutil.h>
+#include <stx/random.h>
+#include <csql/runtime/ResultCache.h>
+
+namespace csql {
+
+ResultCache::ResultCache(
+    const String& cache_dir,
+    size_t max_size) :
+    cache_dir_(cache_dir),
+    max_size_(max_size),
+    size_(0) {
+  struct StoredResult {
+    String key;
+    size_t size;
+    time_t mtime;
+  };
+
+  /* pick up the results that were stored before, least recently written
+     first */
+  Vector<StoredResult> stored;
+  FileUtil::ls(cache_dir_, [this, &stored] (const String& file) -> bool {
+    if (!StringUtil::beginsWith(file, "task_") ||
+        !StringUtil::endsWith(file, ".cache")) {
+      return true;
+    }
+
+    struct stat st;
+    auto path = FileUtil::joinPaths(cache_dir_, file);
+    if (::stat(path.c_str(), &st) == 0) {
+      StoredResult result;
+      result.key = file.substr(5, file.size() - 11);
+      result.size = st.st_size;
+      result.mtime = st.st_mtime;
+      stored.emplace_back(result);
+    }
+
+    return true;
+  });
+
+  std::sort(
+      stored.begin(),
+      stored.end(),
+      [] (const StoredResult& a, const StoredResult& b) {
+        return a.mtime < b.mtime;
+      });
+
+  for (const auto& r : stored) {
+    addEntry(r.key, r.size);
+  }
+
+  evict(0);
+}
+
+ScopedPtr<InputStream> ResultCache::openResult(const SHA1Hash& key) {
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto iter = entries_.find(key.toString());
+  if (iter == entries_.end()) {
+    return nullptr;
+  }
+
+  lru_.splice(lru_.end(), lru_, iter->second.lru_pos);
+
+  /* the file is opened while holding the lock so that it can't be evicted
+     in between */
+  return FileInputStream::openFile(getFilename(iter->first));
+}
+
+String ResultCache::getTempFilename(const SHA1Hash& key) const {
+  return StringUtil::format(
+      "$0.$1.tmp",
+      getFilename(key.toString()),
+      Random::singleton()->hex128());
+}
+
+void ResultCache::storeResult(
+    const SHA1Hash& key,
+    const String& tmpfile,
+    size_t size) {
+  if (size > max_size_) {
+    FileUtil::rm(tmpfile);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lk(mutex_);
+  auto key_str = key.toString();
+  auto iter = entries_.find(key_str);
+  if (iter != entries_.end()) {
+    /* another task stored the same result in the meantime */
+    lk.unlock();
+    FileUtil::rm(tmpfile);
+    return;
+  }
+
+  evict(size);
+  FileUtil::mv(tmpfile, getFilename(key_str));
+  addEntry(key_str, size);
+}
+
+size_t ResultCache::maxSize() const {
+  return max_size_;
+}
+
+size_t ResultCache::size() const {
+  std::unique_lock<std::mutex> lk(mutex_);
+  return size_;
+}
+
+String ResultCache::getFilename(const String& key) const {
+  return FileUtil::joinPaths(
+      cache_dir_,
+      StringUtil::format("task_$0.cache", key));
+}
+
+void ResultCache::addEntry(const String& key, size_t size) {
+  Entry entry;
+  entry.size = size;
+  entry.lru_pos = lru_.emplace(lru_.end(), key);
+  entries_.emplace(key, entry);
+  size_ += size;
+}
+
+void ResultCache::evict(size_t size) {
+  while (!lru_.empty() && size_ + size > max_size_) {
+    auto key = lru_.front();
+    auto iter = entries_.find(key);
+    size_ -= iter->second.size;
+    entries_.erase(iter);
+    lru_.pop_front();
+
+    auto filename = getFilename(key);
+    if (FileUtil::exists(filename)) {
+      FileUtil::rm(filename);
+    }
+  }
+}
+
+} // namespace csql
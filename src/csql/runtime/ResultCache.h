@@ -0,0 +1,80 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <list>
+#include <mutex>
+#include <stx/stdtypes.h>
+#include <stx/autoref.h>
+#include <stx/SHA1.h>
+#include <stx/io/inputstream.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * A directory of stored task results (see CachedTask), keyed by the task's
+ * cache key. The total size of the stored results is limited to max_size:
+ * when a new result is stored, the least recently used results are deleted
+ * until the new result fits.
+ *
+ * The cache dir should not be shared with anything else, like the runtime's
+ * spill dir, since results that were stored before are picked up (and may be
+ * evicted) when the cache is created.
+ */
+class ResultCache : public RefCounted {
+public:
+
+  static const size_t kDefaultMaxSize = 1024 * 1024 * 1024;
+
+  ResultCache(const String& cache_dir, size_t max_size = kDefaultMaxSize);
+
+  /**
+   * Open the stored result for the provided key and mark it as recently used.
+   * Returns nullptr if no result is stored for the key
+   */
+  ScopedPtr<InputStream> openResult(const SHA1Hash& key);
+
+  /**
+   * Returns a new temporary filename in the cache dir to which the result for
+   * the provided key can be written before it is passed to storeResult
+   */
+  String getTempFilename(const SHA1Hash& key) const;
+
+  /**
+   * Store the result that was written to tmpfile for the provided key. The
+   * tmpfile is moved into the cache or deleted if the result is larger than
+   * the cache
+   */
+  void storeResult(const SHA1Hash& key, const String& tmpfile, size_t size);
+
+  size_t maxSize() const;
+  size_t size() const;
+
+protected:
+
+  struct Entry {
+    size_t size;
+    std::list<String>::iterator lru_pos;
+  };
+
+  String getFilename(const String& key) const;
+  void addEntry(const String& key, size_t size);
+  void evict(size_t size);
+
+  String cache_dir_;
+  size_t max_size_;
+  size_t size_;
+  HashMap<String, Entry> entries_;
+  std::list<String> lru_;
+  mutable std::mutex mutex_;
+};
+
+} // namespace csql
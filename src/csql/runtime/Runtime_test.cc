@@ -12,13 +12,33 @@
 #include <stx/exception.h>
 #include <stx/wallclock.h>
 #include <stx/test/unittest.h>
+#include <stx/io/fileutil.h>
+#include <stx/random.h>
 #include "csql/runtime/defaultruntime.h"
 #include "csql/qtree/SequentialScanNode.h"
 #include "csql/qtree/ColumnReferenceNode.h"
 #include "csql/qtree/CallExpressionNode.h"
 #include "csql/qtree/LiteralExpressionNode.h"
+#include "csql/qtree/LimitNode.h"
+#include "csql/qtree/GroupByNode.h"
+#include "csql/qtree/GroupOverTimewindowNode.h"
 #include "csql/CSTableScanProvider.h"
+#include "csql/CSTableColumnStats.h"
 #include "csql/backends/csv/CSVTableProvider.h"
+#include "csql/runtime/schedulers/LocalScheduler.h"
+#include "csql/runtime/schedulers/ParallelScheduler.h"
+#include "csql/runtime/schedulers/BroadcastSink.h"
+#include "csql/runtime/schedulers/PartitionSink.h"
+#include "csql/runtime/GroupHashMap.h"
+#include "csql/runtime/BinaryResultFormat.h"
+#include "csql/runtime/BinaryResultParser.h"
+#include "csql/runtime/LikePattern.h"
+#include "csql/runtime/RegexPattern.h"
+#include "csql/tasks/limit.h"
+#include "csql/tasks/group_over_timewindow.h"
+#include "csql/qtree/QueryTreeUtil.h"
+#include "csql/expressions/math.h"
+#include "csql/expressions/string.h"
 
 using namespace stx;
 using namespace csql;
@@ -1304,6 +1324,116 @@ TEST_CASE(RuntimeTest, TestDateTimeDateAddExpression, [] () {
   }
 });
 
+TEST_CASE(RuntimeTest, TestDateTruncAndDateAddOverTableRows, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* literal units are compiled to X_DATE_TRUNC/X_DATE_ADD, units that are
+     read from a column take the generic function call path */
+  Vector<std::pair<String, String>> queries = {
+    {
+      R"(select
+            time,
+            date_trunc('5min', time),
+            date_add(time, 2, 'day'),
+            date_add(time, '-1.5', 'HOUR')
+         from testtable;)",
+      R"(select
+            time,
+            date_trunc(p, time),
+            date_add(time, 2, d),
+            date_add(time, '-1.5', h)
+         from (
+            select time, '5min' as p, 'day' as d, 'HOUR' as h
+            from testtable);)"
+    },
+    {
+      R"(select date_trunc('5min', time) as t, count(1)
+         from testtable
+         group by date_trunc('5min', time)
+         order by t asc;)",
+      R"(select date_trunc(p, time) as t, count(1)
+         from (select time, '5min' as p from testtable)
+         group by date_trunc(p, time)
+         order by t asc;)"
+    }
+  };
+
+  for (const auto& q : queries) {
+    ResultList result;
+    auto qplan = runtime->buildQueryPlan(ctx.get(), q.first, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+
+    ResultList expected;
+    auto expected_qplan = runtime->buildQueryPlan(
+        ctx.get(),
+        q.second,
+        estrat.get());
+    expected_qplan->storeResults(0, &expected);
+    expected_qplan->execute();
+
+    EXPECT_TRUE(expected.getNumRows() > 1);
+    EXPECT_EQ(result.getNumColumns(), expected.getNumColumns());
+    EXPECT_EQ(result.getNumRows(), expected.getNumRows());
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      for (size_t j = 0; j < result.getNumColumns(); ++j) {
+        EXPECT_EQ(result.getRow(i)[j], expected.getRow(i)[j]);
+      }
+    }
+  }
+
+  /* a non-numeric amount falls back to the generic function, which fails */
+  EXPECT_EXCEPTION("DATE_ADD: invalid expression abc for unit day", [] () {
+    auto runtime = Runtime::getDefaultRuntime();
+    auto ctx = runtime->newTransaction();
+
+    auto estrat = mkRef(new DefaultExecutionStrategy());
+    estrat->addTableProvider(
+        new CSTableScanProvider(
+            "testtable",
+            "src/csql/testdata/testtbl.cst"));
+
+    ResultList result;
+    auto query = R"(select date_add(time, 'abc', 'day') from testtable;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+  });
+
+  EXPECT_EXCEPTION("DATE_ADD: invalid expression abc for unit day", [] () {
+    auto runtime = Runtime::getDefaultRuntime();
+    auto ctx = runtime->newTransaction();
+    runtime->evaluateConstExpression(
+        ctx.get(),
+        String("date_add(FROM_TIMESTAMP(1447671624), 'abc', 'day')"));
+  });
+
+  /* a zero precision is rejected instead of dividing by zero */
+  EXPECT_EXCEPTION("unknown time precision 0min", [] () {
+    auto runtime = Runtime::getDefaultRuntime();
+    auto ctx = runtime->newTransaction();
+
+    auto estrat = mkRef(new DefaultExecutionStrategy());
+    estrat->addTableProvider(
+        new CSTableScanProvider(
+            "testtable",
+            "src/csql/testdata/testtbl.cst"));
+
+    ResultList result;
+    auto query = R"(select date_trunc('0min', time) from testtable;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+  });
+});
+
 TEST_CASE(RuntimeTest, TestDateTimeTimeAtExpression, [] () {
   auto runtime = Runtime::getDefaultRuntime();
   auto ctx = runtime->newTransaction();
@@ -1375,30 +1505,80 @@ TEST_CASE(RuntimeTest, TestLikeExpression, [] () {
   auto runtime = Runtime::getDefaultRuntime();
   auto ctx = runtime->newTransaction();
 
-  //{
-  //  auto v = runtime->evaluateConstExpression(String("'abc' LIKE 'abc'"));
-  //  EXPECT_EQ(v.getString(), "true");
-  //}
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE 'abc')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
 
-  //{
-  //  auto v = runtime->evaluateConstExpression(String("'abc' LIKE 'a%'"));
-  //  EXPECT_EQ(v.getString(), "true");
-  //}
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE 'a%')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
 
-  //{
-  //  auto v = runtime->evaluateConstExpression(String("'abc' LIKE '_b_'"));
-  //  EXPECT_EQ(v.getString(), "true");
-  //}
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE '_b_')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
 
-  //{
-  //  auto v = runtime->evaluateConstExpression(String("'abc' LIKE '%bc'"));
-  //  EXPECT_EQ(v.getString(), "true");
-  //}
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE '%bc')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
 
-  //{
-  //  auto v = runtime->evaluateConstExpression(String("'abc' LIKE 'c'"));
-  //  EXPECT_EQ(v.getString(), "false");
-  //}
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE 'c')"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abcdef' LIKE '%cd%')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abcdef' LIKE '%dc%')"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abcdef' LIKE 'a%c_e%')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abcdef' LIKE 'a%e_f')"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String(R"('abc' LIKE '%')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  LikePattern escaped("a\\%c_");
+  EXPECT_TRUE(escaped.match("a%cd"));
+  EXPECT_FALSE(escaped.match("abcd"));
+  EXPECT_FALSE(escaped.match("a%c"));
 });
 
 
@@ -2234,3 +2414,1812 @@ TEST_CASE(RuntimeTest, TestNowExpr, [] () {
     //EXPECT_EQ(result.getRow(0)[0], "...");
   }
 });
+
+TEST_CASE(RuntimeTest, TestLeftJoinWithParallelScheduler, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "customers",
+          "src/csql/testdata/testtbl2.csv",
+          '\t'));
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      LEFT JOIN orders
+      ON customers.customerid=orders.customerid
+      ORDER BY customers.customername;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->setScheduler(ParallelScheduler::getFactory());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 213);
+    EXPECT_EQ(result.getRow(0)[0], "Alfreds Futterkiste");
+    EXPECT_EQ(result.getRow(0)[1], "NULL");
+    EXPECT_EQ(result.getRow(212)[0], "Wolski");
+    EXPECT_EQ(result.getRow(212)[1], "10374");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestParallelSchedulerCancellation, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* the first consumer stops after 5 rows, the second one reads all rows */
+  size_t num_rows1 = 0;
+  size_t num_rows2 = 0;
+  auto query = R"(select time from testtable;)";
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan->setScheduler(ParallelScheduler::getFactory());
+  qplan->onOutputRow(0, [&num_rows1] (const SValue* argv, int argc) -> bool {
+    return ++num_rows1 < 5;
+  });
+  qplan->onOutputRow(0, [&num_rows2] (const SValue* argv, int argc) -> bool {
+    ++num_rows2;
+    return true;
+  });
+  qplan->execute();
+  EXPECT_EQ(num_rows1, 5);
+  EXPECT_EQ(num_rows2, 213);
+
+  /* once the only consumer stops, the scan stops as well */
+  size_t num_rows = 0;
+  auto qplan2 = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan2->setScheduler(ParallelScheduler::getFactory());
+  qplan2->onOutputRow(0, [&num_rows] (const SValue* argv, int argc) -> bool {
+    ++num_rows;
+    return false;
+  });
+  qplan2->execute();
+  EXPECT_EQ(num_rows, 1);
+});
+
+TEST_CASE(RuntimeTest, TestParallelSchedulerPropagatesErrors, [] () {
+  /* the error is raised in a worker thread while another statement runs */
+  EXPECT_EXCEPTION("DATE_ADD: invalid expression abc for unit day", [] () {
+    auto runtime = Runtime::getDefaultRuntime();
+    auto ctx = runtime->newTransaction();
+
+    auto estrat = mkRef(new DefaultExecutionStrategy());
+    estrat->addTableProvider(
+        new CSTableScanProvider(
+            "testtable",
+            "src/csql/testdata/testtbl.cst"));
+
+    ResultList result1;
+    ResultList result2;
+    auto query = R"(
+        select count(1) from testtable;
+        select date_add(time, 'abc', 'day') from testtable;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->setScheduler(ParallelScheduler::getFactory());
+    qplan->storeResults(0, &result1);
+    qplan->storeResults(1, &result2);
+    qplan->execute();
+  });
+});
+
+TEST_CASE(RuntimeTest, TestParallelSchedulerIndependentBranches, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "customers",
+          "src/csql/testdata/testtbl2.csv",
+          '\t'));
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  /* each statement is an independent branch of the same task DAG */
+  auto query = R"(
+      select count(1), max(time) from testtable;
+      select customername from customers order by customername;
+      select customerid, count(1) from orders group by customerid;
+      select time from testtable order by time desc limit 10;)";
+
+  auto run = [&runtime, &ctx, &estrat, &query] (
+      SchedulerFactory scheduler,
+      Vector<ScopedPtr<ResultList>>* results) {
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    EXPECT_EQ(qplan->numStatements(), 4);
+    qplan->setScheduler(scheduler);
+    for (size_t i = 0; i < qplan->numStatements(); ++i) {
+      results->emplace_back(new ResultList());
+      qplan->storeResults(i, results->back().get());
+    }
+
+    qplan->execute();
+  };
+
+  Vector<ScopedPtr<ResultList>> expected;
+  run(LocalScheduler::getFactory(), &expected);
+
+  Vector<ScopedPtr<ResultList>> results;
+  run(ParallelScheduler::getFactory(2), &results);
+
+  EXPECT_EQ(expected[0]->getRow(0)[0], "213");
+  EXPECT_EQ(results.size(), expected.size());
+  for (size_t s = 0; s < results.size(); ++s) {
+    EXPECT_TRUE(expected[s]->getNumRows() > 0);
+    EXPECT_EQ(results[s]->getNumRows(), expected[s]->getNumRows());
+
+    /* the group by output order is unspecified */
+    Set<String> expected_rows;
+    Set<String> result_rows;
+    for (size_t i = 0; i < expected[s]->getNumRows(); ++i) {
+      expected_rows.emplace(StringUtil::join(expected[s]->getRow(i), ","));
+      result_rows.emplace(StringUtil::join(results[s]->getRow(i), ","));
+      if (s != 2) {
+        EXPECT_EQ(
+            StringUtil::join(results[s]->getRow(i), ","),
+            StringUtil::join(expected[s]->getRow(i), ","));
+      }
+    }
+
+    EXPECT_TRUE(result_rows == expected_rows);
+  }
+});
+
+TEST_CASE(RuntimeTest, TestEvaluateBatch, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto txn = runtime->newTransaction();
+
+  auto expr = mkRef(
+      new csql::CallExpressionNode(
+          "gt",
+          {
+            new csql::CallExpressionNode(
+                "add",
+                {
+                  new csql::ColumnReferenceNode(size_t(0)),
+                  new csql::ColumnReferenceNode(size_t(1)),
+                }),
+            new csql::LiteralExpressionNode(SValue(SValue::IntegerType(10))),
+          }));
+
+  auto compiled = runtime->queryBuilder()->buildValueExpression(
+      txn.get(),
+      expr.get());
+
+  Vector<SValue> col_a;
+  Vector<SValue> col_b;
+  for (int i = 0; i < 10; ++i) {
+    col_a.emplace_back(SValue::IntegerType(i));
+    col_b.emplace_back(SValue::FloatType(i * 0.5));
+  }
+
+  const SValue* columns[] = { col_a.data(), col_b.data() };
+  Vector<SValue> out(col_a.size(), SValue{});
+  VM::evaluateBatch(
+      txn.get(),
+      compiled.program(),
+      col_a.size(),
+      2,
+      columns,
+      out.data());
+
+  for (int i = 0; i < col_a.size(); ++i) {
+    SValue row[] = { col_a[i], col_b[i] };
+    SValue expected;
+    VM::evaluate(txn.get(), compiled.program(), 2, row, &expected);
+    EXPECT_EQ(out[i].getString(), expected.getString());
+  }
+
+  EXPECT_EQ(out[6].getString(), "false");
+  EXPECT_EQ(out[7].getString(), "true");
+});
+
+TEST_CASE(RuntimeTest, TestEvaluateBatchPreparedCall, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto txn = runtime->newTransaction();
+
+  /* mul with a literal is compiled to a prepared call */
+  auto expr = mkRef(
+      new csql::CallExpressionNode(
+          "mul",
+          {
+            new csql::ColumnReferenceNode(size_t(0)),
+            new csql::LiteralExpressionNode(SValue(SValue::IntegerType(2))),
+          }));
+
+  auto compiled = runtime->queryBuilder()->buildValueExpression(
+      txn.get(),
+      expr.get());
+
+  Vector<SValue> col;
+  for (int i = 0; i < 10; ++i) {
+    col.emplace_back(SValue::IntegerType(i));
+  }
+
+  col.emplace_back(SValue("4"));
+  col.emplace_back(SValue());
+
+  const SValue* columns[] = { col.data() };
+  Vector<SValue> out(col.size(), SValue{});
+  VM::evaluateBatch(
+      txn.get(),
+      compiled.program(),
+      col.size(),
+      1,
+      columns,
+      out.data());
+
+  for (size_t i = 0; i < col.size(); ++i) {
+    SValue expected;
+    VM::evaluate(txn.get(), compiled.program(), 1, &col[i], &expected);
+    EXPECT_EQ(out[i].getString(), expected.getString());
+  }
+
+  EXPECT_EQ(out[9].getString(), "18");
+});
+
+TEST_CASE(RuntimeTest, TestEvaluateBatchShortCircuit, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto txn = runtime->newTransaction();
+
+  auto expr = mkRef(
+      new csql::CallExpressionNode(
+          "logical_or",
+          {
+            new csql::CallExpressionNode(
+                "lt",
+                {
+                  new csql::ColumnReferenceNode(size_t(0)),
+                  new csql::LiteralExpressionNode(
+                      SValue(SValue::IntegerType(3))),
+                }),
+            new csql::CallExpressionNode(
+                "eq",
+                {
+                  new csql::ColumnReferenceNode(size_t(1)),
+                  new csql::LiteralExpressionNode(
+                      SValue(SValue::IntegerType(7))),
+                }),
+          }));
+
+  auto compiled = runtime->queryBuilder()->buildValueExpression(
+      txn.get(),
+      expr.get());
+
+  Vector<SValue> col_a;
+  Vector<SValue> col_b;
+  for (int i = 0; i < 10; ++i) {
+    col_a.emplace_back(SValue::IntegerType(i));
+    col_b.emplace_back(SValue::IntegerType(i));
+  }
+
+  /* the third column isn't read by the expression, so it is never gathered */
+  const SValue* columns[] = { col_a.data(), col_b.data(), nullptr };
+  Vector<SValue> out(col_a.size(), SValue{});
+  VM::evaluateBatch(
+      txn.get(),
+      compiled.program(),
+      col_a.size(),
+      3,
+      columns,
+      out.data());
+
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_EQ(out[i].getString(), (i < 3 || i == 7) ? "true" : "false");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestGroupHashMap, [] () {
+  GroupHashMap groups(2, 1);
+
+  SValue k1[] = { SValue("a"), SValue("bc") };
+  SValue k2[] = { SValue("ab"), SValue("c") };
+  SValue k3[] = { SValue(SValue::IntegerType(13008)), SValue() };
+
+  bool inserted;
+  auto g1 = groups.findOrInsert(k1, &inserted);
+  EXPECT_TRUE(inserted);
+  auto g2 = groups.findOrInsert(k2, &inserted);
+  EXPECT_TRUE(inserted);
+  auto g3 = groups.findOrInsert(k3, &inserted);
+  EXPECT_TRUE(inserted);
+  EXPECT_TRUE(groups.findOrInsert(k1, &inserted) == g1);
+  EXPECT_FALSE(inserted);
+  EXPECT_TRUE(groups.findOrInsert(k3, &inserted) == g3);
+  EXPECT_FALSE(inserted);
+  EXPECT_TRUE(g1 != g2);
+  EXPECT_EQ(groups.size(), 3);
+
+  SValue key[2];
+  groups.getKey(1, key);
+  EXPECT_EQ(key[0].getString(), "ab");
+  EXPECT_EQ(key[1].getString(), "c");
+  groups.getKey(2, key);
+  EXPECT_EQ(key[0].getInteger(), 13008);
+  EXPECT_TRUE(key[1].getType() == SQL_NULL);
+});
+
+TEST_CASE(RuntimeTest, TestHashJoin, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "customers",
+          "src/csql/testdata/testtbl2.csv",
+          '\t'));
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      JOIN orders
+      ON orders.customerid = customers.customerid
+      ORDER BY orders.orderid;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 196);
+    EXPECT_EQ(result.getRow(0)[1], "10248");
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      JOIN orders
+      ON customers.customerid = orders.customerid AND orders.shipperid = 1
+      ORDER BY orders.orderid;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 54);
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      LEFT JOIN orders
+      ON customers.customerid = orders.customerid
+      ORDER BY customers.customername;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 213);
+    EXPECT_EQ(result.getRow(0)[0], "Alfreds Futterkiste");
+    EXPECT_EQ(result.getRow(0)[1], "NULL");
+
+    size_t num_unmatched = 0;
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      if (result.getRow(i)[1] == "NULL") {
+        ++num_unmatched;
+      }
+    }
+
+    EXPECT_EQ(num_unmatched, 17);
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT orders.orderid, customers.customername
+      FROM orders
+      LEFT JOIN customers
+      ON customers.customerid = orders.customerid AND customers.customerid < 4
+      ORDER BY orders.orderid;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 196);
+
+    size_t num_matched = 0;
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      if (result.getRow(i)[1] != "NULL") {
+        ++num_matched;
+      }
+    }
+
+    EXPECT_EQ(num_matched, 2);
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      JOIN orders
+      ON FROM_TIMESTAMP(customers.customerid) = FROM_TIMESTAMP(orders.customerid)
+      ORDER BY orders.orderid;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 196);
+    EXPECT_EQ(result.getRow(0)[1], "10248");
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      JOIN orders
+      ON (customers.customerid = 1) = (orders.shipperid = 1);
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getNumRows(), 54 + 90 * 142);
+  }
+});
+
+TEST_CASE(RuntimeTest, TestOrderByWithLimitAndOffset, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT orderid FROM orders ORDER BY orderid DESC LIMIT 3 OFFSET 2;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 1);
+    EXPECT_EQ(result.getNumRows(), 3);
+    EXPECT_EQ(result.getRow(0)[0], "10441");
+    EXPECT_EQ(result.getRow(1)[0], "10440");
+    EXPECT_EQ(result.getRow(2)[0], "10439");
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT orderid FROM orders ORDER BY orderid ASC LIMIT 500;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumRows(), 196);
+    EXPECT_EQ(result.getRow(0)[0], "10248");
+    EXPECT_EQ(result.getRow(195)[0], "10443");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestExternalOrderBy, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  FileUtil::mkdir_p("build/tests/tmp");
+  runtime->setCacheDir("build/tests/tmp");
+  runtime->setMemoryBudget(1024);
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  ResultList result;
+  auto query = R"(
+    SELECT orderid, customerid FROM orders ORDER BY orderid DESC;
+  )";
+
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan->storeResults(0, &result);
+  qplan->execute();
+  EXPECT_EQ(result.getNumColumns(), 2);
+  EXPECT_EQ(result.getNumRows(), 196);
+  EXPECT_EQ(result.getRow(0)[0], "10443");
+  EXPECT_EQ(result.getRow(1)[0], "10442");
+  EXPECT_EQ(result.getRow(194)[0], "10249");
+  EXPECT_EQ(result.getRow(195)[0], "10248");
+});
+
+TEST_CASE(RuntimeTest, TestSpillingGroupBy, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  FileUtil::mkdir_p("build/tests/tmp");
+  runtime->setCacheDir("build/tests/tmp");
+  runtime->setMemoryBudget(1024);
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  ResultList result;
+  auto query = R"(
+    SELECT customerid, count(1) FROM orders GROUP BY customerid;
+  )";
+
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan->storeResults(0, &result);
+  qplan->execute();
+  EXPECT_EQ(result.getNumColumns(), 2);
+  EXPECT_EQ(result.getNumRows(), 74);
+
+  size_t total = 0;
+  for (size_t i = 0; i < result.getNumRows(); ++i) {
+    total += std::stoull(result.getRow(i)[1]);
+  }
+
+  EXPECT_EQ(total, 196);
+});
+
+TEST_CASE(RuntimeTest, TestSpillingHashJoin, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  FileUtil::mkdir_p("build/tests/tmp");
+  runtime->setCacheDir("build/tests/tmp");
+  runtime->setMemoryBudget(1024);
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "customers",
+          "src/csql/testdata/testtbl2.csv",
+          '\t'));
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "orders",
+          "src/csql/testdata/testtbl3.csv",
+          '\t'));
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      JOIN orders
+      ON orders.customerid = customers.customerid
+      ORDER BY orders.orderid;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumRows(), 196);
+    EXPECT_EQ(result.getRow(0)[1], "10248");
+    EXPECT_EQ(result.getRow(195)[1], "10443");
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+      SELECT customers.customername, orders.orderid
+      FROM customers
+      LEFT JOIN orders
+      ON customers.customerid = orders.customerid
+      ORDER BY customers.customername;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumRows(), 213);
+    EXPECT_EQ(result.getRow(0)[0], "Alfreds Futterkiste");
+    EXPECT_EQ(result.getRow(0)[1], "NULL");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestCSTableColumnStats, [] () {
+  CSTableColumnStats stats(SQL_INTEGER);
+
+  CSTableColumnStats::Block b1(0, 3);
+  b1.addValue(SValue(SValue::IntegerType(10)), SQL_INTEGER);
+  b1.addValue(SValue(SValue::IntegerType(20)), SQL_INTEGER);
+  b1.addValue(SValue(SValue::IntegerType(15)), SQL_INTEGER);
+  stats.addBlock(b1);
+
+  CSTableColumnStats::Block b2(3, 5);
+  b2.addValue(SValue(SValue::IntegerType(13008)), SQL_INTEGER);
+  b2.addValue(SValue(), SQL_INTEGER);
+  stats.addBlock(b2);
+
+  const auto& blocks = stats.blocks();
+  EXPECT_EQ(blocks.size(), 2);
+  EXPECT_EQ(blocks[0].min.getInteger(), 10);
+  EXPECT_EQ(blocks[0].max.getInteger(), 20);
+
+  ScanConstraint c;
+  c.column_name = "shop_id";
+  c.type = ScanConstraintType::EQUAL_TO;
+  c.value = SValue(SValue::IntegerType(13008));
+  EXPECT_FALSE(stats.mayMatch(blocks[0], c));
+  EXPECT_TRUE(stats.mayMatch(blocks[1], c));
+
+  c.type = ScanConstraintType::GREATER_THAN_OR_EQUAL_TO;
+  c.value = SValue(SValue::FloatType(20.5));
+  EXPECT_FALSE(stats.mayMatch(blocks[0], c));
+  EXPECT_TRUE(stats.mayMatch(blocks[1], c));
+
+  /* NULL compares like zero in lt */
+  c.type = ScanConstraintType::LESS_THAN;
+  c.value = SValue(SValue::IntegerType(5));
+  EXPECT_FALSE(stats.mayMatch(blocks[0], c));
+  EXPECT_TRUE(stats.mayMatch(blocks[1], c));
+
+  c.type = ScanConstraintType::NOT_EQUAL_TO;
+  EXPECT_TRUE(stats.mayMatch(blocks[0], c));
+});
+
+TEST_CASE(RuntimeTest, TestCSTableScanSkipsBlocks, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* 213 records in blocks of 16 records */
+  RefPtr<CSTableColumnStatsCache> stats_cache(new CSTableColumnStatsCache(16));
+
+  auto run_scan = [&runtime, &ctx, &estrat, &stats_cache] (
+      const String& query,
+      size_t* rows_scanned) -> String {
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    auto seqscan = qplan->getStatementQTree(0)
+        .asInstanceOf<SequentialScanNode>();
+
+    String result;
+    CSTableScan scan(
+        ctx.get(),
+        seqscan,
+        "src/csql/testdata/testtbl.cst",
+        runtime->queryBuilder().get(),
+        [&result] (const SValue* row, int row_len) -> bool {
+          result = row[0].getString();
+          return true;
+        });
+
+    scan.setColumnStatsCache(stats_cache);
+    scan.onInputsReady();
+    *rows_scanned = scan.rowsScanned();
+    return result;
+  };
+
+  size_t rows_scanned;
+  EXPECT_EQ(
+      run_scan(
+          "SELECT count(1) FROM testtable WHERE time < 0 AND time > 0;",
+          &rows_scanned),
+      "0");
+  EXPECT_EQ(rows_scanned, 0);
+
+  auto stats = stats_cache->get("time", SQL_TIMESTAMP);
+  EXPECT_FALSE(stats.isEmpty());
+  const auto& blocks = stats.get()->blocks();
+  EXPECT_EQ(blocks.size(), 14);
+
+  /* only the blocks that contain the latest time can match */
+  uint64_t max_time = 0;
+  for (const auto& block : blocks) {
+    if (block.has_values && block.max.getInteger() > max_time) {
+      max_time = block.max.getInteger();
+    }
+  }
+
+  size_t expected_rows_scanned = 0;
+  for (const auto& block : blocks) {
+    if (block.has_values && block.max.getInteger() == max_time) {
+      expected_rows_scanned += block.end - block.begin;
+    }
+  }
+
+  auto query = StringUtil::format(
+      "SELECT count(1) FROM testtable WHERE time >= $0;",
+      max_time);
+
+  ResultList expected;
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan->storeResults(0, &expected);
+  qplan->execute();
+  EXPECT_EQ(expected.getNumRows(), 1);
+
+  EXPECT_EQ(run_scan(query, &rows_scanned), expected.getRow(0)[0]);
+  EXPECT_EQ(rows_scanned, expected_rows_scanned);
+  EXPECT_TRUE(rows_scanned > 0);
+  EXPECT_TRUE(rows_scanned < 213);
+});
+
+TEST_CASE(RuntimeTest, TestCSTableColumnStatsSidecarFile, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  FileUtil::mkdir_p("build/tests/tmp");
+  String sidecar_file = "build/tests/tmp/testtbl.cst.stats";
+  if (FileUtil::exists(sidecar_file)) {
+    FileUtil::rm(sidecar_file);
+  }
+
+  {
+    auto provider = new CSTableScanProvider(
+        "testtable",
+        "src/csql/testdata/testtbl.cst");
+    provider->setColumnStatsFile(sidecar_file);
+
+    auto estrat = mkRef(new DefaultExecutionStrategy());
+    estrat->addTableProvider(provider);
+
+    ResultList result;
+    auto query = R"(
+      SELECT count(1) FROM testtable WHERE time > 1438048800000000;
+    )";
+
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumRows(), 1);
+  }
+
+  EXPECT_TRUE(FileUtil::exists(sidecar_file));
+
+  {
+    RefPtr<CSTableColumnStatsCache> cache(new CSTableColumnStatsCache());
+    cache->setSidecarFile(sidecar_file, "src/csql/testdata/testtbl.cst");
+
+    auto stats = cache->get("time", SQL_TIMESTAMP);
+    EXPECT_FALSE(stats.isEmpty());
+    EXPECT_EQ(stats.get()->blocks().size(), 1);
+    EXPECT_EQ(stats.get()->blocks()[0].begin, 0);
+    EXPECT_EQ(stats.get()->blocks()[0].end, 213);
+    EXPECT_TRUE(stats.get()->blocks()[0].has_values);
+  }
+
+  /* stats that were computed for a different block size are ignored */
+  {
+    RefPtr<CSTableColumnStatsCache> cache(new CSTableColumnStatsCache(16));
+    cache->setSidecarFile(sidecar_file, "src/csql/testdata/testtbl.cst");
+    EXPECT_TRUE(cache->get("time", SQL_TIMESTAMP).isEmpty());
+  }
+});
+
+TEST_CASE(RuntimeTest, TestCSTableColumnStatsCacheChecksFile, [] () {
+  RefPtr<CSTableColumnStatsCache> cache(new CSTableColumnStatsCache(16));
+  cache->checkFile("src/csql/testdata/testtbl.cst", 213);
+  cache->put("time", new CSTableColumnStats(SQL_TIMESTAMP));
+  EXPECT_FALSE(cache->get("time", SQL_TIMESTAMP).isEmpty());
+
+  cache->checkFile("src/csql/testdata/testtbl.cst", 213);
+  EXPECT_FALSE(cache->get("time", SQL_TIMESTAMP).isEmpty());
+
+  /* stats of a file whose number of records changed are dropped */
+  cache->checkFile("src/csql/testdata/testtbl.cst", 214);
+  EXPECT_TRUE(cache->get("time", SQL_TIMESTAMP).isEmpty());
+
+  /* as are stats of a file whose size or mtime changed */
+  cache->put("time", new CSTableColumnStats(SQL_TIMESTAMP));
+  cache->checkFile("src/csql/testdata/testtbl2.csv", 214);
+  EXPECT_TRUE(cache->get("time", SQL_TIMESTAMP).isEmpty());
+
+  EXPECT_EXCEPTION("file not found: 'build/tests/missing.cst'", [] () {
+    RefPtr<CSTableColumnStatsCache> cache(new CSTableColumnStatsCache());
+    cache->checkFile("build/tests/missing.cst", 0);
+  });
+});
+
+TEST_CASE(RuntimeTest, TestSValueStringCopies, [] () {
+  SValue short_str("short");
+  SValue long_str("a string that is too long to be stored inline");
+  SValue empty_str("");
+
+  {
+    SValue copy(long_str);
+    SValue assigned;
+    assigned = copy;
+    EXPECT_EQ(copy.getString(), long_str.getString());
+    EXPECT_EQ(assigned.getString(), long_str.getString());
+    EXPECT_TRUE(assigned == long_str);
+  }
+
+  EXPECT_EQ(long_str.getString(), "a string that is too long to be stored inline");
+
+  SValue moved(std::move(long_str));
+  EXPECT_TRUE(long_str.getType() == SQL_NULL);
+  EXPECT_EQ(moved.getStringSize(), 45);
+
+  moved = short_str;
+  EXPECT_EQ(moved.getString(), "short");
+  EXPECT_FALSE(moved == SValue("shorter"));
+  EXPECT_EQ(empty_str.getString(), "");
+});
+
+TEST_CASE(RuntimeTest, TestRegexPattern, [] () {
+  EXPECT_TRUE(RegexPattern("bar").match("foobarbaz"));
+  EXPECT_FALSE(RegexPattern("bar").match("foobaz"));
+  EXPECT_TRUE(RegexPattern("^foo").match("foobar"));
+  EXPECT_FALSE(RegexPattern("^foo").match("barfoo"));
+  EXPECT_TRUE(RegexPattern("bar$").match("foobar"));
+  EXPECT_TRUE(RegexPattern("bar$").match("foobar\n"));
+  EXPECT_FALSE(RegexPattern("bar$").match("barfoo"));
+  EXPECT_TRUE(RegexPattern("^foo$").match("foo"));
+  EXPECT_FALSE(RegexPattern("^foo$").match("foofoo"));
+  EXPECT_TRUE(RegexPattern("a\\.b").match("xa.by"));
+  EXPECT_FALSE(RegexPattern("a\\.b").match("xaxby"));
+  EXPECT_TRUE(RegexPattern("chrome|firefox").match("mozilla firefox"));
+  EXPECT_FALSE(RegexPattern("chrome|firefox").match("safari"));
+
+  RegexPattern generic("/products/[0-9]+\\.html");
+  EXPECT_EQ(generic.requiredLiteral(), "/products/");
+  EXPECT_TRUE(generic.match("GET /products/123.html"));
+  EXPECT_FALSE(generic.match("GET /products/abc.html"));
+  EXPECT_FALSE(generic.match("GET /cart"));
+
+  EXPECT_EQ(RegexPattern("ab?cdef").requiredLiteral(), "cdef");
+  EXPECT_EQ(RegexPattern("(abcdef)?x").requiredLiteral(), "x");
+  EXPECT_EQ(RegexPattern("(?i)abc").requiredLiteral(), "");
+
+  /* the arguments of alphanumeric escapes aren't part of the literal */
+  EXPECT_EQ(RegexPattern("\\x41BC").requiredLiteral(), "BC");
+  EXPECT_EQ(RegexPattern("\\x{41}BC").requiredLiteral(), "BC");
+  EXPECT_EQ(RegexPattern("\\101").requiredLiteral(), "");
+  EXPECT_EQ(RegexPattern("\\cA").requiredLiteral(), "");
+  EXPECT_EQ(RegexPattern("\\p{Lu}x").requiredLiteral(), "x");
+  EXPECT_EQ(RegexPattern("\\pLx").requiredLiteral(), "x");
+  EXPECT_EQ(RegexPattern("(a)\\g{1}bc").requiredLiteral(), "bc");
+  EXPECT_EQ(RegexPattern("(a)x\\g{1}").requiredLiteral(), "x");
+  EXPECT_EQ(RegexPattern("\\Qa.b\\E").requiredLiteral(), "");
+  EXPECT_TRUE(RegexPattern("\\x41BC").match("xABC"));
+  EXPECT_FALSE(RegexPattern("\\x41BC").match("x41BC"));
+  EXPECT_TRUE(RegexPattern("\\101").match("A"));
+  EXPECT_TRUE(RegexPattern("\\cA").match(String("\x01", 1)));
+  EXPECT_FALSE(RegexPattern("\\cA").match("A"));
+});
+
+TEST_CASE(RuntimeTest, TestShortCircuitLogicalOperators, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("1 = 1 AND 2 > 1 AND 'abc' REGEXP 'b'"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("1 = 1 AND 2 < 1"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("1 = 2 OR 2 > 1"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("1 = 2 OR 2 < 1"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("1 = 1 OR date_trunc('fortnight', 0) = 0"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  /* the cheaper conjunct is evaluated first, even if it comes last */
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("date_trunc('fortnight', 0) = 0 AND 1 = 2"));
+    EXPECT_EQ(v.getString(), "false");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestExtractSharedExpressions, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  RefPtr<ValueExpressionNode> bucket = new CallExpressionNode(
+      "date_trunc",
+      Vector<RefPtr<ValueExpressionNode>> {
+        new LiteralExpressionNode(SValue("1h")),
+        new ColumnReferenceNode(2)
+      });
+
+  Vector<RefPtr<ValueExpressionNode>> exprs;
+  exprs.emplace_back(bucket);
+  exprs.emplace_back(
+      new CallExpressionNode(
+          "count",
+          Vector<RefPtr<ValueExpressionNode>> {
+            bucket->deepCopyAs<ValueExpressionNode>()
+          }));
+  exprs.emplace_back(bucket->deepCopyAs<ValueExpressionNode>());
+  exprs.emplace_back(new ColumnReferenceNode(0));
+
+  size_t input_width;
+  Vector<size_t> num_required;
+  auto shared = QueryTreeUtil::extractSharedExpressions(
+      ctx.get(),
+      &exprs,
+      &input_width,
+      &num_required);
+
+  EXPECT_EQ(input_width, 3);
+  EXPECT_EQ(shared.size(), 1);
+  EXPECT_EQ(shared[0]->toSQL(), bucket->toSQL());
+  EXPECT_EQ(exprs[0]->toSQL(), "subquery_column(3)");
+  EXPECT_EQ(exprs[1]->toSQL(), "count(subquery_column(3))");
+  EXPECT_EQ(exprs[2]->toSQL(), "subquery_column(3)");
+  EXPECT_EQ(exprs[3]->toSQL(), "subquery_column(0)");
+  EXPECT_EQ(num_required[0], 1);
+  EXPECT_EQ(num_required[3], 1);
+});
+
+TEST_CASE(RuntimeTest, TestGroupByWithSharedExpressions, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  ResultList result;
+  auto query = R"(select TRUNCATE(time / 60000000) as t, count(1) from testtable group by TRUNCATE(time / 60000000);)";
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+  qplan->storeResults(0, &result);
+  qplan->execute();
+  EXPECT_EQ(result.getNumColumns(), 2);
+  EXPECT_EQ(result.getNumRows(), 129);
+});
+
+TEST_CASE(RuntimeTest, TestPreparedFunctions, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  {
+    SValue lit(SValue::IntegerType(3));
+    const SValue* literals[2] = { nullptr, &lit };
+    ScopedPtr<PreparedFunction> fn(expressions::mulExprPrepare(2, literals));
+    EXPECT_TRUE(fn.get() != nullptr);
+
+    SValue out;
+    SValue args[2] = { SValue(SValue::IntegerType(7)), lit };
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_EQ(out.getType(), SQL_INTEGER);
+    EXPECT_EQ(out.getInteger(), 21);
+
+    args[0] = SValue(SValue::FloatType(0.5));
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_EQ(out.getType(), SQL_FLOAT);
+    EXPECT_EQ(out.getFloat(), 1.5);
+
+    args[0] = SValue();
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_EQ(out.getType(), SQL_NULL);
+  }
+
+  {
+    SValue lit(SValue::IntegerType(10));
+    const SValue* literals[2] = { &lit, nullptr };
+    ScopedPtr<PreparedFunction> fn(expressions::subExprPrepare(2, literals));
+
+    SValue out;
+    SValue args[2] = { lit, SValue(SValue::IntegerType(4)) };
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_EQ(out.getInteger(), 6);
+  }
+
+  {
+    SValue lit("fnord");
+    const SValue* literals[2] = { nullptr, &lit };
+    EXPECT_TRUE(expressions::addExprPrepare(2, literals) == nullptr);
+  }
+
+  {
+    SValue lit("http");
+    const SValue* literals[2] = { nullptr, &lit };
+    ScopedPtr<PreparedFunction> fn(
+        expressions::startsWithExprPrepare(2, literals));
+
+    SValue out;
+    SValue args[2] = { SValue("http://example.com/"), lit };
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_TRUE(out.getBool());
+
+    args[0] = SValue("ftp://example.com/");
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_FALSE(out.getBool());
+
+    args[0] = SValue("htt");
+    fn->call(Transaction::get(ctx.get()), 2, args, &out);
+    EXPECT_FALSE(out.getBool());
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("endswith('index.html', '.html')"));
+    EXPECT_EQ(v.getString(), "true");
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("round(3.14159, 2)"));
+    EXPECT_TRUE(v.getFloat() > 3.139999 && v.getFloat() < 3.140001);
+  }
+
+  {
+    auto v = runtime->evaluateConstExpression(
+        ctx.get(),
+        String("round(2.6)"));
+    EXPECT_EQ(v.getInteger(), 3);
+  }
+});
+
+TEST_CASE(RuntimeTest, TestBroadcastSink, [] () {
+  Vector<String> out1;
+  Vector<String> out2;
+
+  RefPtr<BroadcastSink> broadcast(new BroadcastSink(2));
+  broadcast->addOutput([&out1] (const SValue* argv, int argc) -> bool {
+    out1.emplace_back(argv[0].getString());
+    return out1.size() < 2;
+  });
+  broadcast->addOutput([&out2] (const SValue* argv, int argc) -> bool {
+    out2.emplace_back(argv[0].getString());
+    return true;
+  });
+
+  auto sink = broadcast->getSinkFn();
+  for (int i = 0; i < 5; ++i) {
+    SValue val(SValue::IntegerType(i));
+    EXPECT_TRUE(sink(&val, 1));
+  }
+
+  EXPECT_TRUE(broadcast->flush());
+  EXPECT_EQ(out1.size(), 2);
+  EXPECT_EQ(out2.size(), 5);
+  EXPECT_EQ(out2[4], "4");
+});
+
+TEST_CASE(RuntimeTest, TestPartitionSink, [] () {
+  Vector<String> out0;
+  Vector<String> out1;
+
+  RefPtr<PartitionSink> partitions(new PartitionSink(2));
+  partitions->addOutput(1, [&out1] (const SValue* argv, int argc) -> bool {
+    EXPECT_EQ(argc, 1);
+    out1.emplace_back(argv[0].getString());
+    return out1.size() < 2;
+  });
+  partitions->addOutput(0, [&out0] (const SValue* argv, int argc) -> bool {
+    EXPECT_EQ(argc, 1);
+    out0.emplace_back(argv[0].getString());
+    return true;
+  });
+
+  /* each row only goes to the output of its partition */
+  auto sink = partitions->getSinkFn();
+  for (int i = 0; i < 8; ++i) {
+    SValue row[2] = {
+      SValue(SValue::IntegerType(i % 2)),
+      SValue(SValue::IntegerType(i))
+    };
+
+    EXPECT_TRUE(sink(row, 2));
+  }
+
+  EXPECT_TRUE(partitions->flush());
+  EXPECT_EQ(out0.size(), 4);
+  EXPECT_EQ(out0[3], "6");
+  EXPECT_EQ(out1.size(), 2);
+  EXPECT_EQ(out1[1], "3");
+
+  EXPECT_EXCEPTION("no output for partition 2", [] () {
+    RefPtr<PartitionSink> partitions(new PartitionSink());
+    partitions->addOutput(0, [] (const SValue* argv, int argc) -> bool {
+      return true;
+    });
+
+    SValue row[2] = { SValue(SValue::IntegerType(2)), SValue() };
+    partitions->onRow(row, 2);
+  });
+});
+
+TEST_CASE(RuntimeTest, TestSharedSequentialScan, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new backends::csv::CSVTableProvider(
+          "customers",
+          "src/csql/testdata/testtbl2.csv",
+          '\t'));
+
+  auto query = R"(
+    SELECT customername FROM customers ORDER BY customername ASC;
+    SELECT customername FROM customers ORDER BY customername DESC;
+  )";
+
+  for (int i = 0; i < 2; ++i) {
+    ResultList result1;
+    ResultList result2;
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    if (i > 0) {
+      qplan->setScheduler(ParallelScheduler::getFactory());
+    }
+
+    qplan->storeResults(0, &result1);
+    qplan->storeResults(1, &result2);
+    qplan->execute();
+
+    auto nrows = result1.getNumRows();
+    EXPECT_TRUE(nrows > 0);
+    EXPECT_EQ(result2.getNumRows(), nrows);
+    EXPECT_EQ(result1.getRow(0)[0], "Alfreds Futterkiste");
+    EXPECT_EQ(result2.getRow(nrows - 1)[0], "Alfreds Futterkiste");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestTaskResultCache, [] () {
+  auto cache_dir = FileUtil::joinPaths(
+      "build/tests/tmp",
+      StringUtil::format("taskcache_$0", Random::singleton()->hex64()));
+
+  auto runtime = Runtime::getDefaultRuntime();
+  FileUtil::mkdir_p(cache_dir);
+  runtime->enableResultCache(cache_dir);
+  auto ctx = runtime->newTransaction();
+
+  auto provider = mkRef(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+  provider->setCacheKey(SHA1::compute("testtbl.cst"));
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(provider.get());
+
+  /* the first run stores the scan result, the second one replays it */
+  for (int i = 0; i < 2; ++i) {
+    ResultList result;
+    auto query = R"(select count(1) from testtable;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumRows(), 1);
+    EXPECT_EQ(result.getRow(0)[0], "213");
+
+    size_t num_cached = 0;
+    FileUtil::ls(cache_dir, [&num_cached] (const String& file) -> bool {
+      if (StringUtil::endsWith(file, ".cache")) {
+        ++num_cached;
+      }
+
+      return true;
+    });
+
+    EXPECT_EQ(num_cached, 1);
+  }
+
+  /* the result cache is opt-in, the runtime's cache dir doesn't enable it */
+  {
+    auto runtime2 = Runtime::getDefaultRuntime();
+    runtime2->setCacheDir(cache_dir);
+    EXPECT_TRUE(runtime2->resultCache().get() == nullptr);
+  }
+});
+
+TEST_CASE(RuntimeTest, TestResultCacheEviction, [] () {
+  auto cache_dir = FileUtil::joinPaths(
+      "build/tests/tmp",
+      StringUtil::format("resultcache_$0", Random::singleton()->hex64()));
+
+  FileUtil::mkdir_p(cache_dir);
+
+  auto store = [] (ResultCache* cache, const String& key, size_t size) {
+    auto key_hash = SHA1::compute(key);
+    auto tmpfile = cache->getTempFilename(key_hash);
+    String data(size, 'x');
+    {
+      auto file = FileOutputStream::openFile(tmpfile);
+      file->write(data.data(), data.size());
+    }
+
+    cache->storeResult(key_hash, tmpfile, data.size());
+  };
+
+  auto is_cached = [] (ResultCache* cache, const String& key) -> bool {
+    return cache->openResult(SHA1::compute(key)).get() != nullptr;
+  };
+
+  {
+    RefPtr<ResultCache> cache(new ResultCache(cache_dir, 100));
+    store(cache.get(), "a", 40);
+    store(cache.get(), "b", 40);
+    EXPECT_EQ(cache->size(), 80);
+
+    /* "a" was used more recently than "b", so "b" is evicted */
+    EXPECT_TRUE(is_cached(cache.get(), "a"));
+    store(cache.get(), "c", 40);
+    EXPECT_EQ(cache->size(), 80);
+    EXPECT_TRUE(is_cached(cache.get(), "a"));
+    EXPECT_FALSE(is_cached(cache.get(), "b"));
+    EXPECT_TRUE(is_cached(cache.get(), "c"));
+
+    /* results larger than the cache are not stored */
+    store(cache.get(), "d", 101);
+    EXPECT_FALSE(is_cached(cache.get(), "d"));
+    EXPECT_EQ(cache->size(), 80);
+  }
+
+  /* stored results are picked up again and trimmed to the new budget */
+  {
+    RefPtr<ResultCache> cache(new ResultCache(cache_dir, 50));
+    EXPECT_EQ(cache->size(), 40);
+  }
+
+  size_t num_files = 0;
+  FileUtil::ls(cache_dir, [&num_files] (const String& file) -> bool {
+    ++num_files;
+    return true;
+  });
+
+  EXPECT_EQ(num_files, 1);
+});
+
+TEST_CASE(RuntimeTest, TestLimitStopsUpstream, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  {
+    size_t num_rows = 0;
+    Limit limit(2, 1, [&num_rows] (const SValue* argv, int argc) -> bool {
+      ++num_rows;
+      return true;
+    });
+
+    TaskID input_id;
+    SValue val(SValue::IntegerType(1));
+    EXPECT_TRUE(limit.onInputRow(input_id, &val, 1));
+    EXPECT_TRUE(limit.onInputRow(input_id, &val, 1));
+    EXPECT_FALSE(limit.onInputRow(input_id, &val, 1));
+    EXPECT_FALSE(limit.onInputRow(input_id, &val, 1));
+    EXPECT_EQ(num_rows, 2);
+  }
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  ResultList result;
+  auto query = R"(select time from testtable limit 10 offset 5;)";
+  auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+
+  auto limit_node = qplan->getStatementQTree(0).asInstanceOf<LimitNode>();
+  auto seqscan = limit_node->inputTable().asInstanceOf<SequentialScanNode>();
+  EXPECT_FALSE(seqscan->limit().isEmpty());
+  EXPECT_EQ(seqscan->limit().get(), 15);
+
+  qplan->storeResults(0, &result);
+  qplan->execute();
+  EXPECT_EQ(result.getNumColumns(), 1);
+  EXPECT_EQ(result.getNumRows(), 10);
+});
+
+TEST_CASE(RuntimeTest, TestGroupByWithHaving, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  {
+    ResultList result;
+    auto query = R"(
+        select count(1) from testtable
+        group by TRUNCATE(time / 2000000)
+        having count(1) > 1;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 1);
+    EXPECT_EQ(result.getNumRows(), 1);
+    EXPECT_EQ(result.getRow(0)[0], "2");
+  }
+
+  {
+    ResultList result;
+    auto query = R"(
+        select count(1) from testtable
+        group by TRUNCATE(time / 2000000)
+        having count(1) > 1 AND TRUNCATE(time / 2000000) > 0;)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+
+    auto group_by = qplan->getStatementQTree(0).asInstanceOf<GroupByNode>();
+    EXPECT_FALSE(group_by->havingExpression().isEmpty());
+    auto seqscan = group_by->inputTable().asInstanceOf<SequentialScanNode>();
+    EXPECT_FALSE(seqscan->whereExpression().isEmpty());
+
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 1);
+    EXPECT_EQ(result.getNumRows(), 1);
+    EXPECT_EQ(result.getRow(0)[0], "2");
+  }
+});
+
+TEST_CASE(RuntimeTest, TestPartitionedGroupBy, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto serial = mkRef(new DefaultExecutionStrategy());
+  serial->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* 213 records in 4 partitions of at least 16 records */
+  auto parallel_provider = new CSTableScanProvider(
+      "testtable",
+      "src/csql/testdata/testtbl.cst");
+  parallel_provider->setScanParallelism(4, 16);
+
+  auto parallel = mkRef(new DefaultExecutionStrategy());
+  parallel->addTableProvider(parallel_provider);
+
+  {
+    auto query = R"(
+        select count(1) from testtable
+        group by TRUNCATE(time / 600000000);)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, parallel.get());
+
+    auto group_by = qplan->getStatementQTree(0).asInstanceOf<GroupByNode>();
+    auto seqscan = group_by->inputTable().asInstanceOf<SequentialScanNode>();
+    EXPECT_TRUE(seqscan->isPartitionable());
+
+    /* 4 scans, 4 partial group bys and 4 merges */
+    TaskDAG tasks;
+    auto output = group_by->build(ctx.get(), &tasks);
+    EXPECT_EQ(output.size(), 4);
+    EXPECT_EQ(tasks.getNumTasks(), 12);
+
+    /* each merge receives one partition of every partial group by */
+    Set<size_t> partitions;
+    for (const auto& merge_id : output) {
+      auto deps = tasks.getTask(merge_id)->getDependencies();
+      EXPECT_EQ(deps.size(), 4);
+      for (const auto& dep : deps) {
+        EXPECT_FALSE(dep.partition.isEmpty());
+        EXPECT_EQ(dep.partition.get(), deps[0].partition.get());
+      }
+
+      partitions.emplace(deps[0].partition.get());
+    }
+
+    EXPECT_EQ(partitions.size(), 4);
+  }
+
+  auto query = R"(
+      select
+          TRUNCATE(time / 600000000) as t,
+          count(1),
+          count(event.search_query.time),
+          sum(TRUNCATE(time / 1000000)),
+          avg(TRUNCATE(time / 1000000)),
+          min(time),
+          max(time)
+      from testtable
+      group by TRUNCATE(time / 600000000)
+      having count(1) > 1
+      order by t asc;)";
+
+  ResultList expected;
+  auto expected_qplan = runtime->buildQueryPlan(
+      ctx.get(),
+      query,
+      serial.get());
+  expected_qplan->storeResults(0, &expected);
+  expected_qplan->execute();
+  EXPECT_TRUE(expected.getNumRows() > 1);
+
+  Vector<SchedulerFactory> schedulers = {
+    LocalScheduler::getFactory(),
+    ParallelScheduler::getFactory()
+  };
+
+  for (const auto& scheduler : schedulers) {
+    ResultList result;
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, parallel.get());
+    qplan->setScheduler(scheduler);
+    qplan->storeResults(0, &result);
+    qplan->execute();
+
+    EXPECT_EQ(result.getNumColumns(), expected.getNumColumns());
+    EXPECT_EQ(result.getNumRows(), expected.getNumRows());
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      for (size_t j = 0; j < result.getNumColumns(); ++j) {
+        EXPECT_EQ(result.getRow(i)[j], expected.getRow(i)[j]);
+      }
+    }
+  }
+});
+
+TEST_CASE(RuntimeTest, TestGroupOverTimewindow, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  {
+    ResultList result;
+    auto query = R"(
+        select count(1) from testtable
+        GROUP OVER TIMEWINDOW(time, 1000000000);)";
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+
+    auto group_by = qplan->getStatementQTree(0)
+        .asInstanceOf<GroupOverTimewindowNode>();
+    EXPECT_EQ(group_by->window(), 1000000000 * kMicrosPerSecond);
+    EXPECT_EQ(group_by->step(), 1000000000 * kMicrosPerSecond);
+    EXPECT_FALSE(group_by->isInputOrdered());
+
+    qplan->storeResults(0, &result);
+    qplan->execute();
+    EXPECT_EQ(result.getNumColumns(), 2);
+    EXPECT_EQ(result.getColumns()[0], "window_start");
+    EXPECT_EQ(result.getNumRows(), 1);
+    EXPECT_EQ(
+        result.getRow(0)[0],
+        SValue(SValue::TimeType(1000000000 * kMicrosPerSecond)).getString());
+    EXPECT_EQ(result.getRow(0)[1], "213");
+  }
+
+  /* the result is the same for ordered and unordered input */
+  for (const auto& order : Vector<String>{ "asc", "desc" }) {
+    ResultList expected;
+    auto expected_query = R"(
+        select count(1), min(time)
+        from (select time from testtable order by time asc)
+        group by TRUNCATE(time / 2000000);)";
+    auto expected_qplan = runtime->buildQueryPlan(
+        ctx.get(),
+        expected_query,
+        estrat.get());
+    expected_qplan->storeResults(0, &expected);
+    expected_qplan->execute();
+
+    ResultList result;
+    auto query = StringUtil::format(
+        R"(
+            select count(1), min(time)
+            from (select time from testtable order by time $0)
+            GROUP OVER TIMEWINDOW(time, 2);)",
+        order);
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, estrat.get());
+    EXPECT_EQ(
+        qplan->getStatementQTree(0)
+            .asInstanceOf<GroupOverTimewindowNode>()
+            ->isInputOrdered(),
+        order == "asc");
+
+    qplan->storeResults(0, &result);
+    qplan->execute();
+
+    EXPECT_EQ(result.getNumRows(), expected.getNumRows());
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      EXPECT_EQ(result.getRow(i)[1], expected.getRow(i)[0]);
+      EXPECT_EQ(result.getRow(i)[2], expected.getRow(i)[1]);
+    }
+  }
+
+  /* unordered input: every window is emitted exactly once, after the input
+     is complete */
+  {
+    Vector<RefPtr<SelectListNode>> select_list;
+    select_list.emplace_back(
+        new SelectListNode(
+            new CallExpressionNode(
+                "count",
+                Vector<RefPtr<ValueExpressionNode>> {
+                  new LiteralExpressionNode(SValue(SValue::IntegerType(1)))
+                })));
+
+    for (auto ordered : Vector<bool>{ false, true }) {
+      GroupOverTimewindowFactory factory(
+          select_list,
+          Vector<RefPtr<ValueExpressionNode>>{},
+          None<RefPtr<ValueExpressionNode>>(),
+          new ColumnReferenceNode(0),
+          10,
+          10,
+          ordered);
+
+      Vector<String> rows;
+      auto task = factory.build(
+          ctx.get(),
+          [&rows] (const SValue* argv, int argc) -> bool {
+            EXPECT_EQ(argc, 2);
+            rows.emplace_back(
+                StringUtil::format(
+                    "$0:$1",
+                    argv[0].getTimestamp().unixMicros(),
+                    argv[1].getString()));
+            return true;
+          });
+
+      TaskID input_id;
+      if (ordered) {
+        for (uint64_t t : Vector<uint64_t>{ 3, 5, 15, 25, 26 }) {
+          SValue time(SValue::TimeType(t));
+          EXPECT_TRUE(task->onInputRow(input_id, &time, 1));
+        }
+
+        /* the windows starting at 0 and 10 are complete */
+        EXPECT_EQ(rows.size(), 2);
+
+        SValue late(SValue::TimeType(4));
+        EXPECT_EXCEPTION("TIMEWINDOW input is not ordered by time", [&] () {
+          task->onInputRow(input_id, &late, 1);
+        });
+      } else {
+        for (uint64_t t : Vector<uint64_t>{ 5, 15, 25, 3, 26 }) {
+          SValue time(SValue::TimeType(t));
+          EXPECT_TRUE(task->onInputRow(input_id, &time, 1));
+        }
+
+        EXPECT_EQ(rows.size(), 0);
+      }
+
+      task->onInputsReady();
+
+      EXPECT_EQ(rows.size(), 3);
+      EXPECT_EQ(rows[0], "0:2");
+      EXPECT_EQ(rows[1], "10:1");
+      EXPECT_EQ(rows[2], "20:2");
+    }
+  }
+});
+
+TEST_CASE(RuntimeTest, TestCSTableParallelScan, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto serial = mkRef(new DefaultExecutionStrategy());
+  serial->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* 213 records in morsels of at least 16 records */
+  auto parallel_provider = new CSTableScanProvider(
+      "testtable",
+      "src/csql/testdata/testtbl.cst");
+  parallel_provider->setScanParallelism(4, 16);
+
+  auto parallel = mkRef(new DefaultExecutionStrategy());
+  parallel->addTableProvider(parallel_provider);
+
+  Vector<String> queries = {
+    R"(select count(1), count(time), min(time), max(time),
+          count(event.search_query.time)
+       from testtable;)",
+    R"(select count(time), sum(event.search_query.num_result_items)
+       from testtable where time > 1438048800000000;)",
+    R"(select time, event.search_query.time from testtable;)"
+  };
+
+  for (const auto& query : queries) {
+    ResultList expected;
+    auto expected_qplan = runtime->buildQueryPlan(
+        ctx.get(),
+        query,
+        serial.get());
+    expected_qplan->storeResults(0, &expected);
+    expected_qplan->execute();
+
+    ResultList result;
+    auto qplan = runtime->buildQueryPlan(ctx.get(), query, parallel.get());
+    qplan->storeResults(0, &result);
+    qplan->execute();
+
+    EXPECT_TRUE(expected.getNumRows() > 0);
+    EXPECT_EQ(result.getNumColumns(), expected.getNumColumns());
+    EXPECT_EQ(result.getNumRows(), expected.getNumRows());
+    for (size_t i = 0; i < result.getNumRows(); ++i) {
+      for (size_t j = 0; j < result.getNumColumns(); ++j) {
+        EXPECT_EQ(result.getRow(i)[j], expected.getRow(i)[j]);
+      }
+    }
+  }
+});
+
+TEST_CASE(RuntimeTest, TestBinaryResultFormatRoundTrip, [] () {
+  auto runtime = Runtime::getDefaultRuntime();
+  auto ctx = runtime->newTransaction();
+
+  auto estrat = mkRef(new DefaultExecutionStrategy());
+  estrat->addTableProvider(
+      new CSTableScanProvider(
+          "testtable",
+          "src/csql/testdata/testtbl.cst"));
+
+  /* the "mixed" column has string and integer values and the "nullable"
+     column has float values and NULLs */
+  auto query = R"(
+      select
+          time,
+          TRUNCATE(time / 1000000) % 2 = 0 as even,
+          if(TRUNCATE(time / 1000000) % 2 = 0, 'even', 1) as mixed,
+          if(TRUNCATE(time / 1000000) % 2 = 0, NULL, 1.5) as nullable
+      from testtable;)";
+
+  ResultList expected;
+  auto expected_qplan = runtime->buildQueryPlan(
+      ctx.get(),
+      query,
+      estrat.get());
+  expected_qplan->storeResults(0, &expected);
+  expected_qplan->execute();
+  EXPECT_EQ(expected.getNumRows(), 213);
+
+  Vector<BinaryResultEncoding> encodings = {
+    BinaryResultEncoding::ROWS,
+    BinaryResultEncoding::ROW_BATCHES,
+    BinaryResultEncoding::COLUMN_BATCHES
+  };
+
+  for (const auto& encoding : encodings) {
+    String data;
+    {
+      BinaryResultFormat format(
+          [&data] (void* buf, size_t size) {
+            data.append((const char*) buf, size);
+          },
+          encoding,
+          16);
+
+      ExecutionContext context(runtime->scheduler());
+      format.formatResults(
+          runtime->buildQueryPlan(ctx.get(), query, estrat.get()),
+          &context);
+    }
+
+    Vector<String> columns;
+    Vector<Vector<SValue>> rows;
+    BinaryResultParser parser;
+    parser.onTableHeader([&columns] (const Vector<String>& cols) {
+      columns = cols;
+    });
+
+    parser.onRow([&rows] (int argc, const SValue* argv) {
+      rows.emplace_back(argv, argv + argc);
+    });
+
+    String error;
+    parser.onError([&error] (const String& msg) {
+      error = msg;
+    });
+
+    /* feed the response in small chunks so that frames arrive partially */
+    for (size_t pos = 0; pos < data.size(); pos += 7) {
+      parser.parse(data.data() + pos, std::min(size_t(7), data.size() - pos));
+    }
+
+    EXPECT_TRUE(parser.eof());
+    EXPECT_EQ(error, "");
+    EXPECT_EQ(columns.size(), 4);
+    EXPECT_EQ(columns[2], "mixed");
+    EXPECT_EQ(rows.size(), expected.getNumRows());
+
+    Set<sql_type> mixed_types;
+    Set<sql_type> nullable_types;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      EXPECT_EQ(rows[i].size(), 4);
+      for (size_t j = 0; j < rows[i].size(); ++j) {
+        EXPECT_EQ(rows[i][j].getString(), expected.getRow(i)[j]);
+      }
+
+      EXPECT_TRUE(rows[i][0].getType() == SQL_TIMESTAMP);
+      EXPECT_TRUE(rows[i][1].getType() == SQL_BOOL);
+      mixed_types.emplace(rows[i][2].getType());
+      nullable_types.emplace(rows[i][3].getType());
+    }
+
+    EXPECT_EQ(mixed_types.count(SQL_STRING), 1);
+    EXPECT_EQ(mixed_types.count(SQL_INTEGER), 1);
+    EXPECT_EQ(nullable_types.count(SQL_FLOAT), 1);
+    EXPECT_EQ(nullable_types.count(SQL_NULL), 1);
+  }
+
+  /* a batch header that claims more values than the frame has bytes is
+     rejected before any memory is allocated for it */
+  EXPECT_EXCEPTION("invalid row batch", [] () {
+    String frame;
+    auto os = StringOutputStream::fromString(&frame);
+    os->appendUInt8(0x01);
+    os->appendUInt8(0xf6);
+    os->appendVarUInt(uint64_t(1) << 40);
+    os->appendVarUInt(uint64_t(1) << 40);
+    os->appendVarUInt(16);
+
+    BinaryResultParser parser;
+    parser.parse(frame.data(), frame.size());
+  });
+});
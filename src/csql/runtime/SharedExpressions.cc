@@ -0,0 +1,116 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/runtime/SharedExpressions.h>
+#include <csql/runtime/runtime.h>
+#include <csql/qtree/QueryTreeUtil.h>
+
+using namespace stx;
+
+namespace csql {
+
+SharedExpressions SharedExpressions::build(
+    Transaction* txn,
+    Vector<RefPtr<ValueExpressionNode>>* exprs,
+    Vector<size_t>* num_required) {
+  size_t input_width;
+  auto shared = QueryTreeUtil::extractSharedExpressions(
+      txn,
+      exprs,
+      &input_width,
+      num_required);
+
+  /* only the input columns that are read by one of the expressions have to
+     be copied into the row */
+  Set<size_t> input_columns;
+  auto find_input_columns = [&input_columns, input_width] (
+      const RefPtr<ColumnReferenceNode>& col) {
+    if (col->hasColumnIndex() && col->columnIndex() < input_width) {
+      input_columns.emplace(col->columnIndex());
+    }
+  };
+
+  for (const auto& e : *exprs) {
+    QueryTreeUtil::findColumns(e, find_input_columns);
+  }
+
+  for (const auto& e : shared) {
+    QueryTreeUtil::findColumns(e, find_input_columns);
+  }
+
+  auto qbuilder = txn->getRuntime()->queryBuilder();
+  Vector<ValueExpression> shared_exprs;
+  for (const auto& e : shared) {
+    shared_exprs.emplace_back(qbuilder->buildValueExpression(txn, e));
+  }
+
+  return SharedExpressions(
+      input_width,
+      Vector<size_t>(input_columns.begin(), input_columns.end()),
+      std::move(shared_exprs));
+}
+
+SharedExpressions::SharedExpressions() :
+    input_width_(0),
+    num_evaluated_(0) {}
+
+SharedExpressions::SharedExpressions(
+    size_t input_width,
+    Vector<size_t> input_columns,
+    Vector<ValueExpression> exprs) :
+    input_width_(input_width),
+    input_columns_(std::move(input_columns)),
+    exprs_(std::move(exprs)),
+    row_(input_width_ + exprs_.size(), SValue{}),
+    num_evaluated_(0) {}
+
+size_t SharedExpressions::size() const {
+  return exprs_.size();
+}
+
+size_t SharedExpressions::inputWidth() const {
+  return input_width_;
+}
+
+const ValueExpression& SharedExpressions::getExpression(size_t i) const {
+  return exprs_[i];
+}
+
+void SharedExpressions::setInput(const SValue* row, int row_len) {
+  if (row_len < input_width_) {
+    RAISE(kRuntimeError, "invalid row index %i", input_width_ - 1);
+  }
+
+  for (auto idx : input_columns_) {
+    row_[idx] = row[idx];
+  }
+
+  num_evaluated_ = 0;
+}
+
+void SharedExpressions::evaluate(Transaction* txn, size_t end) {
+  for (; num_evaluated_ < end; ++num_evaluated_) {
+    VM::evaluate(
+        txn,
+        exprs_[num_evaluated_].program(),
+        row_.size(),
+        row_.data(),
+        &row_[input_width_ + num_evaluated_]);
+  }
+}
+
+const SValue* SharedExpressions::row() const {
+  return row_.data();
+}
+
+int SharedExpressions::rowSize() const {
+  return row_.size();
+}
+
+} // namespace csql
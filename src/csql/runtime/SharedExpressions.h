@@ -0,0 +1,92 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <csql/qtree/ValueExpressionNode.h>
+#include <csql/runtime/ValueExpression.h>
+#include <csql/Transaction.h>
+#include <csql/svalue.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Holds the subexpressions that are shared between the expressions of a task
+ * (see QueryTreeUtil::extractSharedExpressions). For every input row, each
+ * shared expression is evaluated once and its value is appended to the row so
+ * that the rewritten expressions can read it like a regular input column.
+ * Only the input columns that are referenced by an expression (input_columns)
+ * are copied from the input row.
+ */
+class SharedExpressions {
+public:
+
+  /**
+   * Extracts the subexpressions shared between the provided expressions and
+   * compiles them. The provided expressions are replaced with their rewritten
+   * versions, which must be evaluated against row() instead of the input row.
+   * num_required[i] is the number of shared expressions that must be
+   * evaluated before the i-th expression
+   */
+  static SharedExpressions build(
+      Transaction* txn,
+      Vector<RefPtr<ValueExpressionNode>>* exprs,
+      Vector<size_t>* num_required);
+
+  SharedExpressions();
+  SharedExpressions(
+      size_t input_width,
+      Vector<size_t> input_columns,
+      Vector<ValueExpression> exprs);
+
+  /**
+   * Returns the number of shared expressions
+   */
+  size_t size() const;
+
+  /**
+   * Returns the index of the first shared expression's column
+   */
+  size_t inputWidth() const;
+
+  /**
+   * Returns the i-th shared expression. It may reference the input columns
+   * and the columns of the shared expressions before it
+   */
+  const ValueExpression& getExpression(size_t i) const;
+
+  /**
+   * Starts a new input row. The row must have at least input_width columns
+   */
+  void setInput(const SValue* row, int row_len);
+
+  /**
+   * Evaluates the shared expressions [0, end) for the current row unless they
+   * have already been evaluated
+   */
+  void evaluate(Transaction* txn, size_t end);
+
+  /**
+   * Returns the current row, i.e. the referenced input columns followed by the
+   * values of the shared expressions. Unreferenced input columns are NULL
+   */
+  const SValue* row() const;
+  int rowSize() const;
+
+protected:
+  size_t input_width_;
+  Vector<size_t> input_columns_;
+  Vector<ValueExpression> exprs_;
+  Vector<SValue> row_;
+  size_t num_evaluated_;
+};
+
+} // namespace csql
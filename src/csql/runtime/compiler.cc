@@ -8,12 +8,16 @@
  * <http://www.gnu.org/licenses/>.
  */
 #include <stdlib.h>
+#include <algorithm>
 #include <stx/RegExp.h>
 #include <csql/parser/astnode.h>
 #include <csql/parser/token.h>
 #include <csql/runtime/compiler.h>
 #include <csql/runtime/symboltable.h>
 #include <csql/runtime/LikePattern.h>
+#include <csql/runtime/RegexPattern.h>
+#include <csql/expressions/boolean.h>
+#include <csql/expressions/datetime.h>
 #include <csql/svalue.h>
 
 #ifndef HAVE_PCRE
@@ -144,6 +148,17 @@ VM::Instruction* Compiler::compileMethodCall(
   auto symbol = symbol_table->lookup(node->symbol());
   const auto& args = node->arguments();
 
+  if (symbol.type == FN_PURE &&
+      symbol.vtable.t_pure.call == &expressions::andExpr &&
+      args.size() == 2) {
+    return compileConjunction(
+        node,
+        symbol,
+        dynamic_storage_size,
+        static_storage,
+        symbol_table);
+  }
+
   auto op = static_storage->construct<VM::Instruction>();
   op->arg0  = nullptr;
   op->argn  = args.size();
@@ -154,6 +169,13 @@ VM::Instruction* Compiler::compileMethodCall(
     case FN_PURE:
       op->type = VM::X_CALL_PURE;
       op->vtable.t_pure = symbol.vtable.t_pure;
+      specializeDateTimeCall(node, op);
+      if (op->vtable.t_pure.call == &expressions::orExpr && args.size() == 2) {
+        op->type = VM::X_OR;
+      }
+      if (op->type == VM::X_CALL_PURE) {
+        preparePureCall(node, op);
+      }
       break;
     case FN_AGGREGATE:
       op->type = VM::X_CALL_AGGREGATE;
@@ -178,6 +200,222 @@ VM::Instruction* Compiler::compileMethodCall(
   return op;
 }
 
+/**
+ * A chain of logical_and calls is flattened into its conjuncts, which are then
+ * ordered by estimated cost per row they eliminate and compiled to a left-deep
+ * chain of short-circuiting X_AND instructions. This way a cheap and selective
+ * comparison runs before e.g. a regex match and the regex is only evaluated
+ * for the rows that passed the comparison. All conjuncts are pure, so the
+ * order doesn't change the result.
+ */
+VM::Instruction* Compiler::compileConjunction(
+    RefPtr<CallExpressionNode> node,
+    const SFunction& symbol,
+    size_t* dynamic_storage_size,
+    ScratchMemory* static_storage,
+    SymbolTable* symbol_table) {
+  Vector<RefPtr<ValueExpressionNode>> conjuncts;
+  findConjuncts(
+      RefPtr<ValueExpressionNode>(node.get()),
+      symbol_table,
+      &conjuncts);
+
+  Vector<std::pair<double, RefPtr<ValueExpressionNode>>> ranked;
+  for (const auto& c : conjuncts) {
+    auto rank = estimateCost(c) / std::max(1.0 - estimateSelectivity(c), 0.01);
+    ranked.emplace_back(rank, c);
+  }
+
+  std::stable_sort(
+      ranked.begin(),
+      ranked.end(),
+      [] (
+          const std::pair<double, RefPtr<ValueExpressionNode>>& a,
+          const std::pair<double, RefPtr<ValueExpressionNode>>& b) {
+        return a.first < b.first;
+      });
+
+  auto expr = compileValueExpression(
+      ranked[0].second,
+      dynamic_storage_size,
+      static_storage,
+      symbol_table);
+
+  for (size_t i = 1; i < ranked.size(); ++i) {
+    auto op = static_storage->construct<VM::Instruction>();
+    op->type = VM::X_AND;
+    op->arg0  = nullptr;
+    op->argn  = 2;
+    op->next  = nullptr;
+    op->vtable.t_pure = symbol.vtable.t_pure;
+    op->child = expr;
+    op->child->next = compileValueExpression(
+        ranked[i].second,
+        dynamic_storage_size,
+        static_storage,
+        symbol_table);
+
+    expr = op;
+  }
+
+  return expr;
+}
+
+void Compiler::findConjuncts(
+    RefPtr<ValueExpressionNode> node,
+    SymbolTable* symbol_table,
+    Vector<RefPtr<ValueExpressionNode>>* conjuncts) {
+  auto call = dynamic_cast<CallExpressionNode*>(node.get());
+  if (call && call->arguments().size() == 2) {
+    auto symbol = symbol_table->lookup(call->symbol());
+    if (symbol.type == FN_PURE &&
+        symbol.vtable.t_pure.call == &expressions::andExpr) {
+      for (const auto& arg : call->arguments()) {
+        findConjuncts(arg, symbol_table, conjuncts);
+      }
+
+      return;
+    }
+  }
+
+  conjuncts->emplace_back(node);
+}
+
+/**
+ * Rough per-row evaluation cost of an expression relative to a single
+ * function call
+ */
+double Compiler::estimateCost(RefPtr<ValueExpressionNode> node) {
+  if (dynamic_cast<ColumnReferenceNode*>(node.get()) ||
+      dynamic_cast<LiteralExpressionNode*>(node.get())) {
+    return 0;
+  }
+
+  double cost = 1;
+  if (dynamic_cast<RegexExpressionNode*>(node.get())) {
+    cost = 50;
+  } else if (dynamic_cast<LikeExpressionNode*>(node.get())) {
+    cost = 10;
+  }
+
+  for (const auto& arg : node->arguments()) {
+    cost += estimateCost(arg);
+  }
+
+  return cost;
+}
+
+/**
+ * Guessed fraction of rows for which a predicate is true
+ */
+double Compiler::estimateSelectivity(RefPtr<ValueExpressionNode> node) {
+  auto call = dynamic_cast<CallExpressionNode*>(node.get());
+  if (call == nullptr) {
+    return 0.5;
+  }
+
+  const auto& symbol = call->symbol();
+  if (symbol == "eq") {
+    return 0.1;
+  }
+
+  if (symbol == "neq") {
+    return 0.9;
+  }
+
+  if (symbol == "lt" || symbol == "lte" || symbol == "gt" || symbol == "gte") {
+    return 0.33;
+  }
+
+  if (symbol == "logical_or") {
+    double nsel = 1;
+    for (const auto& arg : call->arguments()) {
+      nsel *= 1.0 - estimateSelectivity(arg);
+    }
+
+    return 1.0 - nsel;
+  }
+
+  return 0.5;
+}
+
+/**
+ * Calls with literal arguments are handed to the function's prepare method
+ * (if it has one) so that it can convert the literals once instead of for
+ * every row. The literal arguments are still compiled and passed to the
+ * prepared function
+ */
+void Compiler::preparePureCall(
+    RefPtr<CallExpressionNode> node,
+    VM::Instruction* op) {
+  if (op->vtable.t_pure.prepare == nullptr) {
+    return;
+  }
+
+  const auto& args = node->arguments();
+  Vector<const SValue*> literals(args.size(), nullptr);
+  bool has_literal = false;
+  for (size_t i = 0; i < args.size(); ++i) {
+    auto literal = dynamic_cast<LiteralExpressionNode*>(args[i].get());
+    if (literal) {
+      literals[i] = &literal->value();
+      has_literal = true;
+    }
+  }
+
+  if (!has_literal) {
+    return;
+  }
+
+  auto prepared = op->vtable.t_pure.prepare(args.size(), literals.data());
+  if (prepared) {
+    op->type = VM::X_CALL_PREPARED;
+    op->arg0 = prepared;
+  }
+}
+
+/**
+ * DATE_TRUNC and DATE_ADD calls with a literal precision/unit are compiled to
+ * X_DATE_TRUNC/X_DATE_ADD instructions that carry the pre-resolved precision
+ * so that the unit string isn't parsed again for every row. Unknown units are
+ * left to the regular function so that they fail the same way.
+ */
+void Compiler::specializeDateTimeCall(
+    RefPtr<CallExpressionNode> node,
+    VM::Instruction* op) {
+  const auto& args = node->arguments();
+
+  if (op->vtable.t_pure.call == &expressions::dateTruncExpr &&
+      args.size() == 2) {
+    auto unit = dynamic_cast<LiteralExpressionNode*>(args[0].get());
+    if (unit == nullptr) {
+      return;
+    }
+
+    auto precision = expressions::parseTruncPrecision(
+        unit->value().getString());
+    if (!precision.isEmpty()) {
+      op->type = VM::X_DATE_TRUNC;
+      op->arg0 = (void*) precision.get();
+    }
+  }
+
+  if (op->vtable.t_pure.call == &expressions::dateAddExpr &&
+      args.size() == 3) {
+    auto unit = dynamic_cast<LiteralExpressionNode*>(args[2].get());
+    if (unit == nullptr) {
+      return;
+    }
+
+    auto unit_micros = expressions::parseDateAddUnit(
+        unit->value().getString());
+    if (!unit_micros.isEmpty()) {
+      op->type = VM::X_DATE_ADD;
+      op->arg0 = (void*) unit_micros.get();
+    }
+  }
+}
+
 VM::Instruction* Compiler::compileIfStatement(
     RefPtr<IfExpressionNode> node,
     size_t* dynamic_storage_size,
@@ -214,7 +452,7 @@ VM::Instruction* Compiler::compileRegexOperator(
    SymbolTable* symbol_table) {
   auto ins = static_storage->construct<VM::Instruction>();
   ins->type = VM::X_REGEX;
-  ins->arg0 = static_storage->construct<RegExp>(node->pattern());
+  ins->arg0 = static_storage->construct<RegexPattern>(node->pattern());
   ins->next  = nullptr;
   ins->child = compileValueExpression(
       node->subject(),
@@ -66,6 +66,30 @@ protected:
       ScratchMemory* static_storage,
       SymbolTable* symbol_table);
 
+  static VM::Instruction* compileConjunction(
+      RefPtr<CallExpressionNode> node,
+      const SFunction& symbol,
+      size_t* dynamic_storage_size,
+      ScratchMemory* static_storage,
+      SymbolTable* symbol_table);
+
+  static void findConjuncts(
+      RefPtr<ValueExpressionNode> node,
+      SymbolTable* symbol_table,
+      Vector<RefPtr<ValueExpressionNode>>* conjuncts);
+
+  static double estimateCost(RefPtr<ValueExpressionNode> node);
+
+  static double estimateSelectivity(RefPtr<ValueExpressionNode> node);
+
+  static void preparePureCall(
+      RefPtr<CallExpressionNode> node,
+      VM::Instruction* op);
+
+  static void specializeDateTimeCall(
+      RefPtr<CallExpressionNode> node,
+      VM::Instruction* op);
+
   static VM::Instruction* compileRegexOperator(
       RefPtr<RegexExpressionNode> node,
       size_t* dynamic_storage_size,
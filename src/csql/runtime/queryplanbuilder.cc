@@ -8,11 +8,13 @@
  * <http://www.gnu.org/licenses/>.
  */
 #include <stdlib.h>
+#include <stx/UnixTime.h>
 #include <csql/parser/astnode.h>
 #include <csql/parser/astutil.h>
 #include <csql/parser/parser.h>
 #include <csql/runtime/queryplanbuilder.h>
 #include <csql/qtree/GroupByNode.h>
+#include <csql/qtree/GroupOverTimewindowNode.h>
 #include <csql/qtree/IfExpressionNode.h>
 #include <csql/qtree/SelectExpressionNode.h>
 #include <csql/qtree/LimitNode.h>
@@ -55,7 +57,9 @@ RefPtr<QueryTreeNode> QueryPlanBuilder::build(
     return buildOrderByClause(txn, ast, tables);
   }
 
-  if (hasGroupByClause(ast) || hasAggregationInSelectList(ast)) {
+  if (hasGroupByClause(ast) ||
+      hasGroupOverTimewindowClause(ast) ||
+      hasAggregationInSelectList(ast)) {
     return buildGroupBy(txn, ast, tables);
   }
 
@@ -145,9 +149,54 @@ Vector<RefPtr<QueryTreeNode>> QueryPlanBuilder::build(
     }
   }
 
+  shareSequentialScans(&nodes);
   return nodes;
 }
 
+void QueryPlanBuilder::shareSequentialScans(
+    Vector<RefPtr<QueryTreeNode>>* statements) {
+  HashMap<String, RefPtr<QueryTreeNode>> shared_scans;
+
+  for (const auto& stmt : *statements) {
+    HashMap<String, RefPtr<QueryTreeNode>> statement_scans;
+    if (dynamic_cast<SequentialScanNode*>(stmt.get())) {
+      statement_scans.emplace(stmt->toString(), stmt);
+    }
+
+    shareSequentialScans(stmt, shared_scans, &statement_scans);
+
+    for (const auto& scan : statement_scans) {
+      shared_scans.emplace(scan.first, scan.second);
+    }
+  }
+}
+
+void QueryPlanBuilder::shareSequentialScans(
+    RefPtr<QueryTreeNode> node,
+    const HashMap<String, RefPtr<QueryTreeNode>>& shared_scans,
+    HashMap<String, RefPtr<QueryTreeNode>>* statement_scans) {
+  for (size_t i = 0; i < node->numChildren(); ++i) {
+    auto child = node->mutableChild(i);
+
+    if (dynamic_cast<SequentialScanNode*>(child->get())) {
+      auto key = (*child)->toString();
+      if (statement_scans->count(key) > 0) {
+        continue;
+      }
+
+      auto shared = shared_scans.find(key);
+      if (shared != shared_scans.end()) {
+        *child = shared->second;
+      }
+
+      statement_scans->emplace(key, *child);
+      continue;
+    }
+
+    shareSequentialScans(*child, shared_scans, statement_scans);
+  }
+}
+
 //QueryPlanBuilder::QueryPlanBuilder(
 //    ValueExpressionBuilder* compiler,
 //    const std::vector<std::unique_ptr<Backend>>& backends) :
@@ -233,22 +282,21 @@ bool QueryPlanBuilder::hasGroupByClause(ASTNode* ast) const {
 
   return false;
 }
-//
-//bool QueryPlanBuilder::hasGroupOverTimewindowClause(ASTNode* ast) const {
-//  if (!(*ast == ASTNode::T_SELECT) || ast->getChildren().size() < 2) {
-//    return false;
-//  }
-//
-//  for (const auto& child : ast->getChildren()) {
-//    if (child->getType() == ASTNode::T_GROUP_OVER_TIMEWINDOW) {
-//      return true;
-//    }
-//  }
-//
-//  return false;
-//}
-//
-//
+
+bool QueryPlanBuilder::hasGroupOverTimewindowClause(ASTNode* ast) const {
+  if (!(*ast == ASTNode::T_SELECT) || ast->getChildren().size() < 2) {
+    return false;
+  }
+
+  for (const auto& child : ast->getChildren()) {
+    if (child->getType() == ASTNode::T_GROUP_OVER_TIMEWINDOW) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 bool QueryPlanBuilder::hasJoin(ASTNode* ast) const {
   if (!(*ast == ASTNode::T_SELECT) || ast->getChildren().size() < 2) {
     return false;
@@ -376,29 +424,145 @@ QueryTreeNode* QueryPlanBuilder::buildGroupBy(
   auto child_sl = new ASTNode(ASTNode::T_SELECT_LIST);
   buildGroupBySelectList(select_list, child_sl);
 
-  /* search for a group by clause */
+  /* search for a group by or group over timewindow clause */
   Vector<RefPtr<ValueExpressionNode>> group_expressions;
+  Vector<ASTNode*> group_asts;
+  ASTNode* timewindow = nullptr;
   for (const auto& child : ast->getChildren()) {
-    if (child->getType() != ASTNode::T_GROUP_BY) {
-      continue;
+    ASTNode* group_list;
+    switch (child->getType()) {
+      case ASTNode::T_GROUP_BY:
+        group_list = child;
+        break;
+      case ASTNode::T_GROUP_OVER_TIMEWINDOW:
+        if (child->getChildren().size() < 3) {
+          RAISE(kRuntimeError, "corrupt AST");
+        }
+
+        timewindow = child;
+        group_list = child->getChildren()[1];
+        break;
+      default:
+        continue;
     }
 
-    for (const auto& group_expr : child->getChildren()) {
+    for (const auto& group_expr : group_list->getChildren()) {
       auto e = group_expr->deepCopy();
       if (hasAggregationExpression(e)) {
         RAISE(kRuntimeError, "GROUP clause can only contain pure functions");
       }
 
+      group_asts.emplace_back(group_expr);
       group_expressions.emplace_back(buildValueExpression(txn, e));
     }
   }
 
+  /* GROUP OVER TIMEWINDOW(time_expr, window [, step]): window and step are
+     constant expressions in seconds, the step defaults to the window */
+  RefPtr<ValueExpressionNode> time_expression;
+  uint64_t window = 0;
+  uint64_t step = 0;
+  if (timewindow) {
+    auto time_ast = timewindow->getChildren()[0]->deepCopy();
+    if (hasAggregationExpression(time_ast)) {
+      RAISE(
+          kRuntimeError,
+          "TIMEWINDOW time expression can only contain pure functions");
+    }
+
+    time_expression = buildValueExpression(txn, time_ast);
+
+    auto runtime = txn->getRuntime();
+    auto window_secs = runtime->evaluateConstExpression(
+        txn,
+        timewindow->getChildren()[2]).getFloat();
+    auto step_secs = window_secs;
+    if (timewindow->getChildren().size() > 3) {
+      step_secs = runtime->evaluateConstExpression(
+          txn,
+          timewindow->getChildren()[3]).getFloat();
+    }
+
+    window = window_secs * kMicrosPerSecond;
+    step = step_secs * kMicrosPerSecond;
+    if (window_secs <= 0 || step_secs <= 0 || window == 0 || step == 0) {
+      RAISE(kRuntimeError, "TIMEWINDOW window and step must be > 0");
+    }
+  }
+
+  /* split the having clause into conjuncts that only depend on the group
+     key, which are pushed down into the where clause, and the rest, which is
+     evaluated on the aggregated groups */
+  ASTNode* having_expr = nullptr;
+  Vector<ASTNode*> where_conjuncts;
+  for (const auto& child : ast->getChildren()) {
+    if (child->getType() != ASTNode::T_HAVING) {
+      continue;
+    }
+
+    if (child->getChildren().size() != 1) {
+      RAISE(kRuntimeError, "corrupt AST");
+    }
+
+    Vector<ASTNode*> conjuncts;
+    findConjuncts(child->getChildren()[0], &conjuncts);
+
+    for (const auto& c : conjuncts) {
+      bool has_group_key = false;
+      if (!group_asts.empty() &&
+          !hasAggregationExpression(c) &&
+          isGroupKeyExpression(c, group_asts, &has_group_key) &&
+          has_group_key) {
+        where_conjuncts.emplace_back(c->deepCopy());
+        continue;
+      }
+
+      if (having_expr == nullptr) {
+        having_expr = c->deepCopy();
+      } else {
+        auto and_expr = new ASTNode(ASTNode::T_AND_EXPR);
+        and_expr->appendChild(having_expr);
+        and_expr->appendChild(c->deepCopy());
+        having_expr = and_expr;
+      }
+    }
+  }
+
+  /* push down columns and aggregate arguments of the having expression into
+     the child select list */
+  if (having_expr) {
+    buildGroupBySelectList(having_expr, child_sl);
+  }
+
   /* copy ast for child and swap out select lists*/
   auto child_ast = ast->deepCopy();
   child_ast->removeChildrenByType(ASTNode::T_GROUP_BY);
+  child_ast->removeChildrenByType(ASTNode::T_GROUP_OVER_TIMEWINDOW);
+  child_ast->removeChildrenByType(ASTNode::T_HAVING);
   child_ast->removeChildByIndex(0);
   child_ast->appendChild(child_sl, 0);
 
+  for (const auto& c : where_conjuncts) {
+    ASTNode* where_clause = nullptr;
+    for (const auto& child : child_ast->getChildren()) {
+      if (child->getType() == ASTNode::T_WHERE) {
+        where_clause = child;
+      }
+    }
+
+    if (where_clause == nullptr) {
+      where_clause = new ASTNode(ASTNode::T_WHERE);
+      where_clause->appendChild(c);
+      child_ast->appendChild(where_clause, 2);
+    } else {
+      auto and_expr = new ASTNode(ASTNode::T_AND_EXPR);
+      and_expr->appendChild(where_clause->getChildren()[0]->deepCopy());
+      and_expr->appendChild(c);
+      where_clause->clearChildren();
+      where_clause->appendChild(and_expr);
+    }
+  }
+
   auto subtree = build(txn, child_ast, tables);
   auto subtree_tbl = subtree.asInstanceOf<TableExpressionNode>();
 
@@ -437,10 +601,91 @@ QueryTreeNode* QueryPlanBuilder::buildGroupBy(
             true));
   }
 
-  return new GroupByNode(
-      select_list_expressions,
-      group_expressions,
-      subtree);
+  GroupByNode* group_by;
+  if (timewindow) {
+    QueryTreeUtil::resolveColumns(
+        time_expression,
+        std::bind(
+            &TableExpressionNode::getColumnIndex,
+            subtree_tbl.get(),
+            std::placeholders::_1,
+            true));
+
+    group_by = new GroupOverTimewindowNode(
+        select_list_expressions,
+        group_expressions,
+        time_expression,
+        window,
+        step,
+        subtree);
+  } else {
+    /* the partial aggregations don't depend on the input order, so a scan
+       can be split into one partial aggregation per record range */
+    auto seqscan = dynamic_cast<SequentialScanNode*>(subtree.get());
+    if (seqscan) {
+      seqscan->setPartitionable(true);
+    }
+
+    group_by = new GroupByNode(
+        select_list_expressions,
+        group_expressions,
+        subtree);
+  }
+
+  if (having_expr) {
+    auto having = buildValueExpression(txn, having_expr);
+    QueryTreeUtil::resolveColumns(
+        having,
+        std::bind(
+            &TableExpressionNode::getColumnIndex,
+            subtree_tbl.get(),
+            std::placeholders::_1,
+            false));
+
+    group_by->setHavingExpression(having);
+  }
+
+  return group_by;
+}
+
+void QueryPlanBuilder::findConjuncts(
+    ASTNode* expr,
+    Vector<ASTNode*>* conjuncts) const {
+  if (expr->getType() == ASTNode::T_AND_EXPR &&
+      expr->getChildren().size() == 2) {
+    findConjuncts(expr->getChildren()[0], conjuncts);
+    findConjuncts(expr->getChildren()[1], conjuncts);
+  } else {
+    conjuncts->emplace_back(expr);
+  }
+}
+
+bool QueryPlanBuilder::isGroupKeyExpression(
+    ASTNode* expr,
+    const Vector<ASTNode*>& group_exprs,
+    bool* has_group_key) const {
+  for (const auto& g : group_exprs) {
+    if (expr->compare(g)) {
+      *has_group_key = true;
+      return true;
+    }
+  }
+
+  switch (expr->getType()) {
+    case ASTNode::T_COLUMN_NAME:
+    case ASTNode::T_METHOD_CALL_WITHIN_RECORD:
+      return false;
+    default:
+      break;
+  }
+
+  for (const auto& child : expr->getChildren()) {
+    if (!isGroupKeyExpression(child, group_exprs, has_group_key)) {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 bool QueryPlanBuilder::buildGroupBySelectList(
@@ -573,11 +818,26 @@ QueryTreeNode* QueryPlanBuilder::buildLimitClause(
     // clone ast + remove limit clause
     auto new_ast = ast->deepCopy();
     new_ast->removeChildrenByType(ASTNode::T_LIMIT);
+    auto subtree = build(txn, new_ast, tables);
+
+    // ORDER BY ... LIMIT -> top n
+    auto order_by = dynamic_cast<OrderByNode*>(subtree.get());
+    if (order_by && order_by->limit().isEmpty()) {
+      auto topn = new OrderByNode(
+          order_by->sortSpecs(),
+          order_by->inputTable());
+      topn->setLimit(limit, offset);
+      return topn;
+    }
+
+    // LIMIT without ORDER BY -> stop the scan once it produced enough rows
+    auto seqscan = dynamic_cast<SequentialScanNode*>(subtree.get());
+    if (seqscan &&
+        seqscan->aggregationStrategy() == AggregationStrategy::NO_AGGREGATION) {
+      seqscan->setLimit(limit + offset);
+    }
 
-    return new LimitNode(
-        limit,
-        offset,
-        build(txn, new_ast, tables));
+    return new LimitNode(limit, offset, subtree);
   }
 
   return nullptr;
@@ -867,6 +1127,82 @@ QueryTreeNode* QueryPlanBuilder::buildTableReference(
   }
 }
 
+/**
+ * Splits the join condition into conjuncts and collects all conjuncts of the
+ * form "<expr on base table> = <expr on joined table>". If any are found, the
+ * join is executed as a hash join on these keys
+ */
+static void findEquiJoinKeys(JoinNode* join_node) {
+  auto join_cond = join_node->joinCondition();
+  if (join_cond.isEmpty() || join_node->joinType() == JoinType::CARTESIAN) {
+    return;
+  }
+
+  const auto& input_map = join_node->inputColumnMap();
+  auto find_table = [&input_map] (RefPtr<ValueExpressionNode> expr) {
+    size_t table_idx = size_t(-1);
+    bool valid = true;
+    QueryTreeUtil::findColumns(
+        expr,
+        [&input_map, &table_idx, &valid] (
+            const RefPtr<ColumnReferenceNode>& col) {
+          if (!col->hasColumnIndex() ||
+              col->columnIndex() >= input_map.size()) {
+            valid = false;
+            return;
+          }
+
+          auto col_table_idx = input_map[col->columnIndex()].table_idx;
+          if (table_idx != size_t(-1) && table_idx != col_table_idx) {
+            valid = false;
+          }
+
+          table_idx = col_table_idx;
+        });
+
+    return valid ? table_idx : size_t(-1);
+  };
+
+  Vector<JoinNode::EquiJoinKey> keys;
+  Vector<RefPtr<ValueExpressionNode>> stack{ join_cond.get() };
+  while (!stack.empty()) {
+    auto expr = stack.back();
+    stack.pop_back();
+
+    auto call_expr = dynamic_cast<CallExpressionNode*>(expr.get());
+    if (!call_expr) {
+      continue;
+    }
+
+    auto args = call_expr->arguments();
+    if (call_expr->symbol() == "logical_and") {
+      stack.insert(stack.end(), args.rbegin(), args.rend());
+      continue;
+    }
+
+    if (call_expr->symbol() != "eq" || args.size() != 2) {
+      continue;
+    }
+
+    auto lhs_table = find_table(args[0]);
+    auto rhs_table = find_table(args[1]);
+    JoinNode::EquiJoinKey key;
+    if (lhs_table == 0 && rhs_table == 1) {
+      key.base_key = args[0]->deepCopyAs<ValueExpressionNode>();
+      key.joined_key = args[1]->deepCopyAs<ValueExpressionNode>();
+    } else if (lhs_table == 1 && rhs_table == 0) {
+      key.base_key = args[1]->deepCopyAs<ValueExpressionNode>();
+      key.joined_key = args[0]->deepCopyAs<ValueExpressionNode>();
+    } else {
+      continue;
+    }
+
+    keys.emplace_back(key);
+  }
+
+  join_node->setEquiJoinKeys(keys);
+}
+
 QueryTreeNode* QueryPlanBuilder::buildJoinTableReference(
     Transaction* txn,
     ASTNode* table_ref,
@@ -1137,6 +1473,8 @@ QueryTreeNode* QueryPlanBuilder::buildJoinTableReference(
             true));
   }
 
+  findEquiJoinKeys(join_node.get());
+
   return join_node.release();
 }
 
@@ -70,11 +70,11 @@ public:
    */
   bool hasGroupByClause(ASTNode* ast) const;
 
-  ///**
-  // * Returns true if the ast is a SELECT statement that has a GROUP OVER
-  // * TIMEWINDOW clause, otherwise false
-  // */
-  //bool hasGroupOverTimewindowClause(ASTNode* ast) const;
+  /**
+   * Returns true if the ast is a SELECT statement that has a GROUP OVER
+   * TIMEWINDOW clause, otherwise false
+   */
+  bool hasGroupOverTimewindowClause(ASTNode* ast) const;
 
   /**
    * Returns true if the ast is a SELECT statement that has a ORDER BY clause,
@@ -102,7 +102,9 @@ public:
 
   /**
    * Build a group by query plan node for a SELECT statement that has a GROUP
-   * BY clause
+   * BY or GROUP OVER TIMEWINDOW clause. Conjuncts of the HAVING clause that
+   * only depend on the group key are pushed down into the WHERE clause, the
+   * rest is evaluated by the group by node
    */
   QueryTreeNode* buildGroupBy(
       Transaction* txn,
@@ -238,6 +240,35 @@ public:
       ASTNode* ast,
       ASTNode* select_list);
 
+  /**
+   * Split the provided ast into its AND-ed conjuncts
+   */
+  void findConjuncts(ASTNode* expr, Vector<ASTNode*>* conjuncts) const;
+
+  /**
+   * Returns true if the provided expression only refers to columns through
+   * the provided group expressions. has_group_key is set to true if at least
+   * one group expression was found
+   */
+  bool isGroupKeyExpression(
+      ASTNode* expr,
+      const Vector<ASTNode*>& group_exprs,
+      bool* has_group_key) const;
+
+  /**
+   * Replace sequential scans that are identical to a scan in a previous
+   * statement with that scan so that the table is only read once and its rows
+   * are routed to all consumers. Identical scans within the same statement
+   * (e.g. both sides of a self-join) are not merged since their consumers
+   * tell inputs apart by task id.
+   */
+  void shareSequentialScans(Vector<RefPtr<QueryTreeNode>>* statements);
+
+  void shareSequentialScans(
+      RefPtr<QueryTreeNode> node,
+      const HashMap<String, RefPtr<QueryTreeNode>>& shared_scans,
+      HashMap<String, RefPtr<QueryTreeNode>>* statement_scans);
+
 protected:
   QueryPlanBuilderOptions opts_;
   SymbolTable* symbol_table_;
@@ -41,7 +41,8 @@ Runtime::Runtime(
     tpool_(tpool_opts),
     symbol_table_(symbol_table),
     query_builder_(query_builder),
-    query_plan_builder_(query_plan_builder) {}
+    query_plan_builder_(query_plan_builder),
+    memory_budget_(kDefaultMemoryBudget) {}
 
 ScopedPtr<QueryPlan> Runtime::buildQueryPlan(
     Transaction* txn,
@@ -188,6 +189,22 @@ void Runtime::setCacheDir(const String& cachedir) {
   cachedir_ = Some(cachedir);
 }
 
+size_t Runtime::memoryBudget() const {
+  return memory_budget_;
+}
+
+void Runtime::setMemoryBudget(size_t bytes) {
+  memory_budget_ = bytes;
+}
+
+void Runtime::enableResultCache(const String& cache_dir, size_t max_size) {
+  result_cache_ = new ResultCache(cache_dir, max_size);
+}
+
+RefPtr<ResultCache> Runtime::resultCache() const {
+  return result_cache_;
+}
+
 RefPtr<QueryBuilder> Runtime::queryBuilder() const {
   return query_builder_;
 }
@@ -23,6 +23,7 @@
 #include <csql/runtime/ResultFormat.h>
 #include <csql/runtime/ExecutionStrategy.h>
 #include <csql/runtime/resultlist.h>
+#include <csql/runtime/ResultCache.h>
 
 namespace csql {
 
@@ -82,6 +83,28 @@ public:
   Option<String> cacheDir() const;
   void setCacheDir(const String& cachedir);
 
+  /**
+   * Approximate memory budget in bytes for a single blocking operator (like
+   * ORDER BY). Operators that exceed the budget spill to the cache dir if one
+   * is set
+   */
+  size_t memoryBudget() const;
+  void setMemoryBudget(size_t bytes);
+
+  static const size_t kDefaultMemoryBudget = 256 * 1024 * 1024;
+
+  /**
+   * Store the results of cacheable tasks in the provided directory and replay
+   * them in later queries (see CachedTask). The stored results are limited to
+   * max_size bytes, least recently used results are evicted first. The result
+   * cache is disabled by default
+   */
+  void enableResultCache(
+      const String& cache_dir,
+      size_t max_size = ResultCache::kDefaultMaxSize);
+
+  RefPtr<ResultCache> resultCache() const;
+
   RefPtr<QueryBuilder> queryBuilder() const;
   RefPtr<QueryPlanBuilder> queryPlanBuilder() const;
 
@@ -94,6 +117,8 @@ protected:
   RefPtr<QueryBuilder> query_builder_;
   RefPtr<QueryPlanBuilder> query_plan_builder_;
   Option<String> cachedir_;
+  size_t memory_budget_;
+  RefPtr<ResultCache> result_cache_;
 };
 
 }
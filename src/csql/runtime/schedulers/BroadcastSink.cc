@@ -0,0 +1,114 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/runtime/schedulers/BroadcastSink.h>
+
+using namespace stx;
+
+namespace csql {
+
+BroadcastSink::BroadcastSink(
+    size_t buffer_rows /* = 0 */) :
+    buffer_rows_(buffer_rows),
+    num_active_(0) {}
+
+void BroadcastSink::addOutput(
+    RowSinkFn output,
+    std::mutex* lock /* = nullptr */) {
+  Output o;
+  o.fn = output;
+  o.lock = lock;
+  o.done = false;
+  outputs_.emplace_back(o);
+  ++num_active_;
+}
+
+size_t BroadcastSink::numOutputs() const {
+  return outputs_.size();
+}
+
+bool BroadcastSink::onRow(const SValue* row, int row_len) {
+  if (num_active_ == 0) {
+    return false;
+  }
+
+  if (buffer_rows_ > 0) {
+    buffer_.insert(buffer_.end(), row, row + row_len);
+    buffer_row_lens_.emplace_back(row_len);
+    if (buffer_row_lens_.size() < buffer_rows_) {
+      return true;
+    }
+
+    return flush();
+  }
+
+  for (auto& o : outputs_) {
+    if (o.done) {
+      continue;
+    }
+
+    bool cont;
+    if (o.lock) {
+      std::unique_lock<std::mutex> lk(*o.lock);
+      cont = o.fn(row, row_len);
+    } else {
+      cont = o.fn(row, row_len);
+    }
+
+    if (!cont) {
+      o.done = true;
+      --num_active_;
+    }
+  }
+
+  return num_active_ > 0;
+}
+
+bool BroadcastSink::flush() {
+  if (!buffer_row_lens_.empty()) {
+    for (auto& o : outputs_) {
+      if (!o.done && !deliver(&o)) {
+        o.done = true;
+        --num_active_;
+      }
+    }
+
+    buffer_.clear();
+    buffer_row_lens_.clear();
+  }
+
+  return num_active_ > 0;
+}
+
+bool BroadcastSink::deliver(Output* output) {
+  std::unique_lock<std::mutex> lk;
+  if (output->lock) {
+    lk = std::unique_lock<std::mutex>(*output->lock);
+  }
+
+  auto row = buffer_.data();
+  for (auto row_len : buffer_row_lens_) {
+    if (!output->fn(row, row_len)) {
+      return false;
+    }
+
+    row += row_len;
+  }
+
+  return true;
+}
+
+RowSinkFn BroadcastSink::getSinkFn() {
+  auto self = mkRef(this);
+  return [self] (const SValue* argv, int argc) -> bool {
+    return self->onRow(argv, argc);
+  };
+}
+
+} // namespace csql
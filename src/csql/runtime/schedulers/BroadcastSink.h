@@ -0,0 +1,64 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <mutex>
+#include <stx/stdtypes.h>
+#include <stx/autoref.h>
+#include <csql/tasks/Task.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Routes the output rows of a single task to multiple consumers. A consumer
+ * that returns false from its sink is not sent any further rows; the producer
+ * is only told to stop once every consumer is done.
+ *
+ * If buffer_rows is non-zero, rows are collected and handed to the consumers
+ * in batches of up to buffer_rows rows. An output that was added with a lock
+ * holds that lock for the whole batch instead of once per row. Buffered rows
+ * must be delivered with flush() once the producing task has finished.
+ */
+class BroadcastSink : public RefCounted {
+public:
+
+  static const size_t kDefaultBufferRows = 256;
+
+  BroadcastSink(size_t buffer_rows = 0);
+
+  void addOutput(RowSinkFn output, std::mutex* lock = nullptr);
+
+  size_t numOutputs() const;
+
+  bool onRow(const SValue* row, int row_len);
+
+  bool flush();
+
+  RowSinkFn getSinkFn();
+
+protected:
+
+  struct Output {
+    RowSinkFn fn;
+    std::mutex* lock;
+    bool done;
+  };
+
+  bool deliver(Output* output);
+
+  size_t buffer_rows_;
+  Vector<Output> outputs_;
+  size_t num_active_;
+  Vector<SValue> buffer_;
+  Vector<int> buffer_row_lens_;
+};
+
+} // namespace csql
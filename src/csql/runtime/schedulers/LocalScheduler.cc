@@ -8,6 +8,7 @@
  * <http://www.gnu.org/licenses/>.
  */
 #include <csql/runtime/schedulers/LocalScheduler.h>
+#include <csql/tasks/cached_task.h>
 
 using namespace stx;
 
@@ -44,6 +45,10 @@ void LocalScheduler::execute() {
 
     for (const auto& runnable_id : runnables) {
       instances_[runnable_id]->onInputsReady();
+      for (const auto& dep_id : tasks_->getOutputTasksFor(runnable_id)) {
+        instances_[dep_id]->onInputComplete(runnable_id);
+      }
+
       tasks_->setTaskStatusCompleted(runnable_id);
     }
   }
@@ -56,16 +61,27 @@ RefPtr<Task> LocalScheduler::buildInstance(const TaskID& task_id) {
 
   auto task = tasks_->getTask(task_id);
   Vector<RowSinkFn> task_outputs;
+  RefPtr<PartitionSink> partitions;
 
   for (const auto& dep_id : tasks_->getOutputTasksFor(task_id)) {
     auto dep_instance = buildInstance(dep_id);
-    task_outputs.emplace_back(
-        std::bind(
-            &Task::onInputRow,
-            dep_instance.get(),
-            task_id,
-            std::placeholders::_1,
-            std::placeholders::_2));
+    auto dep_fn = std::bind(
+        &Task::onInputRow,
+        dep_instance.get(),
+        task_id,
+        std::placeholders::_1,
+        std::placeholders::_2);
+
+    auto partition = tasks_->getInputPartition(dep_id, task_id);
+    if (partition.isEmpty()) {
+      task_outputs.emplace_back(dep_fn);
+    } else {
+      if (partitions.get() == nullptr) {
+        partitions = new PartitionSink();
+      }
+
+      partitions->addOutput(partition.get(), dep_fn);
+    }
   }
 
   if (callbacks_->on_row.count(task_id) > 0) {
@@ -79,18 +95,33 @@ RefPtr<Task> LocalScheduler::buildInstance(const TaskID& task_id) {
   }
 
   RowSinkFn output_fn;
-  switch (task_outputs.size()) {
-    case 0:
-      output_fn = [] (const SValue* argv, int argc) { return true; };
-      break;
-    case 1:
-      output_fn = task_outputs[0];
-      break;
-    default:
-      RAISE(kNotYetImplementedError);
+  if (partitions.get() != nullptr) {
+    if (!task_outputs.empty()) {
+      RAISE(kIllegalStateError, "partitioned task output can't be broadcast");
+    }
+
+    output_fn = partitions->getSinkFn();
+  } else {
+    switch (task_outputs.size()) {
+      case 0:
+        output_fn = [] (const SValue* argv, int argc) { return true; };
+        break;
+      case 1:
+        output_fn = task_outputs[0];
+        break;
+      default: {
+        RefPtr<BroadcastSink> broadcast(new BroadcastSink());
+        for (const auto& out : task_outputs) {
+          broadcast->addOutput(out);
+        }
+
+        output_fn = broadcast->getSinkFn();
+        break;
+      }
+    }
   }
 
-  auto instance = task->getFactory()->build(txn_, output_fn);
+  auto instance = CachedTask::build(txn_, task->getFactory(), output_fn);
   instances_.emplace(task_id, instance);
   return instance;
 }
@@ -9,6 +9,8 @@
  */
 #pragma once
 #include <csql/runtime/Scheduler.h>
+#include <csql/runtime/schedulers/BroadcastSink.h>
+#include <csql/runtime/schedulers/PartitionSink.h>
 
 using namespace stx;
 
@@ -0,0 +1,208 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/runtime/schedulers/ParallelScheduler.h>
+#include <csql/tasks/cached_task.h>
+#include <csql/runtime/runtime.h>
+
+using namespace stx;
+
+namespace csql {
+
+SchedulerFactory ParallelScheduler::getFactory(
+    size_t max_concurrent_tasks /* = 32 */) {
+  return [max_concurrent_tasks] (
+      Transaction* txn,
+      TaskDAG* tasks,
+      SchedulerCallbacks* callbacks) -> ScopedPtr<Scheduler> {
+    return mkScoped<Scheduler>(
+        new ParallelScheduler(txn, tasks, callbacks, max_concurrent_tasks));
+  };
+}
+
+ParallelScheduler::ParallelScheduler(
+    Transaction* txn,
+    TaskDAG* tasks,
+    SchedulerCallbacks* callbacks,
+    size_t max_concurrent_tasks) :
+    txn_(txn),
+    tasks_(tasks),
+    callbacks_(callbacks),
+    max_concurrent_tasks_(max_concurrent_tasks) {}
+
+void ParallelScheduler::execute() {
+  for (const auto& task_id : tasks_->getAllTasks()) {
+    buildInstance(task_id);
+  }
+
+  auto sched = txn_->getRuntime()->scheduler();
+
+  std::unique_lock<std::mutex> lk(mutex_);
+  for (;;) {
+    for (const auto& task_id : completed_) {
+      tasks_->setTaskStatusCompleted(task_id);
+    }
+    completed_.clear();
+
+    /* stop dispatching new tasks once one task has failed */
+    if (!error_) {
+      for (const auto& runnable_id : tasks_->getRunnableTasks()) {
+        if (running_.size() >= max_concurrent_tasks_) {
+          break;
+        }
+
+        if (running_.count(runnable_id) > 0) {
+          continue;
+        }
+
+        running_.emplace(runnable_id);
+        sched->run(
+            std::bind(&ParallelScheduler::runTask, this, runnable_id));
+      }
+    }
+
+    if (running_.empty() && completed_.empty()) {
+      break;
+    }
+
+    cv_.wait(lk, [this] { return !completed_.empty(); });
+  }
+
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void ParallelScheduler::runTask(const TaskID& task_id) {
+  try {
+    instances_.at(task_id)->onInputsReady();
+
+    auto broadcast = broadcasts_.find(task_id);
+    if (broadcast != broadcasts_.end()) {
+      broadcast->second->flush();
+    }
+
+    auto partitions = partition_sinks_.find(task_id);
+    if (partitions != partition_sinks_.end()) {
+      partitions->second->flush();
+    }
+
+    auto consumers = consumers_.find(task_id);
+    if (consumers != consumers_.end()) {
+      for (const auto& consumer : consumers->second) {
+        std::unique_lock<std::mutex> lk(*consumer.second);
+        consumer.first->onInputComplete(task_id);
+      }
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (!error_) {
+      error_ = std::current_exception();
+    }
+  }
+
+  std::unique_lock<std::mutex> lk(mutex_);
+  running_.erase(task_id);
+  completed_.emplace_back(task_id);
+  cv_.notify_all();
+}
+
+RefPtr<Task> ParallelScheduler::buildInstance(const TaskID& task_id) {
+  if (instances_.count(task_id) > 0) {
+    return instances_[task_id];
+  }
+
+  auto task = tasks_->getTask(task_id);
+  Vector<std::pair<RowSinkFn, std::mutex*>> task_outputs;
+  RefPtr<PartitionSink> partitions;
+
+  for (const auto& dep_id : tasks_->getOutputTasksFor(task_id)) {
+    auto dep_instance = buildInstance(dep_id);
+
+    auto& dep_lock = input_locks_[dep_id];
+    if (!dep_lock) {
+      dep_lock.reset(new std::mutex());
+    }
+
+    auto dep_task_ptr = dep_instance.get();
+    consumers_[task_id].emplace_back(dep_task_ptr, dep_lock.get());
+
+    RowSinkFn dep_fn =
+        [dep_task_ptr, task_id] (const SValue* argv, int argc) -> bool {
+          return dep_task_ptr->onInputRow(task_id, argv, argc);
+        };
+
+    auto partition = tasks_->getInputPartition(dep_id, task_id);
+    if (partition.isEmpty()) {
+      task_outputs.emplace_back(dep_fn, dep_lock.get());
+    } else {
+      if (partitions.get() == nullptr) {
+        partitions = new PartitionSink(BroadcastSink::kDefaultBufferRows);
+      }
+
+      partitions->addOutput(partition.get(), dep_fn, dep_lock.get());
+    }
+  }
+
+  if (callbacks_->on_row.count(task_id) > 0) {
+    for (const auto& cb : callbacks_->on_row[task_id]) {
+      task_outputs.emplace_back(cb, &callbacks_lock_);
+    }
+  }
+
+  if (instances_.count(task_id) > 0) {
+    return instances_[task_id];
+  }
+
+  RowSinkFn output_fn;
+  if (partitions.get() != nullptr) {
+    if (!task_outputs.empty()) {
+      RAISE(kIllegalStateError, "partitioned task output can't be broadcast");
+    }
+
+    partition_sinks_.emplace(task_id, partitions);
+    output_fn = partitions->getSinkFn();
+  } else {
+    switch (task_outputs.size()) {
+      case 0:
+        output_fn = [] (const SValue* argv, int argc) { return true; };
+        break;
+      case 1: {
+        auto out_fn = task_outputs[0].first;
+        auto out_lock = task_outputs[0].second;
+        output_fn = [out_fn, out_lock] (
+            const SValue* argv,
+            int argc) -> bool {
+          std::unique_lock<std::mutex> lk(*out_lock);
+          return out_fn(argv, argc);
+        };
+        break;
+      }
+      default: {
+        /* buffer rows so that each consumer's lock is taken once per batch */
+        RefPtr<BroadcastSink> broadcast(
+            new BroadcastSink(BroadcastSink::kDefaultBufferRows));
+
+        for (const auto& out : task_outputs) {
+          broadcast->addOutput(out.first, out.second);
+        }
+
+        broadcasts_.emplace(task_id, broadcast);
+        output_fn = broadcast->getSinkFn();
+        break;
+      }
+    }
+  }
+
+  auto instance = CachedTask::build(txn_, task->getFactory(), output_fn);
+  instances_.emplace(task_id, instance);
+  return instance;
+}
+
+} // namespace csql
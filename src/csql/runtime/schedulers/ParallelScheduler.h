@@ -0,0 +1,66 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <csql/runtime/Scheduler.h>
+#include <csql/runtime/schedulers/BroadcastSink.h>
+#include <csql/runtime/schedulers/PartitionSink.h>
+
+using namespace stx;
+
+namespace csql {
+class Transaction;
+
+/**
+ * Executes all runnable tasks of a TaskDAG concurrently on the runtime's
+ * thread pool. Rows that are handed from a task to its downstream tasks are
+ * serialized per receiving task, so Task::onInputRow is never called from two
+ * threads at once. Tasks with more than one consumer hand their rows to the
+ * consumers in batches (see BroadcastSink).
+ */
+class ParallelScheduler : public Scheduler {
+public:
+
+  static SchedulerFactory getFactory(size_t max_concurrent_tasks = 32);
+
+  ParallelScheduler(
+      Transaction* txn,
+      TaskDAG* tasks,
+      SchedulerCallbacks* callbacks,
+      size_t max_concurrent_tasks);
+
+  void execute() override;
+
+protected:
+
+  RefPtr<Task> buildInstance(const TaskID& task_id);
+
+  void runTask(const TaskID& task_id);
+
+  Transaction* txn_;
+  TaskDAG* tasks_;
+  SchedulerCallbacks* callbacks_;
+  size_t max_concurrent_tasks_;
+  HashMap<TaskID, RefPtr<Task>> instances_;
+  HashMap<TaskID, ScopedPtr<std::mutex>> input_locks_;
+  HashMap<TaskID, RefPtr<BroadcastSink>> broadcasts_;
+  HashMap<TaskID, RefPtr<PartitionSink>> partition_sinks_;
+  HashMap<TaskID, Vector<std::pair<Task*, std::mutex*>>> consumers_;
+  std::mutex callbacks_lock_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  Set<TaskID> running_;
+  Vector<TaskID> completed_;
+  std::exception_ptr error_;
+};
+
+} // namespace csql
@@ -0,0 +1,139 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/runtime/schedulers/PartitionSink.h>
+
+using namespace stx;
+
+namespace csql {
+
+PartitionSink::PartitionSink(
+    size_t buffer_rows /* = 0 */) :
+    buffer_rows_(buffer_rows),
+    num_active_(0) {}
+
+void PartitionSink::addOutput(
+    size_t partition,
+    RowSinkFn output,
+    std::mutex* lock /* = nullptr */) {
+  if (partition >= outputs_.size()) {
+    outputs_.resize(partition + 1);
+  }
+
+  auto& o = outputs_[partition];
+  if (o.fn) {
+    RAISEF(
+        kIllegalArgumentError,
+        "duplicate output for partition $0",
+        partition);
+  }
+
+  o.fn = output;
+  o.lock = lock;
+  o.done = false;
+  ++num_active_;
+}
+
+bool PartitionSink::onRow(const SValue* row, int row_len) {
+  if (num_active_ == 0) {
+    return false;
+  }
+
+  if (row_len < 1) {
+    RAISE(kRuntimeError, "partitioned row has no partition column");
+  }
+
+  auto partition = row[0].getInteger();
+  if (partition < 0 ||
+      uint64_t(partition) >= outputs_.size() ||
+      !outputs_[partition].fn) {
+    RAISEF(kRuntimeError, "no output for partition $0", partition);
+  }
+
+  auto& o = outputs_[partition];
+  if (o.done) {
+    return true;
+  }
+
+  if (buffer_rows_ > 0) {
+    o.buffer.insert(o.buffer.end(), row + 1, row + row_len);
+    o.buffer_row_lens.emplace_back(row_len - 1);
+    if (o.buffer_row_lens.size() < buffer_rows_) {
+      return true;
+    }
+
+    if (!deliver(&o)) {
+      o.done = true;
+      --num_active_;
+    }
+
+    return num_active_ > 0;
+  }
+
+  bool cont;
+  if (o.lock) {
+    std::unique_lock<std::mutex> lk(*o.lock);
+    cont = o.fn(row + 1, row_len - 1);
+  } else {
+    cont = o.fn(row + 1, row_len - 1);
+  }
+
+  if (!cont) {
+    o.done = true;
+    --num_active_;
+  }
+
+  return num_active_ > 0;
+}
+
+bool PartitionSink::flush() {
+  for (auto& o : outputs_) {
+    if (o.fn && !o.done && !deliver(&o)) {
+      o.done = true;
+      --num_active_;
+    }
+  }
+
+  return num_active_ > 0;
+}
+
+bool PartitionSink::deliver(Output* output) {
+  if (output->buffer_row_lens.empty()) {
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lk;
+  if (output->lock) {
+    lk = std::unique_lock<std::mutex>(*output->lock);
+  }
+
+  bool cont = true;
+  auto row = output->buffer.data();
+  for (auto row_len : output->buffer_row_lens) {
+    if (!output->fn(row, row_len)) {
+      cont = false;
+      break;
+    }
+
+    row += row_len;
+  }
+
+  output->buffer.clear();
+  output->buffer_row_lens.clear();
+  return cont;
+}
+
+RowSinkFn PartitionSink::getSinkFn() {
+  auto self = mkRef(this);
+  return [self] (const SValue* argv, int argc) -> bool {
+    return self->onRow(argv, argc);
+  };
+}
+
+} // namespace csql
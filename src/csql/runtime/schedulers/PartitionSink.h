@@ -0,0 +1,64 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <mutex>
+#include <stx/stdtypes.h>
+#include <stx/autoref.h>
+#include <csql/tasks/Task.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Routes the output rows of a task that partitions its output (see
+ * TaskDAGNode::Dependency::partition) to one consumer per partition. The first
+ * column of each row is the partition number; it is stripped before the row
+ * is handed to the consumer of that partition. Rows for a consumer that
+ * returned false are dropped; the producer is only told to stop once every
+ * consumer is done.
+ *
+ * buffer_rows and the output locks work like in BroadcastSink, except that
+ * each consumer has its own buffer.
+ */
+class PartitionSink : public RefCounted {
+public:
+
+  PartitionSink(size_t buffer_rows = 0);
+
+  void addOutput(
+      size_t partition,
+      RowSinkFn output,
+      std::mutex* lock = nullptr);
+
+  bool onRow(const SValue* row, int row_len);
+
+  bool flush();
+
+  RowSinkFn getSinkFn();
+
+protected:
+
+  struct Output {
+    RowSinkFn fn;
+    std::mutex* lock;
+    bool done;
+    Vector<SValue> buffer;
+    Vector<int> buffer_row_lens;
+  };
+
+  bool deliver(Output* output);
+
+  size_t buffer_rows_;
+  Vector<Output> outputs_;
+  size_t num_active_;
+};
+
+} // namespace csql
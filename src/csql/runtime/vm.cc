@@ -12,6 +12,8 @@
 #include <vector>
 #include <csql/runtime/compiler.h>
 #include <csql/runtime/LikePattern.h>
+#include <csql/runtime/RegexPattern.h>
+#include <csql/expressions/datetime.h>
 #include <csql/svalue.h>
 #include <csql/runtime/vm.h>
 #include <stx/exception.h>
@@ -23,6 +25,8 @@
 
 namespace csql {
 
+const size_t VM::kDefaultBatchSize = 1024;
+
 VM::Program::Program(
     Transaction* ctx,
     Instruction* entry,
@@ -256,13 +260,17 @@ void VM::freeProgram(
       break;
 
     case X_REGEX:
-      ((RegExp*) e->arg0)->~RegExp();
+      ((RegexPattern*) e->arg0)->~RegexPattern();
       break;
 
     case X_LIKE:
       ((LikePattern*) e->arg0)->~LikePattern();
       break;
 
+    case X_CALL_PREPARED:
+      delete (PreparedFunction*) e->arg0;
+      break;
+
     default:
       break;
   }
@@ -298,7 +306,8 @@ void VM::evaluate(
       return;
     }
 
-    case X_CALL_PURE: {
+    case X_CALL_PURE:
+    case X_CALL_PREPARED: {
       SValue* stackv = nullptr;
       auto stackn = expr->argn;
       if (stackn > 0) {
@@ -313,7 +322,19 @@ void VM::evaluate(
             evaluate(ctx, program, instance, cur, argc, argv, stackp++);
           }
 
-          expr->vtable.t_pure.call(Transaction::get(ctx), stackn, stackv, out);
+          if (expr->type == X_CALL_PREPARED) {
+            ((PreparedFunction*) expr->arg0)->call(
+                Transaction::get(ctx),
+                stackn,
+                stackv,
+                out);
+          } else {
+            expr->vtable.t_pure.call(
+                Transaction::get(ctx),
+                stackn,
+                stackv,
+                out);
+          }
         } catch (...) {
           for (int i = 0; i < stackn; ++i) {
             (stackv + i)->~SValue();
@@ -365,7 +386,14 @@ void VM::evaluate(
       auto subj_expr = expr->child;
       evaluate(ctx, program, instance, subj_expr, argc, argv, &subj);
 
-      auto match = ((RegExp*) expr->arg0)->match(subj.getString());
+      auto pattern = (RegexPattern*) expr->arg0;
+      bool match;
+      if (subj.getType() == SQL_STRING) {
+        match = pattern->match(subj.getStringData(), subj.getStringSize());
+      } else {
+        match = pattern->match(subj.getString());
+      }
+
       *out = SValue(SValue::BoolType(match));
 
       return;
@@ -376,12 +404,390 @@ void VM::evaluate(
       auto subj_expr = expr->child;
       evaluate(ctx, program, instance, subj_expr, argc, argv, &subj);
 
-      auto match = ((LikePattern*) expr->arg0)->match(subj.getString());
+      auto pattern = (LikePattern*) expr->arg0;
+      bool match;
+      if (subj.getType() == SQL_STRING) {
+        match = pattern->match(subj.getStringData(), subj.getStringSize());
+      } else {
+        match = pattern->match(subj.getString());
+      }
+
       *out = SValue(SValue::BoolType(match));
 
       return;
     }
 
+    /* arg0 holds the precision in microseconds, the first child is the
+       literal precision argument */
+    case X_DATE_TRUNC: {
+      SValue time;
+      auto time_expr = expr->child->next;
+      evaluate(ctx, program, instance, time_expr, argc, argv, &time);
+
+      expressions::dateTrunc((uint64_t) expr->arg0, time, out);
+      return;
+    }
+
+    /* arg0 holds the unit in microseconds, the last child is the literal
+       unit argument */
+    case X_DATE_ADD: {
+      SValue args[3];
+      auto date_expr = expr->child;
+      auto amount_expr = date_expr->next;
+      evaluate(ctx, program, instance, date_expr, argc, argv, &args[0]);
+      evaluate(ctx, program, instance, amount_expr, argc, argv, &args[1]);
+
+      if (!expressions::dateAdd((uint64_t) expr->arg0, args[0], args[1], out)) {
+        evaluate(ctx, program, instance, amount_expr->next, argc, argv, &args[2]);
+        expr->vtable.t_pure.call(Transaction::get(ctx), 3, args, out);
+      }
+
+      return;
+    }
+
+    /* the second operand is only evaluated if the first one doesn't decide
+       the result already */
+    case X_AND:
+    case X_OR: {
+      SValue lhs;
+      auto lhs_expr = expr->child;
+      evaluate(ctx, program, instance, lhs_expr, argc, argv, &lhs);
+
+      if (lhs.getBool() == (expr->type == X_OR)) {
+        *out = SValue(SValue::BoolType(expr->type == X_OR));
+        return;
+      }
+
+      SValue rhs;
+      evaluate(ctx, program, instance, lhs_expr->next, argc, argv, &rhs);
+      *out = SValue(SValue::BoolType(rhs.getBool()));
+      return;
+    }
+
+  }
+
+}
+
+/**
+ * Marks the input columns that are read by the expression
+ */
+static void markInputColumns(const VM::Instruction* expr, Vector<bool>* used) {
+  if (expr->type == VM::X_INPUT) {
+    auto index = reinterpret_cast<uint64_t>(expr->arg0);
+    if (index < used->size()) {
+      (*used)[index] = true;
+    }
+
+    return;
+  }
+
+  for (auto cur = expr->child; cur != nullptr; cur = cur->next) {
+    markInputColumns(cur, used);
+  }
+}
+
+void VM::evaluateBatch(
+    Transaction* ctx,
+    const Program* program,
+    size_t nrows,
+    int argc,
+    const SValue** columns,
+    SValue* out) {
+  return evaluateBatch(
+      ctx,
+      program,
+      program->entry_,
+      nrows,
+      argc,
+      columns,
+      out);
+}
+
+void VM::evaluateBatch(
+    Transaction* ctx,
+    const Program* program,
+    Instruction* expr,
+    size_t nrows,
+    int argc,
+    const SValue** columns,
+    SValue* out) {
+
+  switch (expr->type) {
+
+    case X_CALL_PURE:
+    case X_CALL_PREPARED: {
+      auto stackn = expr->argn;
+      Vector<Vector<SValue>> stack(stackn);
+      Vector<const SValue*> stackv(stackn, nullptr);
+
+      /* input columns are passed through to the function without a copy */
+      size_t stackp = 0;
+      for (auto cur = expr->child; cur != nullptr; cur = cur->next) {
+        if (cur->type == X_INPUT) {
+          auto index = reinterpret_cast<uint64_t>(cur->arg0);
+          if (index >= size_t(argc)) {
+            RAISE(kRuntimeError, "invalid row index %i", index);
+          }
+
+          stackv[stackp++] = columns[index];
+          continue;
+        }
+
+        stack[stackp].resize(nrows);
+        evaluateBatch(
+            ctx,
+            program,
+            cur,
+            nrows,
+            argc,
+            columns,
+            stack[stackp].data());
+
+        stackv[stackp] = stack[stackp].data();
+        ++stackp;
+      }
+
+      /* a prepared function only saves the per-row literal conversion, so
+         the function's vectorized variant is still preferred if it has one */
+      if (expr->vtable.t_pure.vcall) {
+        expr->vtable.t_pure.vcall(
+            Transaction::get(ctx),
+            stackn,
+            stackv.data(),
+            nrows,
+            out);
+      } else if (expr->type == X_CALL_PREPARED) {
+        auto fn = (PreparedFunction*) expr->arg0;
+        Vector<SValue> row(stackn, SValue{});
+        for (size_t n = 0; n < nrows; ++n) {
+          for (size_t i = 0; i < stackn; ++i) {
+            row[i] = stackv[i][n];
+          }
+
+          fn->call(Transaction::get(ctx), stackn, row.data(), out + n);
+        }
+      } else {
+        Vector<SValue> row(stackn, SValue{});
+        for (size_t n = 0; n < nrows; ++n) {
+          for (size_t i = 0; i < stackn; ++i) {
+            row[i] = stackv[i][n];
+          }
+
+          expr->vtable.t_pure.call(
+              Transaction::get(ctx),
+              stackn,
+              row.data(),
+              out + n);
+        }
+      }
+
+      return;
+    }
+
+    case X_CALL_AGGREGATE:
+      RAISE(
+          kIllegalArgumentError,
+          "non-static expression called without instance pointer");
+
+    case X_LITERAL: {
+      const auto& value = *static_cast<SValue*>(expr->arg0);
+      for (size_t n = 0; n < nrows; ++n) {
+        out[n] = value;
+      }
+
+      return;
+    }
+
+    case X_INPUT: {
+      auto index = reinterpret_cast<uint64_t>(expr->arg0);
+      if (index >= size_t(argc)) {
+        RAISE(kRuntimeError, "invalid row index %i", index);
+      }
+
+      for (size_t n = 0; n < nrows; ++n) {
+        out[n] = columns[index][n];
+      }
+
+      return;
+    }
+
+    case X_REGEX:
+    case X_LIKE: {
+      Vector<SValue> subj(nrows, SValue{});
+      evaluateBatch(
+          ctx,
+          program,
+          expr->child,
+          nrows,
+          argc,
+          columns,
+          subj.data());
+
+      for (size_t n = 0; n < nrows; ++n) {
+        String str;
+        const char* data;
+        size_t size;
+        if (subj[n].getType() == SQL_STRING) {
+          data = subj[n].getStringData();
+          size = subj[n].getStringSize();
+        } else {
+          str = subj[n].getString();
+          data = str.data();
+          size = str.size();
+        }
+
+        bool match;
+        if (expr->type == X_REGEX) {
+          match = ((RegexPattern*) expr->arg0)->match(data, size);
+        } else {
+          match = ((LikePattern*) expr->arg0)->match(data, size);
+        }
+
+        out[n] = SValue(SValue::BoolType(match));
+      }
+
+      return;
+    }
+
+    case X_DATE_TRUNC: {
+      Vector<SValue> time(nrows, SValue{});
+      evaluateBatch(
+          ctx,
+          program,
+          expr->child->next,
+          nrows,
+          argc,
+          columns,
+          time.data());
+
+      for (size_t n = 0; n < nrows; ++n) {
+        expressions::dateTrunc((uint64_t) expr->arg0, time[n], out + n);
+      }
+
+      return;
+    }
+
+    case X_DATE_ADD: {
+      Vector<SValue> date(nrows, SValue{});
+      Vector<SValue> amount(nrows, SValue{});
+      auto date_expr = expr->child;
+      auto amount_expr = date_expr->next;
+      evaluateBatch(ctx, program, date_expr, nrows, argc, columns, date.data());
+      evaluateBatch(
+          ctx,
+          program,
+          amount_expr,
+          nrows,
+          argc,
+          columns,
+          amount.data());
+
+      for (size_t n = 0; n < nrows; ++n) {
+        if (!expressions::dateAdd(
+                (uint64_t) expr->arg0,
+                date[n],
+                amount[n],
+                out + n)) {
+          SValue args[3] = { date[n], amount[n], SValue() };
+          evaluate(ctx, program, nullptr, amount_expr->next, 0, nullptr, &args[2]);
+          expr->vtable.t_pure.call(Transaction::get(ctx), 3, args, out + n);
+        }
+      }
+
+      return;
+    }
+
+    /* the second operand is evaluated only for the rows that the first
+       operand didn't decide. those rows of the input columns that the second
+       operand reads are gathered into a smaller batch */
+    case X_AND:
+    case X_OR: {
+      bool is_or = expr->type == X_OR;
+      Vector<SValue> lhs(nrows, SValue{});
+      evaluateBatch(
+          ctx,
+          program,
+          expr->child,
+          nrows,
+          argc,
+          columns,
+          lhs.data());
+
+      Vector<size_t> undecided;
+      for (size_t n = 0; n < nrows; ++n) {
+        if (lhs[n].getBool() == is_or) {
+          out[n] = SValue(SValue::BoolType(is_or));
+        } else {
+          undecided.emplace_back(n);
+        }
+      }
+
+      if (undecided.empty()) {
+        return;
+      }
+
+      auto rhs_expr = expr->child->next;
+      Vector<SValue> rhs(undecided.size(), SValue{});
+      if (undecided.size() == nrows) {
+        evaluateBatch(
+            ctx,
+            program,
+            rhs_expr,
+            nrows,
+            argc,
+            columns,
+            rhs.data());
+      } else {
+        Vector<bool> used(argc, false);
+        markInputColumns(rhs_expr, &used);
+
+        Vector<Vector<SValue>> subset(argc);
+        Vector<const SValue*> subset_columns(argc, nullptr);
+        for (size_t i = 0; i < used.size(); ++i) {
+          if (!used[i]) {
+            continue;
+          }
+
+          subset[i].reserve(undecided.size());
+          for (auto n : undecided) {
+            subset[i].emplace_back(columns[i][n]);
+          }
+
+          subset_columns[i] = subset[i].data();
+        }
+
+        evaluateBatch(
+            ctx,
+            program,
+            rhs_expr,
+            undecided.size(),
+            argc,
+            subset_columns.data(),
+            rhs.data());
+      }
+
+      for (size_t i = 0; i < undecided.size(); ++i) {
+        out[undecided[i]] = SValue(SValue::BoolType(rhs[i].getBool()));
+      }
+
+      return;
+    }
+
+    /* only the taken branch may be evaluated, so fall back to row-at-a-time
+       evaluation for conditionals */
+    case X_IF: {
+      Vector<SValue> row(argc, SValue{});
+      for (size_t n = 0; n < nrows; ++n) {
+        for (size_t i = 0; i < row.size(); ++i) {
+          row[i] = columns[i][n];
+        }
+
+        evaluate(ctx, program, nullptr, expr, argc, row.data(), out + n);
+      }
+
+      return;
+    }
+
   }
 
 }
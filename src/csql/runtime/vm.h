@@ -26,7 +26,12 @@ public:
     X_INPUT,
     X_IF,
     X_REGEX,
-    X_LIKE
+    X_LIKE,
+    X_DATE_TRUNC,
+    X_DATE_ADD,
+    X_AND,
+    X_OR,
+    X_CALL_PREPARED
   };
 
   struct Instruction {
@@ -69,6 +74,21 @@ public:
       const SValue* argv,
       SValue* out);
 
+  /**
+   * Evaluate a static program for nrows rows at once. The input is passed
+   * column-wise: columns[i] points to nrows values of input column i. The
+   * result for each row is written to out[0..nrows)
+   */
+  static void evaluateBatch(
+      Transaction* ctx,
+      const Program* program,
+      size_t nrows,
+      int argc,
+      const SValue** columns,
+      SValue* out);
+
+  static const size_t kDefaultBatchSize;
+
   static Instance allocInstance(
       Transaction* ctx,
       const Program* program,
@@ -127,6 +147,15 @@ protected:
       const SValue* argv,
       SValue* out);
 
+  static void evaluateBatch(
+      Transaction* ctx,
+      const Program* program,
+      Instruction* expr,
+      size_t nrows,
+      int argc,
+      const SValue** columns,
+      SValue* out);
+
   static void accumulate(
       Transaction* ctx,
       const Program* program,
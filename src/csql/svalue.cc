@@ -71,36 +71,17 @@ SValue::SValue() {
 }
 
 SValue::~SValue() {
-  switch (data_.type) {
-
-    case SQL_STRING:
-      free(data_.u.t_string.ptr);
-      break;
-
-    default:
-      break;
-
-  }
+  releaseString();
 }
 
 SValue::SValue(const SValue::StringType& string_value) {
-  data_.type = SQL_STRING;
-  data_.u.t_string.len = string_value.size();
-  data_.u.t_string.ptr = static_cast<char *>(malloc(data_.u.t_string.len));
-
-  if (data_.u.t_string.ptr == nullptr) {
-    RAISE(kRuntimeError, "could not allocate SValue");
-  }
-
-  memcpy(
-      data_.u.t_string.ptr,
-      string_value.data(),
-      data_.u.t_string.len);
+  initString(string_value.data(), string_value.size());
 }
 
 SValue::SValue(
-    char const* string_value) :
-    SValue(std::string(string_value)) {}
+    char const* string_value) {
+  initString(string_value, strlen(string_value));
+}
 
 SValue::SValue(SValue::IntegerType integer_value) {
   data_.type = SQL_INTEGER;
@@ -123,54 +104,80 @@ SValue::SValue(SValue::TimeType time_value) {
 }
 
 SValue::SValue(const SValue& copy) {
-  switch (copy.data_.type) {
-
-    case SQL_STRING:
-      data_.type = SQL_STRING;
-      data_.u.t_string.len = copy.data_.u.t_string.len;
-      data_.u.t_string.ptr = static_cast<char *>(malloc(data_.u.t_string.len));
+  memcpy(&data_, &copy.data_, sizeof(data_));
+  retainString();
+}
 
-      if (data_.u.t_string.ptr == nullptr) {
-        RAISE(kRuntimeError, "could not allocate SValue");
-      }
+SValue::SValue(SValue&& move) {
+  memcpy(&data_, &move.data_, sizeof(data_));
+  move.data_.type = SQL_NULL;
+}
 
-      memcpy(
-          data_.u.t_string.ptr,
-          copy.data_.u.t_string.ptr,
-          data_.u.t_string.len);
-      break;
+SValue& SValue::operator=(const SValue& copy) {
+  if (this == &copy) {
+    return *this;
+  }
 
-    default:
-      memcpy(&data_, &copy.data_, sizeof(data_));
-      break;
+  releaseString();
+  memcpy(&data_, &copy.data_, sizeof(data_));
+  retainString();
+  return *this;
+}
 
+SValue& SValue::operator=(SValue&& move) {
+  if (this == &move) {
+    return *this;
   }
 
+  releaseString();
+  memcpy(&data_, &move.data_, sizeof(data_));
+  move.data_.type = SQL_NULL;
+  return *this;
 }
 
-SValue& SValue::operator=(const SValue& copy) {
-  if (data_.type == SQL_STRING) {
-    free(data_.u.t_string.ptr);
+void SValue::initString(const char* data, size_t size) {
+  data_.type = SQL_STRING;
+  data_.string_len = size;
+
+  if (size <= kMaxInlineStringSize) {
+    memcpy(data_.u.t_inline_string, data, size);
+    return;
   }
 
-  if (copy.data_.type == SQL_STRING) {
-    data_.type = SQL_STRING;
-    data_.u.t_string.len = copy.data_.u.t_string.len;
-    data_.u.t_string.ptr = static_cast<char *>(malloc(data_.u.t_string.len));
+  auto buf = static_cast<StringBuffer*>(malloc(sizeof(StringBuffer) + size));
+  if (buf == nullptr) {
+    RAISE(kRuntimeError, "could not allocate SValue");
+  }
+
+  new (&buf->refcount) std::atomic<uint32_t>(1);
+  memcpy(buf->data, data, size);
+  data_.u.t_string = buf;
+}
 
-    if (data_.u.t_string.ptr == nullptr) {
-      RAISE(kRuntimeError, "could not allocate SValue");
+void SValue::retainString() {
+  if (data_.type == SQL_STRING && data_.string_len > kMaxInlineStringSize) {
+    data_.u.t_string->refcount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void SValue::releaseString() {
+  if (data_.type == SQL_STRING && data_.string_len > kMaxInlineStringSize) {
+    if (data_.u.t_string->refcount.fetch_sub(1) == 1) {
+      free(data_.u.t_string);
     }
+  }
+}
 
-    memcpy(
-        data_.u.t_string.ptr,
-        copy.data_.u.t_string.ptr,
-        data_.u.t_string.len);
+const char* SValue::getStringData() const {
+  if (data_.string_len > kMaxInlineStringSize) {
+    return data_.u.t_string->data;
   } else {
-    memcpy(&data_, &copy.data_, sizeof(data_));
+    return data_.u.t_inline_string;
   }
+}
 
-  return *this;
+size_t SValue::getStringSize() const {
+  return data_.string_len;
 }
 
 bool SValue::operator==(const SValue& other) const {
@@ -193,10 +200,10 @@ bool SValue::operator==(const SValue& other) const {
     }
 
     case SQL_STRING: {
-      return memcmp(
-          data_.u.t_string.ptr,
-          other.data_.u.t_string.ptr,
-          data_.u.t_string.len) == 0;
+      return
+          other.data_.type == SQL_STRING &&
+          getStringSize() == other.getStringSize() &&
+          memcmp(getStringData(), other.getStringData(), getStringSize()) == 0;
     }
 
     case SQL_NULL: {
@@ -407,7 +414,7 @@ SValue SValue::toString() const {
 
 std::string SValue::getString() const {
   if (data_.type == SQL_STRING) {
-    return std::string(data_.u.t_string.ptr, data_.u.t_string.len);
+    return std::string(getStringData(), getStringSize());
   }
 
   char buf[512];
@@ -662,7 +669,7 @@ void SValue::encode(OutputStream* os) const {
 
   switch (data_.type) {
     case SQL_STRING:
-      os->appendLenencString(data_.u.t_string.ptr, data_.u.t_string.len);
+      os->appendLenencString(getStringData(), getStringSize());
       return;
     case SQL_FLOAT:
       os->appendDouble(data_.u.t_float);
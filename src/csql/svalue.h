@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <stdlib.h>
+#include <atomic>
 #include <string>
 #include <string.h>
 #include <vector>
@@ -48,7 +49,9 @@ public:
 
   explicit SValue();
   SValue(const SValue& copy);
+  SValue(SValue&& move);
   SValue& operator=(const SValue& copy);
+  SValue& operator=(SValue&& move);
   bool operator==(const SValue& other) const;
   ~SValue();
 
@@ -75,6 +78,13 @@ public:
   BoolType getBool() const;
   TimeType getTimestamp() const;
 
+  /**
+   * Access the characters of a STRING value without copying them. The pointer
+   * is only valid as long as the SValue is not modified or destroyed
+   */
+  const char* getStringData() const;
+  size_t getStringSize() const;
+
   template <typename T> bool isConvertibleTo() const;
   bool isConvertibleToString() const;
   bool isConvertibleToNumeric() const;
@@ -98,17 +108,32 @@ public:
   static std::string makeUniqueKey(SValue* arr, size_t len);
 
 protected:
+
+  /**
+   * Strings of up to kMaxInlineStringSize bytes are stored inline, longer
+   * strings in a reference counted buffer that is shared between copies
+   */
+  static const size_t kMaxInlineStringSize = 16;
+
+  struct StringBuffer {
+    std::atomic<uint32_t> refcount;
+    char data[1];
+  };
+
+  void initString(const char* data, size_t size);
+  void retainString();
+  void releaseString();
+
   struct {
     sql_type type;
+    uint32_t string_len;
     union {
       int64_t t_integer;
       double t_float;
       bool t_bool;
       uint64_t t_timestamp;
-      struct {
-        char* ptr;
-        uint32_t len;
-      } t_string;
+      StringBuffer* t_string;
+      char t_inline_string[kMaxInlineStringSize];
     } u;
   } data_;
 };
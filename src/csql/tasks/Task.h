@@ -32,6 +32,12 @@ public:
 
   virtual void onInputsReady() {}
 
+  /**
+   * Called once the input task has finished and all of its rows were passed
+   * to onInputRow. Other input tasks may still be running
+   */
+  virtual void onInputComplete(const TaskID& input_id) {}
+
   virtual bool onInputRow(
       const TaskID& input_id,
       const SValue* row,
@@ -129,6 +129,18 @@ Set<TaskID> TaskDAG::getOutputTasksFor(const TaskID& task_id) const {
   }
 }
 
+Option<size_t> TaskDAG::getInputPartition(
+    const TaskID& task_id,
+    const TaskID& input_task_id) const {
+  for (const auto& dep : getTask(task_id)->getDependencies()) {
+    if (dep.task_id == input_task_id) {
+      return dep.partition;
+    }
+  }
+
+  return None<size_t>();
+}
+
 Set<TaskID> TaskDAG::getAllTasks() const {
   Set<TaskID> ids;
   for (const auto& task : task_status_) {
@@ -153,4 +165,22 @@ size_t TaskDAG::getNumTasks() const {
   return tasks_.size();
 }
 
+void TaskDAG::setNodeTasks(
+    const QueryTreeNode* node,
+    const Vector<TaskID>& task_ids) {
+  node_tasks_[node] = task_ids;
+}
+
+bool TaskDAG::getNodeTasks(
+    const QueryTreeNode* node,
+    Vector<TaskID>* task_ids) const {
+  auto iter = node_tasks_.find(node);
+  if (iter == node_tasks_.end()) {
+    return false;
+  }
+
+  *task_ids = iter->second;
+  return true;
+}
+
 } // namespace csql
@@ -15,6 +15,7 @@
 using namespace stx;
 
 namespace csql {
+class QueryTreeNode;
 
 enum TaskStatus {
   WAITING, RUNNABLE, COMPLETED
@@ -25,6 +26,13 @@ public:
 
   struct Dependency {
     TaskID task_id;
+
+    /**
+     * If set, the input task partitions its output: the first column of each
+     * output row is the partition number, and only the rows of this partition
+     * are routed to the dependent task (without the partition column)
+     */
+    Option<size_t> partition;
   };
 
   TaskDAGNode(TableExpressionFactoryRef expr);
@@ -54,11 +62,28 @@ public:
   Set<TaskID> getOutputTasksFor(const TaskID& task_id) const;
   Set<TaskID> getInputTasksFor(const TaskID& task_id) const;
 
+  /**
+   * Returns the partition of the input task's output that is routed to the
+   * task or None if the task receives all of the input task's rows
+   */
+  Option<size_t> getInputPartition(
+      const TaskID& task_id,
+      const TaskID& input_task_id) const;
+
   Set<TaskID> getAllTasks() const;
   Set<TaskID> getRunnableTasks() const;
 
   size_t getNumTasks() const;
 
+  /**
+   * Remember the tasks that were built for a query tree node. A node that is
+   * referenced from more than one place in the plan is only built once and
+   * its tasks are routed to every consumer.
+   */
+  void setNodeTasks(const QueryTreeNode* node, const Vector<TaskID>& task_ids);
+
+  bool getNodeTasks(const QueryTreeNode* node, Vector<TaskID>* task_ids) const;
+
 protected:
 
   void findRunnableTasks();
@@ -66,6 +91,7 @@ protected:
   HashMap<TaskID, RefPtr<TaskDAGNode>> tasks_;
   HashMap<TaskID, TaskStatus> task_status_;
   HashMap<TaskID, Set<TaskID>> task_deps_;
+  HashMap<const QueryTreeNode*, Vector<TaskID>> node_tasks_;
 };
 
 } // namespace csql
@@ -0,0 +1,151 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <stx/io/fileutil.h>
+#include <stx/io/inputstream.h>
+#include <csql/tasks/cached_task.h>
+#include <csql/runtime/runtime.h>
+
+namespace csql {
+
+RefPtr<Task> CachedTask::build(
+    Transaction* txn,
+    TableExpressionFactoryRef factory,
+    RowSinkFn output) {
+  auto cache = txn->getRuntime()->resultCache();
+  if (cache.get() == nullptr) {
+    return factory->build(txn, output);
+  }
+
+  RefPtr<CachedTask> cached(new CachedTask(cache, output));
+  auto cached_ptr = cached.get();
+  cached->task_ = factory->build(
+      txn,
+      [cached_ptr] (const SValue* argv, int argc) -> bool {
+        return cached_ptr->onOutputRow(argv, argc);
+      });
+
+  return cached.get();
+}
+
+CachedTask::CachedTask(
+    RefPtr<ResultCache> cache,
+    RowSinkFn output) :
+    cache_(cache),
+    output_(output),
+    recording_(false),
+    num_rows_(0),
+    os_(StringOutputStream::fromString(&buf_)) {}
+
+Option<SHA1Hash> CachedTask::cacheKey() const {
+  return task_->cacheKey();
+}
+
+bool CachedTask::onInputRow(
+    const TaskID& input_id,
+    const SValue* row,
+    int row_len) {
+  return task_->onInputRow(input_id, row, row_len);
+}
+
+void CachedTask::onInputComplete(const TaskID& input_id) {
+  task_->onInputComplete(input_id);
+}
+
+void CachedTask::onInputsReady() {
+  auto cache_key = task_->cacheKey();
+  if (cache_key.isEmpty()) {
+    task_->onInputsReady();
+    return;
+  }
+
+  auto is = cache_->openResult(cache_key.get());
+  if (is.get() != nullptr) {
+    replayResult(is.get());
+    return;
+  }
+
+  recording_ = true;
+  task_->onInputsReady();
+
+  if (recording_) {
+    storeResult(cache_key.get());
+  }
+
+  buf_.clear();
+}
+
+bool CachedTask::onOutputRow(const SValue* row, int row_len) {
+  if (recording_) {
+    os_->appendVarUInt(row_len);
+    for (int i = 0; i < row_len; ++i) {
+      row[i].encode(os_.get());
+    }
+
+    ++num_rows_;
+    if (buf_.size() > kMaxCachedResultSize ||
+        buf_.size() > cache_->maxSize()) {
+      recording_ = false;
+      buf_.clear();
+    }
+  }
+
+  if (!output_(row, row_len)) {
+    recording_ = false;
+    return false;
+  }
+
+  return true;
+}
+
+void CachedTask::replayResult(InputStream* is) {
+  auto num_rows = is->readVarUInt();
+
+  Vector<SValue> row;
+  for (size_t i = 0; i < num_rows; ++i) {
+    row.resize(is->readVarUInt());
+    for (auto& v : row) {
+      v.decode(is);
+    }
+
+    if (!output_(row.data(), row.size())) {
+      return;
+    }
+  }
+}
+
+void CachedTask::storeResult(const SHA1Hash& cache_key) {
+  /* write to a temporary file first so that a concurrent reader never sees a
+     partial result */
+  auto tmpfile = cache_->getTempFilename(cache_key);
+
+  try {
+    String header;
+    auto header_os = StringOutputStream::fromString(&header);
+    header_os->appendVarUInt(num_rows_);
+
+    {
+      auto file = FileOutputStream::openFile(tmpfile);
+      file->write(header.data(), header.size());
+      file->write(buf_.data(), buf_.size());
+    }
+
+    cache_->storeResult(
+        cache_key,
+        tmpfile,
+        header.size() + buf_.size());
+  } catch (const std::exception& e) {
+    /* failing to store the result doesn't affect the query result */
+    if (FileUtil::exists(tmpfile)) {
+      FileUtil::rm(tmpfile);
+    }
+  }
+}
+
+} // namespace csql
@@ -0,0 +1,73 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <stx/io/outputstream.h>
+#include <csql/tasks/Task.h>
+#include <csql/tasks/TaskFactory.h>
+#include <csql/runtime/ResultCache.h>
+
+using namespace stx;
+
+namespace csql {
+
+/**
+ * Caches the output of a task in the runtime's result cache. If the wrapped task
+ * has a cache key and a result for that key was stored before, the stored
+ * rows are replayed instead of executing the task. Otherwise the output is
+ * recorded and stored once the task has finished.
+ *
+ * Only complete results are stored: the result is dropped if a consumer stops
+ * early or if it exceeds kMaxCachedResultSize or the size of the result cache.
+ */
+class CachedTask : public Task {
+public:
+
+  static const size_t kMaxCachedResultSize = 64 * 1024 * 1024;
+
+  /**
+   * Build a task from the provided factory and wrap it in a CachedTask. If
+   * the runtime's result cache is not enabled, the task is returned unwrapped
+   */
+  static RefPtr<Task> build(
+      Transaction* txn,
+      TableExpressionFactoryRef factory,
+      RowSinkFn output);
+
+  CachedTask(RefPtr<ResultCache> cache, RowSinkFn output);
+
+  Option<SHA1Hash> cacheKey() const override;
+
+  bool onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) override;
+
+  void onInputsReady() override;
+
+  void onInputComplete(const TaskID& input_id) override;
+
+protected:
+
+  bool onOutputRow(const SValue* row, int row_len);
+
+  void replayResult(InputStream* is);
+  void storeResult(const SHA1Hash& cache_key);
+
+  RefPtr<ResultCache> cache_;
+  RowSinkFn output_;
+  RefPtr<Task> task_;
+  bool recording_;
+  size_t num_rows_;
+  String buf_;
+  ScopedPtr<OutputStream> os_;
+};
+
+} // namespace csql
@@ -0,0 +1,246 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/tasks/group_over_timewindow.h>
+#include <csql/runtime/runtime.h>
+
+namespace csql {
+
+GroupOverTimewindow::GroupOverTimewindow(
+    Transaction* txn,
+    Vector<ValueExpression> select_expressions,
+    Vector<ValueExpression> group_expressions,
+    ValueExpression time_expression,
+    uint64_t window,
+    uint64_t step,
+    bool ordered_input,
+    bool has_having,
+    RowSinkFn output) :
+    txn_(txn),
+    select_exprs_(std::move(select_expressions)),
+    group_exprs_(std::move(group_expressions)),
+    time_expr_(std::move(time_expression)),
+    window_(window),
+    step_(step),
+    ordered_input_(ordered_input),
+    has_having_(has_having),
+    output_(output),
+    group_key_(group_exprs_.size(), SValue{}),
+    emitted_until_(0),
+    done_(false) {
+  if (window_ == 0 || step_ == 0) {
+    RAISE(kIllegalArgumentError, "TIMEWINDOW window and step must be > 0");
+  }
+}
+
+GroupOverTimewindow::~GroupOverTimewindow() {
+  for (auto& w : windows_) {
+    freeWindow(w.second.get());
+  }
+}
+
+GroupOverTimewindow::Window::Window(
+    size_t key_len,
+    size_t value_len) :
+    groups(key_len, value_len) {}
+
+bool GroupOverTimewindow::onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) {
+  if (done_) {
+    return false;
+  }
+
+  SValue time_val;
+  VM::evaluate(txn_, time_expr_.program(), row_len, row, &time_val);
+  if (time_val.getType() == SQL_NULL) {
+    return true;
+  }
+
+  uint64_t time = time_val.getTimestamp().unixMicros();
+
+  uint64_t first_start = 0;
+  if (time >= window_) {
+    first_start = ((time - window_) / step_ + 1) * step_;
+  }
+
+  /* with an ordered input, all windows that end before this row are
+     complete */
+  if (ordered_input_) {
+    if (first_start + window_ <= emitted_until_) {
+      RAISE(kRuntimeError, "TIMEWINDOW input is not ordered by time");
+    }
+
+    if (time > emitted_until_ && !emitWindows(time)) {
+      done_ = true;
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < group_exprs_.size(); ++i) {
+    VM::evaluate(
+        txn_,
+        group_exprs_[i].program(),
+        row_len,
+        row,
+        &group_key_[i]);
+  }
+
+  for (auto start = first_start; start <= time; start += step_) {
+    auto iter = windows_.find(start);
+    if (iter == windows_.end()) {
+      iter = windows_.emplace(
+          start,
+          mkScoped(new Window(group_exprs_.size(), select_exprs_.size())))
+          .first;
+    }
+
+    auto window = iter->second.get();
+    bool inserted;
+    auto group = window->groups.findOrInsert(group_key_.data(), &inserted);
+    if (inserted) {
+      for (size_t i = 0; i < select_exprs_.size(); ++i) {
+        group[i] = VM::allocInstance(
+            txn_,
+            select_exprs_[i].program(),
+            &window->scratch);
+      }
+    }
+
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::accumulate(
+          txn_,
+          select_exprs_[i].program(),
+          &group[i],
+          row_len,
+          row);
+    }
+  }
+
+  return true;
+}
+
+void GroupOverTimewindow::onInputsReady() {
+  if (!done_) {
+    emitWindows(uint64_t(-1));
+  }
+}
+
+bool GroupOverTimewindow::emitWindows(uint64_t until) {
+  emitted_until_ = until;
+
+  while (!windows_.empty()) {
+    auto iter = windows_.begin();
+    if (iter->first + window_ > until) {
+      break;
+    }
+
+    auto start = iter->first;
+    ScopedPtr<Window> window(std::move(iter->second));
+    windows_.erase(iter);
+
+    bool cont;
+    try {
+      cont = emitWindow(start, window.get());
+    } catch (...) {
+      freeWindow(window.get());
+      throw;
+    }
+
+    freeWindow(window.get());
+    if (!cont) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool GroupOverTimewindow::emitWindow(uint64_t start, Window* window) {
+  size_t num_columns = select_exprs_.size() - (has_having_ ? 1 : 0);
+
+  /* the first column is the window start */
+  Vector<SValue> out_row(num_columns + 1, SValue{});
+  out_row[0] = SValue(SValue::TimeType(start));
+
+  SValue having_result;
+  for (size_t g = 0; g < window->groups.size(); ++g) {
+    auto group = window->groups.getGroup(g);
+
+    if (has_having_) {
+      VM::result(
+          txn_,
+          select_exprs_[num_columns].program(),
+          &group[num_columns],
+          &having_result);
+
+      if (!having_result.getBool()) {
+        continue;
+      }
+    }
+
+    for (size_t i = 0; i < num_columns; ++i) {
+      VM::result(txn_, select_exprs_[i].program(), &group[i], &out_row[i + 1]);
+    }
+
+    if (!output_(out_row.data(), out_row.size())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void GroupOverTimewindow::freeWindow(Window* window) {
+  for (size_t g = 0; g < window->groups.size(); ++g) {
+    auto group = window->groups.getGroup(g);
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::freeInstance(txn_, select_exprs_[i].program(), &group[i]);
+    }
+  }
+
+  window->groups.clear();
+}
+
+GroupOverTimewindowFactory::GroupOverTimewindowFactory(
+    Vector<RefPtr<SelectListNode>> select_exprs,
+    Vector<RefPtr<ValueExpressionNode>> group_exprs,
+    Option<RefPtr<ValueExpressionNode>> having_expr,
+    RefPtr<ValueExpressionNode> time_expr,
+    uint64_t window,
+    uint64_t step,
+    bool ordered_input) :
+    GroupByFactory(select_exprs, group_exprs, having_expr),
+    time_expr_(time_expr),
+    window_(window),
+    step_(step),
+    ordered_input_(ordered_input) {}
+
+RefPtr<Task> GroupOverTimewindowFactory::build(
+    Transaction* txn,
+    RowSinkFn output) const {
+  Vector<ValueExpression> select_expressions;
+  Vector<ValueExpression> group_expressions;
+  compileExpressions(txn, &select_expressions, &group_expressions, nullptr);
+
+  auto qbuilder = txn->getRuntime()->queryBuilder();
+  return new GroupOverTimewindow(
+      txn,
+      std::move(select_expressions),
+      std::move(group_expressions),
+      qbuilder->buildValueExpression(txn, time_expr_),
+      window_,
+      step_,
+      ordered_input_,
+      !having_expr_.isEmpty(),
+      output);
+}
+
+} // namespace csql
@@ -0,0 +1,111 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth, zScale Technology GmbH
+ *
+ * libcsql is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <map>
+#include <stx/stdtypes.h>
+#include <csql/tasks/groupby.h>
+
+namespace csql {
+
+/**
+ * Aggregates the input rows over time windows. A row with time t is added to
+ * every window [start, start + window) that contains t, where the window
+ * starts are multiples of step (all in microseconds). Within each window, rows
+ * are grouped by the group expressions like in GroupBy.
+ *
+ * If the planner knows that the input is ordered by time (ordered_input), a
+ * window is emitted and freed once the input has advanced past its end, so
+ * only the open windows are kept in memory. Otherwise all windows are kept
+ * until the input is complete. A row that arrives after one of its windows
+ * was emitted from an ordered input raises an error.
+ *
+ * Each output row starts with the window start time, followed by the select
+ * expressions. Windows are emitted in order of their start time. Windows that
+ * didn't receive any rows are not emitted. has_having works like in GroupBy
+ */
+class GroupOverTimewindow : public Task {
+public:
+
+  GroupOverTimewindow(
+      Transaction* txn,
+      Vector<ValueExpression> select_expressions,
+      Vector<ValueExpression> group_expressions,
+      ValueExpression time_expression,
+      uint64_t window,
+      uint64_t step,
+      bool ordered_input,
+      bool has_having,
+      RowSinkFn output);
+
+  ~GroupOverTimewindow();
+
+  bool onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) override;
+
+  void onInputsReady() override;
+
+protected:
+
+  struct Window {
+    Window(size_t key_len, size_t value_len);
+    GroupHashMap groups;
+    ScratchMemory scratch;
+  };
+
+  /**
+   * Emits and frees all windows that end at or before the provided time.
+   * Returns false if the output doesn't accept any more rows
+   */
+  bool emitWindows(uint64_t until);
+
+  bool emitWindow(uint64_t start, Window* window);
+  void freeWindow(Window* window);
+
+  Transaction* txn_;
+  Vector<ValueExpression> select_exprs_;
+  Vector<ValueExpression> group_exprs_;
+  ValueExpression time_expr_;
+  uint64_t window_;
+  uint64_t step_;
+  bool ordered_input_;
+  bool has_having_;
+  RowSinkFn output_;
+  std::map<uint64_t, ScopedPtr<Window>> windows_;
+  Vector<SValue> group_key_;
+  uint64_t emitted_until_;
+  bool done_;
+};
+
+class GroupOverTimewindowFactory : public GroupByFactory {
+public:
+
+  GroupOverTimewindowFactory(
+      Vector<RefPtr<SelectListNode>> select_exprs,
+      Vector<RefPtr<ValueExpressionNode>> group_exprs,
+      Option<RefPtr<ValueExpressionNode>> having_expr,
+      RefPtr<ValueExpressionNode> time_expr,
+      uint64_t window,
+      uint64_t step,
+      bool ordered_input);
+
+  RefPtr<Task> build(
+      Transaction* txn,
+      RowSinkFn output) const override;
+
+protected:
+  RefPtr<ValueExpressionNode> time_expr_;
+  uint64_t window_;
+  uint64_t step_;
+  bool ordered_input_;
+};
+
+}
@@ -9,7 +9,11 @@
  */
 #include <stx/io/BufferedOutputStream.h>
 #include <stx/io/fileutil.h>
+#include <stx/io/inputstream.h>
+#include <stx/io/outputstream.h>
+#include <stx/random.h>
 #include <csql/tasks/groupby.h>
+#include <csql/runtime/runtime.h>
 
 namespace csql {
 
@@ -17,48 +21,97 @@ GroupBy::GroupBy(
     Transaction* txn,
     Vector<ValueExpression> select_expressions,
     Vector<ValueExpression> group_expressions,
+    SharedExpressions shared_expressions,
+    bool has_having,
     RowSinkFn output) :
     txn_(txn),
     select_exprs_(std::move(select_expressions)),
     group_exprs_(std::move(group_expressions)),
-    output_(output) {}
+    shared_exprs_(std::move(shared_expressions)),
+    has_having_(has_having),
+    output_(output),
+    groups_(group_exprs_.size(), select_exprs_.size()),
+    group_key_(group_exprs_.size(), SValue{}),
+    scratch_(new ScratchMemory()),
+    memory_used_(0),
+    memory_budget_(txn->getRuntime()->memoryBudget()),
+    spill_dir_(txn->getRuntime()->cacheDir()) {
+  /* rough per-group footprint: key words, instances, hash index entry */
+  group_size_ = group_exprs_.size() * 2 * sizeof(uint64_t) + 64;
+  for (const auto& e : select_exprs_) {
+    group_size_ += sizeof(VM::Instance) + e.program()->dynamic_storage_size_;
+  }
+}
+
+GroupBy::~GroupBy() {
+  spill_writers_.clear();
+  for (const auto& f : spill_files_) {
+    FileUtil::rm(f);
+  }
+}
 
 bool GroupBy::onInputRow(
       const TaskID& input_id,
       const SValue* row,
       int row_len) {
-  Vector<SValue> gkey(group_exprs_.size(), SValue{});
-  for (size_t i = 0; i < group_exprs_.size(); ++i) {
-    VM::evaluate(txn_, group_exprs_[i].program(), row_len, row, &gkey[i]);
+  if (shared_exprs_.size() > 0) {
+    shared_exprs_.setInput(row, row_len);
+    shared_exprs_.evaluate(txn_, shared_exprs_.size());
+    row = shared_exprs_.row();
+    row_len = shared_exprs_.rowSize();
   }
 
-  auto group_key = SValue::makeUniqueKey(gkey.data(), gkey.size());
-  auto& group = groups_[group_key];
-  if (group.size() == 0) {
-    for (const auto& e : select_exprs_) {
-      group.emplace_back(VM::allocInstance(txn_, e.program(), &scratch_));
-    }
+  for (size_t i = 0; i < group_exprs_.size(); ++i) {
+    VM::evaluate(
+        txn_,
+        group_exprs_[i].program(),
+        row_len,
+        row,
+        &group_key_[i]);
   }
 
+  auto group = findOrInsertGroup(group_key_.data());
   for (size_t i = 0; i < select_exprs_.size(); ++i) {
     VM::accumulate(txn_, select_exprs_[i].program(), &group[i], row_len, row);
   }
 
+  if (!spill_dir_.isEmpty() && memory_used_ > memory_budget_) {
+    spillGroups();
+  }
+
   return true;
 }
 
-void GroupBy::onInputsReady() {
-  try {
-    Vector<SValue> out_row(select_exprs_.size(), SValue{});
-    for (auto& group : groups_) {
-      for (size_t i = 0; i < select_exprs_.size(); ++i) {
-        VM::result(txn_, select_exprs_[i].program(), &group.second[i], &out_row[i]);
-      }
+VM::Instance* GroupBy::findOrInsertGroup(const SValue* key) {
+  bool inserted;
+  auto group = groups_.findOrInsert(key, &inserted);
+  if (inserted) {
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      group[i] = VM::allocInstance(
+          txn_,
+          select_exprs_[i].program(),
+          scratch_.get());
+    }
 
-      if (!output_(out_row.data(), out_row.size())) {
-        break;
+    memory_used_ += group_size_;
+    for (size_t i = 0; i < group_exprs_.size(); ++i) {
+      if (key[i].getType() == SQL_STRING) {
+        memory_used_ += key[i].getStringSize();
       }
     }
+  }
+
+  return group;
+}
+
+void GroupBy::onInputsReady() {
+  try {
+    if (spill_files_.empty()) {
+      emitGroups();
+    } else {
+      spillGroups();
+      mergeSpilledPartitions();
+    }
   } catch (...) {
     freeResult();
     throw;
@@ -67,14 +120,150 @@ void GroupBy::onInputsReady() {
   freeResult();
 }
 
+bool GroupBy::emitGroups() {
+  Vector<SValue> out_row(select_exprs_.size(), SValue{});
+  size_t num_columns = select_exprs_.size() - (has_having_ ? 1 : 0);
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    auto group = groups_.getGroup(g);
+
+    /* check the having predicate before computing the other results */
+    if (has_having_) {
+      VM::result(
+          txn_,
+          select_exprs_[num_columns].program(),
+          &group[num_columns],
+          &out_row[num_columns]);
+
+      if (!out_row[num_columns].getBool()) {
+        continue;
+      }
+    }
+
+    for (size_t i = 0; i < num_columns; ++i) {
+      VM::result(txn_, select_exprs_[i].program(), &group[i], &out_row[i]);
+    }
+
+    if (!output_(out_row.data(), num_columns)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void GroupBy::freeResult() {
-  for (auto& group : groups_) {
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    auto group = groups_.getGroup(g);
     for (size_t i = 0; i < select_exprs_.size(); ++i) {
-      VM::freeInstance(txn_, select_exprs_[i].program(), &group.second[i]);
+      VM::freeInstance(txn_, select_exprs_[i].program(), &group[i]);
     }
   }
 
   groups_.clear();
+  scratch_.reset(new ScratchMemory());
+  memory_used_ = 0;
+}
+
+void GroupBy::spillGroups() {
+  if (spill_files_.empty()) {
+    for (size_t p = 0; p < kNumSpillPartitions; ++p) {
+      auto filename = FileUtil::joinPaths(
+          spill_dir_.get(),
+          StringUtil::format("groupby_$0.tmp", Random::singleton()->hex128()));
+
+      spill_writers_.emplace_back(FileOutputStream::openFile(filename));
+      spill_files_.emplace_back(filename);
+      spill_counts_.emplace_back(0);
+    }
+  }
+
+  Vector<String> buffers(kNumSpillPartitions);
+  Vector<SValue> key(group_exprs_.size(), SValue{});
+  String key_str;
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    groups_.getKey(g, key.data());
+
+    key_str.clear();
+    auto key_os = StringOutputStream::fromString(&key_str);
+    for (const auto& v : key) {
+      v.encode(key_os.get());
+    }
+
+    auto partition = std::hash<String>()(key_str) % kNumSpillPartitions;
+    auto& buf = buffers[partition];
+    buf.append(key_str);
+
+    String state;
+    auto state_os = StringOutputStream::fromString(&state);
+    auto group = groups_.getGroup(g);
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::saveState(
+          txn_,
+          select_exprs_[i].program(),
+          &group[i],
+          state_os.get());
+    }
+
+    auto os = StringOutputStream::fromString(&buf);
+    os->appendLenencString(state);
+    ++spill_counts_[partition];
+  }
+
+  for (size_t p = 0; p < kNumSpillPartitions; ++p) {
+    if (buffers[p].empty()) {
+      continue;
+    }
+
+    spill_writers_[p]->write(buffers[p].data(), buffers[p].size());
+  }
+
+  freeResult();
+}
+
+bool GroupBy::mergeSpilledPartitions() {
+  spill_writers_.clear();
+
+  ScratchMemory tmp_scratch;
+  Vector<VM::Instance> tmp;
+  for (const auto& e : select_exprs_) {
+    tmp.emplace_back(VM::allocInstance(txn_, e.program(), &tmp_scratch));
+  }
+
+  bool cont = true;
+  try {
+    Vector<SValue> key(group_exprs_.size(), SValue{});
+    for (size_t p = 0; cont && p < spill_files_.size(); ++p) {
+      auto is = FileInputStream::openFile(spill_files_[p]);
+      for (size_t n = 0; n < spill_counts_[p]; ++n) {
+        for (auto& v : key) {
+          v.decode(is.get());
+        }
+
+        auto group = findOrInsertGroup(key.data());
+        auto state = is->readLenencString();
+        StringInputStream state_is(state);
+        for (size_t i = 0; i < select_exprs_.size(); ++i) {
+          VM::loadState(txn_, select_exprs_[i].program(), &tmp[i], &state_is);
+          VM::merge(txn_, select_exprs_[i].program(), &group[i], &tmp[i]);
+        }
+      }
+
+      cont = emitGroups();
+      freeResult();
+    }
+  } catch (...) {
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::freeInstance(txn_, select_exprs_[i].program(), &tmp[i]);
+    }
+
+    throw;
+  }
+
+  for (size_t i = 0; i < select_exprs_.size(); ++i) {
+    VM::freeInstance(txn_, select_exprs_[i].program(), &tmp[i]);
+  }
+
+  return cont;
 }
 
 //Option<SHA1Hash> GroupBy::cacheKey() const {
@@ -91,34 +280,308 @@ void GroupBy::freeResult() {
 //              qtree_fingerprint_.toString())));
 //}
 
+/* hashes a group key by its typed value so that equal keys from different
+   tasks end up in the same partition */
+static uint64_t hashGroupKey(const SValue* key, size_t key_len) {
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash] (const void* data, size_t size) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+  };
+
+  for (size_t i = 0; i < key_len; ++i) {
+    auto type = key[i].getType();
+    add(&type, sizeof(type));
+
+    switch (type) {
+      case SQL_NULL:
+        break;
+      case SQL_INTEGER: {
+        int64_t v = key[i].getInteger();
+        add(&v, sizeof(v));
+        break;
+      }
+      case SQL_TIMESTAMP: {
+        uint64_t v = key[i].getTimestamp().unixMicros();
+        add(&v, sizeof(v));
+        break;
+      }
+      case SQL_BOOL: {
+        uint8_t v = key[i].getBool() ? 1 : 0;
+        add(&v, sizeof(v));
+        break;
+      }
+      case SQL_FLOAT: {
+        double v = key[i].getFloat();
+        add(&v, sizeof(v));
+        break;
+      }
+      case SQL_STRING:
+        add(key[i].getStringData(), key[i].getStringSize());
+        break;
+    }
+  }
+
+  return hash;
+}
+
+PartialGroupBy::PartialGroupBy(
+    Transaction* txn,
+    Vector<ValueExpression> select_expressions,
+    Vector<ValueExpression> group_expressions,
+    SharedExpressions shared_expressions,
+    size_t num_partitions,
+    RowSinkFn output) :
+    GroupBy(
+        txn,
+        std::move(select_expressions),
+        std::move(group_expressions),
+        std::move(shared_expressions),
+        false,
+        output),
+    num_partitions_(num_partitions) {}
+
+bool PartialGroupBy::emitGroups() {
+  /* with more than one partition, the first column is the partition */
+  size_t key_offset = num_partitions_ > 1 ? 1 : 0;
+  Vector<SValue> out_row(key_offset + group_exprs_.size() + 1, SValue{});
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    auto key = out_row.data() + key_offset;
+    groups_.getKey(g, key);
+    if (num_partitions_ > 1) {
+      out_row[0] = SValue(SValue::IntegerType(
+          hashGroupKey(key, group_exprs_.size()) % num_partitions_));
+    }
+
+    auto group = groups_.getGroup(g);
+    String state;
+    auto os = StringOutputStream::fromString(&state);
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::saveState(txn_, select_exprs_[i].program(), &group[i], os.get());
+    }
+
+    out_row[key_offset + group_exprs_.size()] = SValue(state);
+    if (!output_(out_row.data(), out_row.size())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+GroupByMerge::GroupByMerge(
+    Transaction* txn,
+    Vector<ValueExpression> select_expressions,
+    size_t num_group_expressions,
+    bool has_having,
+    RowSinkFn output) :
+    txn_(txn),
+    select_exprs_(std::move(select_expressions)),
+    num_group_exprs_(num_group_expressions),
+    has_having_(has_having),
+    output_(output),
+    groups_(num_group_exprs_, select_exprs_.size()) {
+  for (const auto& e : select_exprs_) {
+    tmp_.emplace_back(VM::allocInstance(txn_, e.program(), &scratch_));
+  }
+}
+
+GroupByMerge::~GroupByMerge() {
+  freeResult();
+
+  for (size_t i = 0; i < select_exprs_.size(); ++i) {
+    VM::freeInstance(txn_, select_exprs_[i].program(), &tmp_[i]);
+  }
+}
+
+bool GroupByMerge::onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) {
+  if (size_t(row_len) != num_group_exprs_ + 1) {
+    RAISE(kRuntimeError, "invalid partial group by row");
+  }
+
+  bool inserted;
+  auto group = groups_.findOrInsert(row, &inserted);
+  if (inserted) {
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      group[i] = VM::allocInstance(
+          txn_,
+          select_exprs_[i].program(),
+          &scratch_);
+    }
+  }
+
+  auto state = row[num_group_exprs_].getString();
+  StringInputStream is(state);
+  for (size_t i = 0; i < select_exprs_.size(); ++i) {
+    VM::loadState(txn_, select_exprs_[i].program(), &tmp_[i], &is);
+    VM::merge(txn_, select_exprs_[i].program(), &group[i], &tmp_[i]);
+  }
+
+  return true;
+}
+
+void GroupByMerge::onInputsReady() {
+  try {
+    Vector<SValue> out_row(select_exprs_.size(), SValue{});
+    size_t num_columns = select_exprs_.size() - (has_having_ ? 1 : 0);
+    for (size_t g = 0; g < groups_.size(); ++g) {
+      auto group = groups_.getGroup(g);
+
+      if (has_having_) {
+        VM::result(
+            txn_,
+            select_exprs_[num_columns].program(),
+            &group[num_columns],
+            &out_row[num_columns]);
+
+        if (!out_row[num_columns].getBool()) {
+          continue;
+        }
+      }
+
+      for (size_t i = 0; i < num_columns; ++i) {
+        VM::result(txn_, select_exprs_[i].program(), &group[i], &out_row[i]);
+      }
+
+      if (!output_(out_row.data(), num_columns)) {
+        break;
+      }
+    }
+  } catch (...) {
+    freeResult();
+    throw;
+  }
+
+  freeResult();
+}
+
+void GroupByMerge::freeResult() {
+  for (size_t g = 0; g < groups_.size(); ++g) {
+    auto group = groups_.getGroup(g);
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::freeInstance(txn_, select_exprs_[i].program(), &group[i]);
+    }
+  }
+
+  groups_.clear();
+}
+
 GroupByFactory::GroupByFactory(
     Vector<RefPtr<SelectListNode>> select_exprs,
-    Vector<RefPtr<ValueExpressionNode>> group_exprs) :
+    Vector<RefPtr<ValueExpressionNode>> group_exprs,
+    Option<RefPtr<ValueExpressionNode>> having_expr) :
     select_exprs_(select_exprs),
-    group_exprs_(group_exprs) {}
+    group_exprs_(group_exprs),
+    having_expr_(having_expr) {}
 
 RefPtr<Task> GroupByFactory::build(
     Transaction* txn,
     RowSinkFn output) const {
   Vector<ValueExpression> select_expressions;
   Vector<ValueExpression> group_expressions;
+  SharedExpressions shared_expressions;
+  compileExpressions(
+      txn,
+      &select_expressions,
+      &group_expressions,
+      &shared_expressions);
 
+  return new GroupBy(
+      txn,
+      std::move(select_expressions),
+      std::move(group_expressions),
+      std::move(shared_expressions),
+      !having_expr_.isEmpty(),
+      output);
+}
+
+void GroupByFactory::compileExpressions(
+    Transaction* txn,
+    Vector<ValueExpression>* select_expressions,
+    Vector<ValueExpression>* group_expressions,
+    SharedExpressions* shared_expressions) const {
+  Vector<RefPtr<ValueExpressionNode>> exprs;
   for (const auto& slnode : select_exprs_) {
-    select_expressions.emplace_back(
-        txn->getRuntime()->queryBuilder()->buildValueExpression(
-            txn,
-            slnode->expression()));
+    exprs.emplace_back(slnode->expression());
+  }
+
+  if (!having_expr_.isEmpty()) {
+    exprs.emplace_back(having_expr_.get());
   }
 
+  auto num_select_exprs = exprs.size();
   for (const auto& e : group_exprs_) {
-    group_expressions.emplace_back(
-        txn->getRuntime()->queryBuilder()->buildValueExpression(txn, e));
+    exprs.emplace_back(e);
   }
 
-  return new GroupBy(
+  if (shared_expressions) {
+    Vector<size_t> num_required;
+    *shared_expressions = SharedExpressions::build(txn, &exprs, &num_required);
+  }
+
+  auto qbuilder = txn->getRuntime()->queryBuilder();
+  for (size_t i = 0; i < exprs.size(); ++i) {
+    auto expr = qbuilder->buildValueExpression(txn, exprs[i]);
+    if (i < num_select_exprs) {
+      select_expressions->emplace_back(std::move(expr));
+    } else {
+      group_expressions->emplace_back(std::move(expr));
+    }
+  }
+}
+
+PartialGroupByFactory::PartialGroupByFactory(
+    Vector<RefPtr<SelectListNode>> select_exprs,
+    Vector<RefPtr<ValueExpressionNode>> group_exprs,
+    Option<RefPtr<ValueExpressionNode>> having_expr,
+    size_t num_partitions /* = 1 */) :
+    GroupByFactory(select_exprs, group_exprs, having_expr),
+    num_partitions_(num_partitions) {}
+
+RefPtr<Task> PartialGroupByFactory::build(
+    Transaction* txn,
+    RowSinkFn output) const {
+  Vector<ValueExpression> select_expressions;
+  Vector<ValueExpression> group_expressions;
+  SharedExpressions shared_expressions;
+  compileExpressions(
+      txn,
+      &select_expressions,
+      &group_expressions,
+      &shared_expressions);
+
+  return new PartialGroupBy(
       txn,
       std::move(select_expressions),
       std::move(group_expressions),
+      std::move(shared_expressions),
+      num_partitions_,
+      output);
+}
+
+GroupByMergeFactory::GroupByMergeFactory(
+    Vector<RefPtr<SelectListNode>> select_exprs,
+    Vector<RefPtr<ValueExpressionNode>> group_exprs,
+    Option<RefPtr<ValueExpressionNode>> having_expr) :
+    GroupByFactory(select_exprs, group_exprs, having_expr) {}
+
+RefPtr<Task> GroupByMergeFactory::build(
+    Transaction* txn,
+    RowSinkFn output) const {
+  Vector<ValueExpression> select_expressions;
+  Vector<ValueExpression> group_expressions;
+  compileExpressions(txn, &select_expressions, &group_expressions, nullptr);
+
+  return new GroupByMerge(
+      txn,
+      std::move(select_expressions),
+      group_expressions.size(),
+      !having_expr_.isEmpty(),
       output);
 }
 
@@ -10,11 +10,19 @@
 #pragma once
 #include <stx/stdtypes.h>
 #include <stx/SHA1.h>
+#include <stx/io/outputstream.h>
 #include <csql/tasks/Task.h>
 #include <csql/runtime/defaultruntime.h>
+#include <csql/runtime/GroupHashMap.h>
+#include <csql/runtime/SharedExpressions.h>
 
 namespace csql {
 
+/**
+ * If has_having is true, the last select expression is the HAVING predicate.
+ * Groups for which it isn't true are not emitted and the predicate is not
+ * part of the output rows.
+ */
 class GroupBy : public Task {
 public:
 
@@ -22,8 +30,12 @@ public:
       Transaction* txn,
       Vector<ValueExpression> select_expressions,
       Vector<ValueExpression> group_expressions,
+      SharedExpressions shared_expressions,
+      bool has_having,
       RowSinkFn output);
 
+  ~GroupBy();
+
   bool onInputRow(
       const TaskID& input_id,
       const SValue* row,
@@ -33,14 +45,107 @@ public:
 
 protected:
 
+  static const size_t kNumSpillPartitions = 16;
+
+  /**
+   * Emits the output rows for all groups that are currently in memory.
+   * Returns false if the output doesn't accept any more rows
+   */
+  virtual bool emitGroups();
+
+  VM::Instance* findOrInsertGroup(const SValue* key);
   void freeResult();
 
+  /**
+   * Once the groups in memory exceed the memory budget, they are hash
+   * partitioned by key and their aggregate states are appended to one spill
+   * file per partition (see VM::saveState). When the input is complete, the
+   * partitions are reloaded and merged one at a time
+   */
+  void spillGroups();
+  bool mergeSpilledPartitions();
+
   Transaction* txn_;
   Vector<ValueExpression> select_exprs_;
   Vector<ValueExpression> group_exprs_;
+  SharedExpressions shared_exprs_;
+  bool has_having_;
+  RowSinkFn output_;
+  GroupHashMap groups_;
+  Vector<SValue> group_key_;
+  ScopedPtr<ScratchMemory> scratch_;
+  size_t group_size_;
+  size_t memory_used_;
+  size_t memory_budget_;
+  Option<String> spill_dir_;
+  Vector<String> spill_files_;
+  Vector<ScopedPtr<OutputStream>> spill_writers_;
+  Vector<size_t> spill_counts_;
+};
+
+/**
+ * Computes a partial aggregation over its input. For every group, one row is
+ * emitted that contains the group key values followed by the serialized
+ * aggregate states of all select expressions (see VM::saveState)
+ *
+ * If num_partitions is greater than one, the output is partitioned by the
+ * hash of the group key: each row starts with its partition number (see
+ * TaskDAGNode::Dependency::partition), so that every group is sent to exactly
+ * one of num_partitions GroupByMerge tasks
+ */
+class PartialGroupBy : public GroupBy {
+public:
+
+  PartialGroupBy(
+      Transaction* txn,
+      Vector<ValueExpression> select_expressions,
+      Vector<ValueExpression> group_expressions,
+      SharedExpressions shared_expressions,
+      size_t num_partitions,
+      RowSinkFn output);
+
+protected:
+
+  bool emitGroups() override;
+
+  size_t num_partitions_;
+};
+
+/**
+ * Merges the partial aggregations produced by one or more PartialGroupBy
+ * tasks and emits the final result rows. has_having works like in GroupBy
+ */
+class GroupByMerge : public Task {
+public:
+
+  GroupByMerge(
+      Transaction* txn,
+      Vector<ValueExpression> select_expressions,
+      size_t num_group_expressions,
+      bool has_having,
+      RowSinkFn output);
+
+  ~GroupByMerge();
+
+  bool onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) override;
+
+  void onInputsReady() override;
+
+protected:
+
+  void freeResult();
+
+  Transaction* txn_;
+  Vector<ValueExpression> select_exprs_;
+  size_t num_group_exprs_;
+  bool has_having_;
   RowSinkFn output_;
-  HashMap<String, Vector<VM::Instance>> groups_;
+  GroupHashMap groups_;
   ScratchMemory scratch_;
+  Vector<VM::Instance> tmp_;
 };
 
 class GroupByFactory : public TaskFactory {
@@ -48,15 +153,60 @@ public:
 
   GroupByFactory(
       Vector<RefPtr<SelectListNode>> select_exprs,
-      Vector<RefPtr<ValueExpressionNode>> group_exprs);
+      Vector<RefPtr<ValueExpressionNode>> group_exprs,
+      Option<RefPtr<ValueExpressionNode>> having_expr);
 
   RefPtr<Task> build(
       Transaction* txn,
       RowSinkFn output) const override;
 
 protected:
+
+  /**
+   * If shared_expressions is non-null, subexpressions that occur in more than
+   * one select or group expression are extracted into shared_expressions. The
+   * HAVING expression, if any, is compiled as the last select expression
+   */
+  void compileExpressions(
+      Transaction* txn,
+      Vector<ValueExpression>* select_expressions,
+      Vector<ValueExpression>* group_expressions,
+      SharedExpressions* shared_expressions) const;
+
   Vector<RefPtr<SelectListNode>> select_exprs_;
   Vector<RefPtr<ValueExpressionNode>> group_exprs_;
+  Option<RefPtr<ValueExpressionNode>> having_expr_;
+};
+
+class PartialGroupByFactory : public GroupByFactory {
+public:
+
+  PartialGroupByFactory(
+      Vector<RefPtr<SelectListNode>> select_exprs,
+      Vector<RefPtr<ValueExpressionNode>> group_exprs,
+      Option<RefPtr<ValueExpressionNode>> having_expr,
+      size_t num_partitions = 1);
+
+  RefPtr<Task> build(
+      Transaction* txn,
+      RowSinkFn output) const override;
+
+protected:
+  size_t num_partitions_;
+};
+
+class GroupByMergeFactory : public GroupByFactory {
+public:
+
+  GroupByMergeFactory(
+      Vector<RefPtr<SelectListNode>> select_exprs,
+      Vector<RefPtr<ValueExpressionNode>> group_exprs,
+      Option<RefPtr<ValueExpressionNode>> having_expr);
+
+  RefPtr<Task> build(
+      Transaction* txn,
+      RowSinkFn output) const override;
+
 };
 
 }
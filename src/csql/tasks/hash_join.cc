@@ -0,0 +1,562 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <csql/tasks/hash_join.h>
+#include <csql/runtime/runtime.h>
+#include <stx/random.h>
+#include <stx/io/fileutil.h>
+#include <stx/io/inputstream.h>
+
+namespace csql {
+
+HashJoin::HashJoin(
+    Transaction* txn,
+    JoinType join_type,
+    const Set<TaskID>& base_tbl_ids,
+    const Set<TaskID>& joined_tbl_ids,
+    const Vector<JoinNode::InputColumnRef>& input_map,
+    Vector<ValueExpression> select_expressions,
+    Vector<ValueExpression> base_key_exprs,
+    Vector<ValueExpression> joined_key_exprs,
+    Option<ValueExpression> join_cond_expr,
+    Option<ValueExpression> where_expr,
+    RowSinkFn output) :
+    txn_(txn),
+    join_type_(join_type),
+    input_map_(input_map),
+    select_exprs_(std::move(select_expressions)),
+    join_cond_expr_(std::move(join_cond_expr)),
+    where_expr_(std::move(where_expr)),
+    output_(output),
+    memory_budget_(txn->getRuntime()->memoryBudget()),
+    spill_dir_(txn->getRuntime()->cacheDir()),
+    probing_(false),
+    done_(false),
+    build_idx_(0),
+    inbuf_(input_map_.size(), SValue{}),
+    outbuf_(select_exprs_.size(), SValue{}) {
+  if (base_key_exprs.size() != joined_key_exprs.size()) {
+    RAISE(kIllegalArgumentError, "join key size mismatch");
+  }
+
+  inputs_[0].task_ids = base_tbl_ids;
+  inputs_[0].key_exprs = std::move(base_key_exprs);
+  inputs_[1].task_ids = joined_tbl_ids;
+  inputs_[1].key_exprs = std::move(joined_key_exprs);
+
+  for (auto& input : inputs_) {
+    input.num_pending = input.task_ids.size();
+    input.memory_used = 0;
+    input.num_spilled = 0;
+  }
+}
+
+HashJoin::~HashJoin() {
+  for (auto& input : inputs_) {
+    input.spill_writer.reset(nullptr);
+    if (!input.spill_file.isEmpty()) {
+      FileUtil::rm(input.spill_file.get());
+    }
+  }
+}
+
+size_t HashJoin::getTableIndex(const TaskID& input_id) const {
+  for (size_t i = 0; i < 2; ++i) {
+    if (inputs_[i].task_ids.count(input_id) > 0) {
+      return i;
+    }
+  }
+
+  RAISE(kIllegalStateError, "invalid input task");
+}
+
+static size_t estimateMemoryUsage(const SValue* values, size_t num_values) {
+  size_t size = sizeof(Vector<SValue>);
+  for (size_t i = 0; i < num_values; ++i) {
+    size += sizeof(SValue);
+    if (values[i].getType() == SQL_STRING) {
+      size += values[i].getStringSize();
+    }
+  }
+
+  return size;
+}
+
+bool HashJoin::onInputRow(
+    const TaskID& input_id,
+    const SValue* row,
+    int row_len) {
+  if (done_) {
+    return false;
+  }
+
+  auto table_idx = getTableIndex(input_id);
+  if (!probing_) {
+    bufferRow(table_idx, row, row_len);
+    return true;
+  }
+
+  if (table_idx == build_idx_) {
+    RAISE(kIllegalStateError, "received row for complete input");
+  }
+
+  if (!probeRow(row)) {
+    done_ = true;
+  }
+
+  return !done_;
+}
+
+void HashJoin::bufferRow(size_t table_idx, const SValue* row, int row_len) {
+  auto& input = inputs_[table_idx];
+  input.rows.emplace_back(row, row + row_len);
+  input.memory_used += estimateMemoryUsage(row, row_len);
+
+  auto& other = inputs_[1 - table_idx];
+  if (spill_dir_.isEmpty()) {
+    if (input.rows.size() + other.rows.size() > kMaxBufferedRows) {
+      RAISE(
+          kRuntimeError,
+          "Hash JOIN intermediate result set is too large, try joining on a"
+          " smaller table.");
+    }
+
+    return;
+  }
+
+  if (input.memory_used + other.memory_used > memory_budget_) {
+    spillRows(
+        input.memory_used >= other.memory_used ? table_idx : 1 - table_idx);
+  }
+}
+
+static const size_t kSpillWriteBufferSize = 1024 * 1024;
+
+void HashJoin::spillRows(size_t table_idx) {
+  auto& input = inputs_[table_idx];
+  if (input.spill_writer.get() == nullptr) {
+    input.spill_file = Some(FileUtil::joinPaths(
+        spill_dir_.get(),
+        StringUtil::format("hashjoin_$0.tmp", Random::singleton()->hex128())));
+
+    input.spill_writer = FileOutputStream::openFile(input.spill_file.get());
+  }
+
+  String buf;
+  auto os = StringOutputStream::fromString(&buf);
+  for (const auto& row : input.rows) {
+    os->appendVarUInt(row.size());
+    for (const auto& v : row) {
+      v.encode(os.get());
+    }
+
+    if (buf.size() > kSpillWriteBufferSize) {
+      input.spill_writer->write(buf.data(), buf.size());
+      buf.clear();
+    }
+  }
+
+  if (buf.size() > 0) {
+    input.spill_writer->write(buf.data(), buf.size());
+  }
+
+  input.num_spilled += input.rows.size();
+  input.rows.clear();
+  input.memory_used = 0;
+}
+
+void HashJoin::readSpilledRows(
+    size_t table_idx,
+    Function<bool (const Vector<SValue>& row)> fn) {
+  auto& input = inputs_[table_idx];
+  if (input.num_spilled == 0) {
+    return;
+  }
+
+  input.spill_writer.reset(nullptr);
+  auto is = FileInputStream::openFile(input.spill_file.get());
+
+  Vector<SValue> row;
+  for (size_t n = 0; n < input.num_spilled; ++n) {
+    row.resize(is->readVarUInt());
+    for (auto& v : row) {
+      v.decode(is.get());
+    }
+
+    if (!fn(row)) {
+      break;
+    }
+  }
+
+  is.reset(nullptr);
+  FileUtil::rm(input.spill_file.get());
+  input.spill_file = None<String>();
+  input.num_spilled = 0;
+}
+
+void HashJoin::onInputComplete(const TaskID& input_id) {
+  auto table_idx = getTableIndex(input_id);
+  auto& input = inputs_[table_idx];
+  if (input.num_pending == 0) {
+    RAISE(kIllegalStateError, "input completed twice");
+  }
+
+  --input.num_pending;
+  if (probing_ || done_ || input.num_pending > 0) {
+    return;
+  }
+
+  /* hash the first complete input unless it's the one that didn't fit into
+     memory; onInputsReady picks the smaller input in that case */
+  if (inputs_[1 - table_idx].num_pending > 0 && input.num_spilled == 0) {
+    startProbing(table_idx);
+  }
+}
+
+void HashJoin::onInputsReady() {
+  if (!probing_ && !done_) {
+    auto num_rows = [this] (size_t idx) -> size_t {
+      return inputs_[idx].rows.size() + inputs_[idx].num_spilled;
+    };
+
+    startProbing(num_rows(0) < num_rows(1) ? 0 : 1);
+  }
+
+  if (!done_ && join_type_ == JoinType::OUTER && build_idx_ == 0) {
+    const auto& build_rows = inputs_[0].rows;
+    for (size_t i = 0; i < build_rows.size(); ++i) {
+      if (matched_[i]) {
+        continue;
+      }
+
+      if (!emitUnmatchedRow(0, build_rows[i].data())) {
+        break;
+      }
+    }
+  }
+
+  done_ = true;
+  for (auto& input : inputs_) {
+    input.rows.clear();
+  }
+
+  hash_table_.clear();
+  unhashed_rows_.clear();
+  all_rows_.clear();
+  matched_.clear();
+}
+
+void HashJoin::startProbing(size_t build_idx) {
+  build_idx_ = build_idx;
+  probing_ = true;
+
+  auto& build = inputs_[build_idx_];
+  readSpilledRows(build_idx_, [&build] (const Vector<SValue>& row) -> bool {
+    build.rows.emplace_back(row);
+    return true;
+  });
+
+  buildHashTable();
+
+  auto& probe = inputs_[1 - build_idx_];
+  for (const auto& row : probe.rows) {
+    if (!probeRow(row.data())) {
+      done_ = true;
+      break;
+    }
+  }
+
+  probe.rows.clear();
+  probe.memory_used = 0;
+
+  if (!done_) {
+    auto probe_fn = [this] (const Vector<SValue>& row) -> bool {
+      if (!probeRow(row.data())) {
+        done_ = true;
+      }
+
+      return !done_;
+    };
+
+    readSpilledRows(1 - build_idx_, probe_fn);
+  }
+}
+
+void HashJoin::buildHashTable() {
+  const auto& build = inputs_[build_idx_];
+  for (size_t i = 0; i < build.rows.size(); ++i) {
+    const auto& row = build.rows[i];
+    if (computeKey(build_idx_, row.data(), build.key_exprs, &key_)) {
+      hash_table_[key_].emplace_back(i);
+    } else {
+      unhashed_rows_.emplace_back(i);
+    }
+  }
+
+  if (join_type_ == JoinType::OUTER && build_idx_ == 0) {
+    matched_.resize(build.rows.size(), false);
+  }
+}
+
+bool HashJoin::computeKey(
+    size_t table_idx,
+    const SValue* row,
+    const Vector<ValueExpression>& key_exprs,
+    String* key) {
+  for (size_t i = 0; i < input_map_.size(); ++i) {
+    const auto& m = input_map_[i];
+
+    if (m.table_idx == table_idx) {
+      inbuf_[i] = row[m.column_idx];
+    } else {
+      inbuf_[i] = SValue();
+    }
+  }
+
+  key->clear();
+  for (const auto& e : key_exprs) {
+    SValue val;
+    VM::evaluate(txn_, e.program(), inbuf_.size(), inbuf_.data(), &val);
+
+    switch (val.getType()) {
+
+      case SQL_NULL:
+        *key += 'Z';
+        break;
+
+      case SQL_INTEGER:
+      case SQL_FLOAT:
+      case SQL_STRING: {
+        if (val.isNumeric() || val.isConvertibleToNumeric()) {
+          auto fval = val.getFloat();
+          if (fval == 0) {
+            fval = 0; // -0.0 == 0.0
+          }
+
+          *key += 'F';
+          key->append((const char*) &fval, sizeof(fval));
+        } else {
+          uint32_t slen = val.getStringSize();
+          *key += 'S';
+          key->append((const char*) &slen, sizeof(slen));
+          key->append(val.getStringData(), slen);
+        }
+        break;
+      }
+
+      default:
+        return false;
+
+    }
+  }
+
+  return true;
+}
+
+bool HashJoin::probeRow(const SValue* row) {
+  auto probe_idx = 1 - build_idx_;
+  bool match = false;
+
+  if (computeKey(probe_idx, row, inputs_[probe_idx].key_exprs, &key_)) {
+    auto bucket = hash_table_.find(key_);
+    if (bucket != hash_table_.end() &&
+        !joinRows(row, bucket->second, &match)) {
+      return false;
+    }
+
+    if (!joinRows(row, unhashed_rows_, &match)) {
+      return false;
+    }
+  } else {
+    const auto& build_rows = inputs_[build_idx_].rows;
+    for (size_t i = all_rows_.size(); i < build_rows.size(); ++i) {
+      all_rows_.emplace_back(i);
+    }
+
+    if (!joinRows(row, all_rows_, &match)) {
+      return false;
+    }
+  }
+
+  if (match || join_type_ != JoinType::OUTER || probe_idx != 0) {
+    return true;
+  }
+
+  return emitUnmatchedRow(0, row);
+}
+
+bool HashJoin::joinRows(
+    const SValue* probe_row,
+    const Vector<size_t>& candidates,
+    bool* match) {
+  auto probe_idx = 1 - build_idx_;
+  const auto& build_rows = inputs_[build_idx_].rows;
+
+  for (auto idx : candidates) {
+    const auto& build_row = build_rows[idx];
+
+    for (size_t i = 0; i < input_map_.size(); ++i) {
+      const auto& m = input_map_[i];
+
+      if (m.table_idx == probe_idx) {
+        inbuf_[i] = probe_row[m.column_idx];
+      } else if (m.table_idx == build_idx_) {
+        inbuf_[i] = build_row[m.column_idx];
+      } else {
+        RAISE(kRuntimeError, "invalid table index");
+      }
+    }
+
+    if (!join_cond_expr_.isEmpty()) {
+      SValue pred;
+      VM::evaluate(
+          txn_,
+          join_cond_expr_.get().program(),
+          inbuf_.size(),
+          inbuf_.data(),
+          &pred);
+
+      if (!pred.getBool()) {
+        continue;
+      }
+    }
+
+    if (!where_expr_.isEmpty()) {
+      SValue pred;
+      VM::evaluate(
+          txn_,
+          where_expr_.get().program(),
+          inbuf_.size(),
+          inbuf_.data(),
+          &pred);
+
+      if (!pred.getBool()) {
+        continue;
+      }
+    }
+
+    *match = true;
+    if (!matched_.empty()) {
+      matched_[idx] = true;
+    }
+
+    if (!emitRow()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool HashJoin::emitUnmatchedRow(size_t table_idx, const SValue* row) {
+  for (size_t i = 0; i < input_map_.size(); ++i) {
+    const auto& m = input_map_[i];
+
+    if (m.table_idx == table_idx) {
+      inbuf_[i] = row[m.column_idx];
+    } else {
+      inbuf_[i] = SValue();
+    }
+  }
+
+  if (!where_expr_.isEmpty()) {
+    SValue pred;
+    VM::evaluate(
+        txn_,
+        where_expr_.get().program(),
+        inbuf_.size(),
+        inbuf_.data(),
+        &pred);
+
+    if (!pred.getBool()) {
+      return true;
+    }
+  }
+
+  return emitRow();
+}
+
+bool HashJoin::emitRow() {
+  for (size_t i = 0; i < select_exprs_.size(); ++i) {
+    VM::evaluate(
+        txn_,
+        select_exprs_[i].program(),
+        inbuf_.size(),
+        inbuf_.data(),
+        &outbuf_[i]);
+  }
+
+  return output_(outbuf_.data(), outbuf_.size());
+}
+
+HashJoinFactory::HashJoinFactory(
+    JoinType join_type,
+    const Set<TaskID>& base_tbl_ids,
+    const Set<TaskID>& joined_tbl_ids,
+    const Vector<JoinNode::InputColumnRef>& input_map,
+    Vector<RefPtr<SelectListNode>> select_exprs,
+    Vector<JoinNode::EquiJoinKey> join_keys,
+    Option<RefPtr<ValueExpressionNode>> join_cond_expr,
+    Option<RefPtr<ValueExpressionNode>> where_expr) :
+    join_type_(join_type),
+    base_tbl_ids_(base_tbl_ids),
+    joined_tbl_ids_(joined_tbl_ids),
+    input_map_(input_map),
+    select_exprs_(select_exprs),
+    join_keys_(join_keys),
+    join_cond_expr_(join_cond_expr),
+    where_expr_(where_expr) {}
+
+RefPtr<Task> HashJoinFactory::build(
+    Transaction* txn,
+    RowSinkFn output) const {
+  auto qbuilder = txn->getRuntime()->queryBuilder();
+
+  Vector<ValueExpression> select_expressions;
+  for (const auto& slnode : select_exprs_) {
+    select_expressions.emplace_back(
+        qbuilder->buildValueExpression(txn, slnode->expression()));
+  }
+
+  Vector<ValueExpression> base_key_exprs;
+  Vector<ValueExpression> joined_key_exprs;
+  for (const auto& k : join_keys_) {
+    base_key_exprs.emplace_back(
+        qbuilder->buildValueExpression(txn, k.base_key));
+    joined_key_exprs.emplace_back(
+        qbuilder->buildValueExpression(txn, k.joined_key));
+  }
+
+  Option<ValueExpression> join_cond_expr;
+  if (!join_cond_expr_.isEmpty()) {
+    join_cond_expr = std::move(Option<ValueExpression>(
+        qbuilder->buildValueExpression(txn, join_cond_expr_.get())));
+  }
+
+  Option<ValueExpression> where_expr;
+  if (!where_expr_.isEmpty()) {
+    where_expr = std::move(Option<ValueExpression>(
+        qbuilder->buildValueExpression(txn, where_expr_.get())));
+  }
+
+  return new HashJoin(
+      txn,
+      join_type_,
+      base_tbl_ids_,
+      joined_tbl_ids_,
+      input_map_,
+      std::move(select_expressions),
+      std::move(base_key_exprs),
+      std::move(joined_key_exprs),
+      std::move(join_cond_expr),
+      std::move(where_expr),
+      output);
+}
+
+}
@@ -0,0 +1,171 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <stx/io/outputstream.h>
+#include <csql/tasks/Task.h>
+#include <csql/runtime/defaultruntime.h>
+#include <csql/qtree/JoinNode.h>
+
+namespace csql {
+
+/**
+ * Equi-join: builds a hash table over the key columns of one input and probes
+ * it with the rows of the other input. The full join condition is still
+ * evaluated on every candidate pair, so the key expressions only need to put
+ * equal values into the same bucket.
+ *
+ * The hash table is built over whichever input completes first (see
+ * Task::onInputComplete). From then on, the rows of the other input are
+ * probed as they arrive; only the rows that arrived before are buffered. If
+ * both inputs complete at the same time, the smaller one is hashed. For an
+ * OUTER join with a hashed base table, the base rows that didn't match are
+ * emitted once all inputs are complete.
+ *
+ * Until one input is complete, the rows of both inputs are buffered. Once the
+ * buffered rows exceed the runtime's memory budget, the larger input is
+ * spilled to the cache dir; an input that was spilled is only hashed if the
+ * other input is larger. Without a cache dir, the join fails once more than
+ * kMaxBufferedRows rows are buffered.
+ *
+ * Numeric key values (and strings that look like numbers) are hashed by value
+ * so that e.g. 1 and 1.0 match like they do in eq(). Key values that can't be
+ * hashed consistently with eq() (BOOL and TIMESTAMP) are compared against all
+ * rows of the other side.
+ */
+class HashJoin : public Task {
+public:
+
+  static const size_t kMaxBufferedRows = 1000000;
+
+  HashJoin(
+      Transaction* txn,
+      JoinType join_type,
+      const Set<TaskID>& base_tbl_ids,
+      const Set<TaskID>& joined_tbl_ids,
+      const Vector<JoinNode::InputColumnRef>& input_map,
+      Vector<ValueExpression> select_expressions,
+      Vector<ValueExpression> base_key_exprs,
+      Vector<ValueExpression> joined_key_exprs,
+      Option<ValueExpression> join_cond_expr,
+      Option<ValueExpression> where_expr,
+      RowSinkFn output);
+
+  ~HashJoin();
+
+  bool onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) override;
+
+  void onInputComplete(const TaskID& input_id) override;
+
+  void onInputsReady() override;
+
+protected:
+
+  /**
+   * One side of the join. table_idx 0 is the base table and table_idx 1 is
+   * the joined table
+   */
+  struct Input {
+    Set<TaskID> task_ids;
+    size_t num_pending;
+    Vector<ValueExpression> key_exprs;
+    Vector<Vector<SValue>> rows;
+    size_t memory_used;
+    Option<String> spill_file;
+    ScopedPtr<OutputStream> spill_writer;
+    size_t num_spilled;
+  };
+
+  size_t getTableIndex(const TaskID& input_id) const;
+
+  void bufferRow(size_t table_idx, const SValue* row, int row_len);
+  void spillRows(size_t table_idx);
+  void readSpilledRows(
+      size_t table_idx,
+      Function<bool (const Vector<SValue>& row)> fn);
+
+  /**
+   * Builds the hash table over the provided input and probes it with all
+   * buffered rows of the other input
+   */
+  void startProbing(size_t build_idx);
+
+  void buildHashTable();
+
+  bool computeKey(
+      size_t table_idx,
+      const SValue* row,
+      const Vector<ValueExpression>& key_exprs,
+      String* key);
+
+  bool probeRow(const SValue* row);
+
+  bool joinRows(
+      const SValue* probe_row,
+      const Vector<size_t>& candidates,
+      bool* match);
+
+  bool emitUnmatchedRow(size_t table_idx, const SValue* row);
+  bool emitRow();
+
+  Transaction* txn_;
+  JoinType join_type_;
+  Vector<JoinNode::InputColumnRef> input_map_;
+  Vector<ValueExpression> select_exprs_;
+  Option<ValueExpression> join_cond_expr_;
+  Option<ValueExpression> where_expr_;
+  RowSinkFn output_;
+  Input inputs_[2];
+  size_t memory_budget_;
+  Option<String> spill_dir_;
+  bool probing_;
+  bool done_;
+  size_t build_idx_;
+  HashMap<String, Vector<size_t>> hash_table_;
+  Vector<size_t> unhashed_rows_;
+  Vector<size_t> all_rows_;
+  Vector<bool> matched_;
+  Vector<SValue> inbuf_;
+  Vector<SValue> outbuf_;
+  String key_;
+};
+
+class HashJoinFactory  : public TaskFactory {
+public:
+
+  HashJoinFactory(
+      JoinType join_type,
+      const Set<TaskID>& base_tbl_ids,
+      const Set<TaskID>& joined_tbl_ids,
+      const Vector<JoinNode::InputColumnRef>& input_map,
+      Vector<RefPtr<SelectListNode>> select_exprs,
+      Vector<JoinNode::EquiJoinKey> join_keys,
+      Option<RefPtr<ValueExpressionNode>> join_cond_expr,
+      Option<RefPtr<ValueExpressionNode>> where_expr);
+
+  RefPtr<Task> build(
+      Transaction* txn,
+      RowSinkFn output) const override;
+
+protected:
+  JoinType join_type_;
+  Set<TaskID> base_tbl_ids_;
+  Set<TaskID> joined_tbl_ids_;
+  Vector<JoinNode::InputColumnRef> input_map_;
+  Vector<RefPtr<SelectListNode>> select_exprs_;
+  Vector<JoinNode::EquiJoinKey> join_keys_;
+  Option<RefPtr<ValueExpressionNode>> join_cond_expr_;
+  Option<RefPtr<ValueExpressionNode>> where_expr_;
+};
+
+}
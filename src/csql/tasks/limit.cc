@@ -11,6 +11,18 @@
 
 namespace csql {
 
+RowSinkFn Limit::limitOutput(size_t limit, RowSinkFn output) {
+  auto remaining = std::make_shared<size_t>(limit);
+  return [remaining, output] (const SValue* row, int row_len) -> bool {
+    if (*remaining == 0) {
+      return false;
+    }
+
+    --(*remaining);
+    return output(row, row_len) && *remaining > 0;
+  };
+}
+
 Limit::Limit(
     size_t limit,
     size_t offset,
@@ -24,15 +36,17 @@ bool Limit::onInputRow(
     const TaskID& input_id,
     const SValue* row,
     int row_len) {
-  if (counter_++ < offset_) {
-    return true;
+  if (counter_ >= offset_ + limit_) {
+    return false;
   }
 
-  if (counter_ > (offset_ + limit_)) {
-    return false;
+  if (counter_++ < offset_) {
+    return true;
   }
 
-  return output_(row, row_len);
+  /* stop the producer as soon as the last row was emitted instead of waiting
+     for it to send one more row */
+  return output_(row, row_len) && counter_ < offset_ + limit_;
 }
 
 LimitFactory::LimitFactory(
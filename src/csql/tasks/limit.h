@@ -17,6 +17,12 @@ namespace csql {
 class Limit : public Task {
 public:
 
+  /**
+   * Returns a sink that forwards at most limit rows to output and then tells
+   * the producer to stop. Used by scans that had a LIMIT pushed down into them
+   */
+  static RowSinkFn limitOutput(size_t limit, RowSinkFn output);
+
   Limit(
       size_t limit,
       size_t offset,
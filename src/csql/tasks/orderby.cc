@@ -8,10 +8,14 @@
  * <http://www.gnu.org/licenses/>.
  */
 #include <algorithm>
+#include <string.h>
 #include <csql/tasks/orderby.h>
 #include <csql/expressions/boolean.h>
 #include <csql/runtime/runtime.h>
 #include <stx/inspect.h>
+#include <stx/random.h>
+#include <stx/io/fileutil.h>
+#include <stx/io/outputstream.h>
 
 namespace csql {
 
@@ -23,10 +27,37 @@ OrderBy::OrderBy(
     ctx_(ctx),
     sort_specs_(std::move(sort_specs)),
     num_columns_(num_columns),
-    output_(output) {
+    output_(output),
+    memory_used_(0),
+    memory_budget_(ctx->getRuntime()->memoryBudget()),
+    spill_dir_(ctx->getRuntime()->cacheDir()) {
   if (sort_specs_.size() == 0) {
     RAISE(kIllegalArgumentError, "can't execute ORDER BY: no sort specs");
   }
+
+  sort_keys_.resize(sort_specs_.size());
+  for (size_t i = 0; i < sort_specs_.size(); ++i) {
+    sort_keys_[i].type = SortKeyType::GENERIC;
+    sort_keys_[i].descending = sort_specs_[i].descending;
+  }
+}
+
+OrderBy::~OrderBy() {
+  for (const auto& run : runs_) {
+    FileUtil::rm(run.filename);
+  }
+}
+
+static size_t estimateMemoryUsage(const SValue* values, size_t num_values) {
+  size_t size = 0;
+  for (size_t i = 0; i < num_values; ++i) {
+    size += sizeof(SValue);
+    if (values[i].getType() == SQL_STRING) {
+      size += values[i].getStringSize();
+    }
+  }
+
+  return size;
 }
 
 // FIXPAUL this should mergesort while inserting...
@@ -34,60 +65,374 @@ bool OrderBy::onInputRow(
     const TaskID& input_id,
     const SValue* argv,
     int argc) {
-  Vector<SValue> row;
-  for (int i = 0; i < argc; i++) {
-    row.emplace_back(argv[i]);
+  for (size_t i = 0; i < sort_specs_.size(); ++i) {
+    auto& col = sort_keys_[i];
+    col.values.emplace_back();
+    VM::evaluate(
+        ctx_,
+        sort_specs_[i].expr.program(),
+        argc,
+        argv,
+        &col.values.back());
+  }
+
+  rows_.emplace_back(argv, argv + argc);
+
+  if (!spill_dir_.isEmpty()) {
+    memory_used_ += sizeof(Vector<SValue>) + estimateMemoryUsage(argv, argc);
+    for (const auto& col : sort_keys_) {
+      memory_used_ += estimateMemoryUsage(&col.values.back(), 1);
+    }
+
+    if (memory_used_ > memory_budget_) {
+      spillRun();
+    }
   }
 
-  rows_.emplace_back(row);
   return true;
 }
 
 void OrderBy::onInputsReady() {
-  auto rt = ctx_->getRuntime();
-  std::sort(
-      rows_.begin(),
-      rows_.end(),
-      [this, rt] (const Vector<SValue>& left, const Vector<SValue>& right) -> bool {
-    for (const auto& sort : sort_specs_) {
-      SValue args[2];
-      SValue res(false);
-      args[0] = rt->evaluateScalarExpression(
-          ctx_,
-          sort.expr,
-          left.size(),
-          left.data());
-      args[1] = rt->evaluateScalarExpression(
-          ctx_,
-          sort.expr,
-          right.size(),
-          right.data());
-
-      expressions::eqExpr(Transaction::get(ctx_), 2, args, &res);
-      if (res.getBool()) {
-        continue;
-      }
+  if (!runs_.empty()) {
+    if (!rows_.empty()) {
+      spillRun();
+    }
 
-      if (sort.descending) {
-        expressions::gtExpr(Transaction::get(ctx_), 2, args, &res);
-      } else {
-        expressions::ltExpr(Transaction::get(ctx_), 2, args, &res);
-      }
+    mergeRuns();
+    return;
+  }
 
-      return res.getBool();
+  auto order = sortRows();
+  for (auto idx : order) {
+    const auto& row = rows_[idx];
+    if (!output_(row.data(), row.size())) {
+      break;
     }
+  }
 
-    /* all dimensions equal */
-    return false;
+  clearRows();
+}
+
+Vector<size_t> OrderBy::sortRows() {
+  prepareSortKeys();
+
+  Vector<size_t> order(rows_.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  std::sort(
+      order.begin(),
+      order.end(),
+      [this] (size_t left, size_t right) -> bool {
+    return compareRows(left, right);
   });
 
-  for (auto& row : rows_) {
-    if (!output_(row.data(), row.size())) {
+  return order;
+}
+
+void OrderBy::clearRows() {
+  rows_.clear();
+  for (auto& col : sort_keys_) {
+    col.type = SortKeyType::GENERIC;
+    col.values.clear();
+    col.integers.clear();
+    col.floats.clear();
+  }
+
+  memory_used_ = 0;
+}
+
+static const size_t kSpillWriteBufferSize = 1024 * 1024;
+
+void OrderBy::spillRun() {
+  auto order = sortRows();
+
+  SpillRun run;
+  run.filename = FileUtil::joinPaths(
+      spill_dir_.get(),
+      StringUtil::format("orderby_$0.tmp", Random::singleton()->hex128()));
+  run.num_rows = order.size();
+
+  auto file = FileOutputStream::openFile(run.filename);
+  runs_.emplace_back(run);
+
+  String buf;
+  auto os = StringOutputStream::fromString(&buf);
+  for (auto idx : order) {
+    const auto& row = rows_[idx];
+    os->appendVarUInt(row.size());
+    for (const auto& v : row) {
+      v.encode(os.get());
+    }
+
+    if (buf.size() > kSpillWriteBufferSize) {
+      file->write(buf.data(), buf.size());
+      buf.clear();
+    }
+  }
+
+  if (buf.size() > 0) {
+    file->write(buf.data(), buf.size());
+  }
+
+  clearRows();
+}
+
+void OrderBy::mergeRuns() {
+  Vector<SpillRunReader> readers(runs_.size());
+  Vector<size_t> heap;
+  for (size_t i = 0; i < runs_.size(); ++i) {
+    readers[i].is = FileInputStream::openFile(runs_[i].filename);
+    readers[i].remaining = runs_[i].num_rows;
+    readers[i].sort_keys.resize(sort_specs_.size());
+    if (readNextRow(&readers[i])) {
+      heap.emplace_back(i);
+    }
+  }
+
+  /* min-heap of readers by their current row; earlier runs win ties */
+  auto cmp = [this, &readers] (size_t left, size_t right) -> bool {
+    if (compareSortKeys(
+            ctx_,
+            sort_specs_,
+            readers[right].sort_keys.data(),
+            readers[left].sort_keys.data())) {
+      return true;
+    }
+
+    if (compareSortKeys(
+            ctx_,
+            sort_specs_,
+            readers[left].sort_keys.data(),
+            readers[right].sort_keys.data())) {
+      return false;
+    }
+
+    return left > right;
+  };
+
+  std::make_heap(heap.begin(), heap.end(), cmp);
+  while (!heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    auto& reader = readers[heap.back()];
+
+    if (!output_(reader.row.data(), reader.row.size())) {
       break;
     }
+
+    if (readNextRow(&reader)) {
+      std::push_heap(heap.begin(), heap.end(), cmp);
+    } else {
+      heap.pop_back();
+    }
   }
 
-  rows_.clear();
+  readers.clear();
+  for (const auto& run : runs_) {
+    FileUtil::rm(run.filename);
+  }
+
+  runs_.clear();
+}
+
+bool OrderBy::readNextRow(SpillRunReader* reader) {
+  if (reader->remaining == 0) {
+    return false;
+  }
+
+  reader->row.resize(reader->is->readVarUInt());
+  for (auto& v : reader->row) {
+    v.decode(reader->is.get());
+  }
+
+  for (size_t i = 0; i < sort_specs_.size(); ++i) {
+    VM::evaluate(
+        ctx_,
+        sort_specs_[i].expr.program(),
+        reader->row.size(),
+        reader->row.data(),
+        &reader->sort_keys[i]);
+  }
+
+  --reader->remaining;
+  return true;
+}
+
+void OrderBy::prepareSortKeys() {
+  for (auto& col : sort_keys_) {
+    if (col.values.empty()) {
+      continue;
+    }
+
+    bool all_integer = true;
+    bool all_timestamp = true;
+    bool all_numeric = true;
+    bool all_string = true;
+    for (const auto& v : col.values) {
+      auto type = v.getType();
+      all_integer &= type == SQL_INTEGER;
+      all_timestamp &= type == SQL_TIMESTAMP;
+      all_numeric &= type == SQL_INTEGER || type == SQL_FLOAT;
+      all_string &= type == SQL_STRING;
+    }
+
+    if (all_integer || all_timestamp) {
+      col.type = SortKeyType::INTEGER;
+      col.integers.reserve(col.values.size());
+      for (const auto& v : col.values) {
+        col.integers.emplace_back(v.getInteger());
+      }
+    } else if (all_numeric) {
+      col.type = SortKeyType::FLOAT;
+      col.floats.reserve(col.values.size());
+      for (const auto& v : col.values) {
+        col.floats.emplace_back(v.getFloat());
+      }
+    } else if (all_string) {
+      col.type = SortKeyType::STRING;
+      continue;
+    } else {
+      col.type = SortKeyType::GENERIC;
+      continue;
+    }
+
+    col.values.clear();
+  }
+}
+
+template <typename T>
+static inline int compareTyped(const T& left, const T& right) {
+  if (left < right) {
+    return -1;
+  } else if (right < left) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
+static inline int compareStrings(const SValue& left, const SValue& right) {
+  auto left_size = left.getStringSize();
+  auto right_size = right.getStringSize();
+  auto cmp = memcmp(
+      left.getStringData(),
+      right.getStringData(),
+      std::min(left_size, right_size));
+
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  return compareTyped(left_size, right_size);
+}
+
+/**
+ * Compares two values using the eq/lt/gt expressions. Returns zero if both
+ * values are equal, a negative value if left sorts before right and a
+ * positive value otherwise
+ */
+static int compareGeneric(
+    Transaction* ctx,
+    const SValue& left,
+    const SValue& right,
+    bool descending) {
+  SValue args[2] = { left, right };
+  SValue res(false);
+
+  expressions::eqExpr(Transaction::get(ctx), 2, args, &res);
+  if (res.getBool()) {
+    return 0;
+  }
+
+  if (descending) {
+    expressions::gtExpr(Transaction::get(ctx), 2, args, &res);
+  } else {
+    expressions::ltExpr(Transaction::get(ctx), 2, args, &res);
+  }
+
+  return res.getBool() ? -1 : 1;
+}
+
+bool OrderBy::compareRows(size_t left, size_t right) const {
+  for (const auto& col : sort_keys_) {
+    int cmp;
+    switch (col.type) {
+
+      case SortKeyType::INTEGER:
+        cmp = compareTyped(col.integers[left], col.integers[right]);
+        break;
+
+      case SortKeyType::FLOAT:
+        cmp = compareTyped(col.floats[left], col.floats[right]);
+        break;
+
+      case SortKeyType::STRING:
+        cmp = compareStrings(col.values[left], col.values[right]);
+        break;
+
+      case SortKeyType::GENERIC:
+        cmp = compareGeneric(
+            ctx_,
+            col.values[left],
+            col.values[right],
+            col.descending);
+
+        if (cmp == 0) {
+          continue;
+        }
+
+        return cmp < 0;
+
+    }
+
+    if (cmp == 0) {
+      continue;
+    }
+
+    return col.descending ? cmp > 0 : cmp < 0;
+  }
+
+  /* all dimensions equal */
+  return false;
+}
+
+bool OrderBy::compareSortKeys(
+    Transaction* ctx,
+    const Vector<SortExpr>& sort_specs,
+    const SValue* left,
+    const SValue* right) {
+  for (size_t i = 0; i < sort_specs.size(); ++i) {
+    auto ltype = left[i].getType();
+    auto rtype = right[i].getType();
+    bool descending = sort_specs[i].descending;
+
+    int cmp;
+    if ((ltype == SQL_INTEGER && rtype == SQL_INTEGER) ||
+        (ltype == SQL_TIMESTAMP && rtype == SQL_TIMESTAMP)) {
+      cmp = compareTyped(left[i].getInteger(), right[i].getInteger());
+    } else if (left[i].isNumeric() && right[i].isNumeric()) {
+      cmp = compareTyped(left[i].getFloat(), right[i].getFloat());
+    } else if (ltype == SQL_STRING && rtype == SQL_STRING) {
+      cmp = compareStrings(left[i], right[i]);
+    } else {
+      cmp = compareGeneric(ctx, left[i], right[i], descending);
+      if (cmp == 0) {
+        continue;
+      }
+
+      return cmp < 0;
+    }
+
+    if (cmp == 0) {
+      continue;
+    }
+
+    return descending ? cmp > 0 : cmp < 0;
+  }
+
+  /* all dimensions equal */
+  return false;
 }
 
 OrderByFactory::OrderByFactory(
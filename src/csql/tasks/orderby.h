@@ -9,6 +9,7 @@
  */
 #pragma once
 #include <stx/stdtypes.h>
+#include <stx/io/inputstream.h>
 #include <csql/Transaction.h>
 #include <csql/tasks/Task.h>
 #include <csql/runtime/ValueExpression.h>
@@ -30,6 +31,8 @@ public:
       size_t num_columns,
       RowSinkFn output);
 
+  ~OrderBy();
+
   bool onInputRow(
       const TaskID& input_id,
       const SValue* row,
@@ -37,12 +40,75 @@ public:
 
   void onInputsReady() override;
 
+  /**
+   * Compares two rows by their (precomputed) sort key values. Returns true if
+   * left sorts before right. Also used by TopN
+   */
+  static bool compareSortKeys(
+      Transaction* ctx,
+      const Vector<SortExpr>& sort_specs,
+      const SValue* left,
+      const SValue* right);
+
 protected:
+
+  enum class SortKeyType { INTEGER, FLOAT, STRING, GENERIC };
+
+  /**
+   * The sort keys are evaluated once per row when the row is inserted. Before
+   * sorting, each key column is converted into a typed array if all of its
+   * values have the same type so that the comparator doesn't have to go
+   * through the generic eq/lt/gt expressions. STRING keys stay in values and
+   * are compared in place.
+   */
+  struct SortKeyColumn {
+    SortKeyType type;
+    bool descending;
+    Vector<SValue> values;
+    Vector<SValue::IntegerType> integers;
+    Vector<SValue::FloatType> floats;
+  };
+
+  /**
+   * A sorted run of rows that was written to disk because the in-memory rows
+   * exceeded the memory budget
+   */
+  struct SpillRun {
+    String filename;
+    size_t num_rows;
+  };
+
+  struct SpillRunReader {
+    ScopedPtr<InputStream> is;
+    size_t remaining;
+    Vector<SValue> row;
+    Vector<SValue> sort_keys;
+  };
+
+  void prepareSortKeys();
+  Vector<size_t> sortRows();
+  void clearRows();
+
+  void spillRun();
+  void mergeRuns();
+  bool readNextRow(SpillRunReader* reader);
+
+  /**
+   * Returns true if the row with index left sorts before the row with index
+   * right
+   */
+  bool compareRows(size_t left, size_t right) const;
+
   Transaction* ctx_;
   Vector<SortExpr> sort_specs_;
   size_t num_columns_;
   Vector<Vector<SValue>> rows_;
+  Vector<SortKeyColumn> sort_keys_;
   RowSinkFn output_;
+  size_t memory_used_;
+  size_t memory_budget_;
+  Option<String> spill_dir_;
+  Vector<SpillRun> runs_;
 };
 
 class OrderByFactory : public TaskFactory {
@@ -16,16 +16,29 @@ Subquery::Subquery(
     Transaction* txn,
     Vector<ValueExpression> select_expressions,
     Option<ValueExpression> where_expr,
+    SharedExpressions shared_expressions,
+    size_t num_shared_where_expressions,
     RowSinkFn output) :
     txn_(txn),
     select_exprs_(std::move(select_expressions)),
     where_expr_(std::move(where_expr)),
+    shared_exprs_(std::move(shared_expressions)),
+    num_shared_where_exprs_(num_shared_where_expressions),
     output_(output) {}
 
 bool Subquery::onInputRow(
     const TaskID& input_id,
     const SValue* row,
     int row_len) {
+  /* the shared expressions that only the select list needs are evaluated
+     after the where expression matched */
+  if (shared_exprs_.size() > 0) {
+    shared_exprs_.setInput(row, row_len);
+    shared_exprs_.evaluate(txn_, num_shared_where_exprs_);
+    row = shared_exprs_.row();
+    row_len = shared_exprs_.rowSize();
+  }
+
   if (!where_expr_.isEmpty()) {
     SValue pred;
     VM::evaluate(txn_, where_expr_.get().program(), row_len, row, &pred);
@@ -34,6 +47,10 @@ bool Subquery::onInputRow(
     }
   }
 
+  if (shared_exprs_.size() > 0) {
+    shared_exprs_.evaluate(txn_, shared_exprs_.size());
+  }
+
   Vector<SValue> out_row(select_exprs_.size(), SValue{});
   for (int i = 0; i < select_exprs_.size(); ++i) {
     VM::evaluate(txn_, select_exprs_[i].program(), row_len, row, &out_row[i]);
@@ -51,25 +68,47 @@ SubqueryFactory::SubqueryFactory(
 RefPtr<Task> SubqueryFactory::build(
     Transaction* txn,
     RowSinkFn output) const {
+  /* the where expression goes first so that the shared expressions it
+     requires get the lowest slots */
+  Vector<RefPtr<ValueExpressionNode>> exprs;
+  if (!where_expr_.isEmpty()) {
+    exprs.emplace_back(where_expr_.get());
+  }
+
+  for (const auto& slnode : select_exprs_) {
+    exprs.emplace_back(slnode->expression());
+  }
+
+  Vector<size_t> num_required;
+  auto shared_expressions = SharedExpressions::build(
+      txn,
+      &exprs,
+      &num_required);
+
   Vector<ValueExpression> select_expressions;
   Option<ValueExpression> where_expr;
+  size_t num_shared_where_expressions = 0;
 
   auto qbuilder = txn->getRuntime()->queryBuilder();
+  auto expr_iter = exprs.begin();
 
   if (!where_expr_.isEmpty()) {
     where_expr = std::move(Option<ValueExpression>(
-        qbuilder->buildValueExpression(txn, where_expr_.get())));
+        qbuilder->buildValueExpression(txn, *expr_iter++)));
+    num_shared_where_expressions = num_required[0];
   }
 
-  for (const auto& slnode : select_exprs_) {
+  for (; expr_iter != exprs.end(); ++expr_iter) {
     select_expressions.emplace_back(
-        qbuilder->buildValueExpression(txn, slnode->expression()));
+        qbuilder->buildValueExpression(txn, *expr_iter));
   }
 
   return new Subquery(
       txn,
       std::move(select_expressions),
       std::move(where_expr),
+      std::move(shared_expressions),
+      num_shared_where_expressions,
       output);
 }
 
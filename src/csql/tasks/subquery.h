@@ -11,6 +11,7 @@
 #include <stx/stdtypes.h>
 #include <csql/tasks/Task.h>
 #include <csql/runtime/defaultruntime.h>
+#include <csql/runtime/SharedExpressions.h>
 
 namespace csql {
 
@@ -21,6 +22,8 @@ public:
       Transaction* txn,
       Vector<ValueExpression> select_expressions,
       Option<ValueExpression> where_expr,
+      SharedExpressions shared_expressions,
+      size_t num_shared_where_expressions,
       RowSinkFn output);
 
   bool onInputRow(
@@ -32,6 +35,8 @@ protected:
   Transaction* txn_;
   Vector<ValueExpression> select_exprs_;
   Option<ValueExpression> where_expr_;
+  SharedExpressions shared_exprs_;
+  size_t num_shared_where_exprs_;
   RowSinkFn output_;
 };
 
@@ -12,6 +12,7 @@
 #include <csql/runtime/QueryBuilder.h>
 #include <csql/runtime/runtime.h>
 #include <csql/tasks/tablescan.h>
+#include <csql/tasks/limit.h>
 
 namespace csql {
 
@@ -22,65 +23,187 @@ TableScan::TableScan(
     RowSinkFn output) :
     txn_(txn),
     iter_(std::move(iter)),
+    num_shared_where_exprs_(0),
     output_(output) {
   auto qbuilder = txn->getRuntime()->queryBuilder();
 
-  for (const auto& slnode : stmt->selectList()) {
+  Vector<RefPtr<ValueExpressionNode>> exprs;
+  if (!stmt->whereExpression().isEmpty()) {
     QueryTreeUtil::resolveColumns(
-        slnode->expression(),
+        stmt->whereExpression().get(),
         std::bind(
             &TableIterator::findColumn,
             iter_.get(),
             std::placeholders::_1));
 
-    select_exprs_.emplace_back(
-        qbuilder->buildValueExpression(txn, slnode->expression()));
+    exprs.emplace_back(stmt->whereExpression().get());
   }
 
-  if (!stmt->whereExpression().isEmpty()) {
+  for (const auto& slnode : stmt->selectList()) {
     QueryTreeUtil::resolveColumns(
-        stmt->whereExpression().get(),
+        slnode->expression(),
         std::bind(
             &TableIterator::findColumn,
             iter_.get(),
             std::placeholders::_1));
 
+    exprs.emplace_back(slnode->expression());
+  }
+
+  Vector<size_t> num_required;
+  shared_exprs_ = SharedExpressions::build(txn, &exprs, &num_required);
+
+  auto expr_iter = exprs.begin();
+  if (!stmt->whereExpression().isEmpty()) {
     where_expr_ = std::move(Option<ValueExpression>(
-        qbuilder->buildValueExpression(txn, stmt->whereExpression().get())));
+        qbuilder->buildValueExpression(txn, *expr_iter++)));
+    num_shared_where_exprs_ = num_required[0];
+  }
+
+  for (; expr_iter != exprs.end(); ++expr_iter) {
+    select_exprs_.emplace_back(
+        qbuilder->buildValueExpression(txn, *expr_iter));
+  }
+
+  if (!stmt->limit().isEmpty()) {
+    output_ = Limit::limitOutput(stmt->limit().get(), output_);
   }
 }
 
 void TableScan::onInputsReady() {
-  Vector<SValue> inbuf(iter_->numColumns());
+  auto batch_size = VM::kDefaultBatchSize;
+  size_t num_columns = iter_->numColumns();
+  size_t num_shared = shared_exprs_.size();
+
+  /* rows are collected column-wise into batches so that the WHERE and select
+     expressions can be evaluated for a whole batch with VM::evaluateBatch.
+     the shared expressions get one column each after the input columns */
+  size_t shared_begin = num_shared > 0 ? shared_exprs_.inputWidth() : 0;
+  size_t width = num_shared > 0 ? shared_begin + num_shared : num_columns;
+
+  Vector<Vector<SValue>> input(num_columns, Vector<SValue>(batch_size));
+  Vector<Vector<SValue>> shared(num_shared, Vector<SValue>(batch_size));
+  Vector<const SValue*> columns(width, nullptr);
+  for (size_t i = 0; i < width; ++i) {
+    if (i < shared_begin || num_shared == 0) {
+      columns[i] = input[i].data();
+    } else {
+      columns[i] = shared[i - shared_begin].data();
+    }
+  }
+
+  Vector<SValue> inbuf(num_columns);
+  Vector<SValue> pred(batch_size);
+  Vector<Vector<SValue>> outcols(
+      select_exprs_.size(),
+      Vector<SValue>(batch_size));
   Vector<SValue> outbuf(select_exprs_.size());
-  while (iter_->nextRow(inbuf.data())) {
-    if (!where_expr_.isEmpty()) {
-      SValue pred;
-      VM::evaluate(
+
+  for (bool eof = false; !eof; ) {
+    size_t nrows = 0;
+    while (nrows < batch_size) {
+      if (!iter_->nextRow(inbuf.data())) {
+        eof = true;
+        break;
+      }
+
+      for (size_t i = 0; i < num_columns; ++i) {
+        input[i][nrows] = std::move(inbuf[i]);
+      }
+
+      ++nrows;
+    }
+
+    size_t num_evaluated = 0;
+    if (nrows > 0 && !where_expr_.isEmpty()) {
+      evaluateSharedBatch(
+          0,
+          num_shared_where_exprs_,
+          nrows,
+          columns.data(),
+          &shared);
+      num_evaluated = num_shared_where_exprs_;
+
+      VM::evaluateBatch(
           txn_,
           where_expr_.get().program(),
-          inbuf.size(),
-          inbuf.data(),
-          &pred);
+          nrows,
+          width,
+          columns.data(),
+          pred.data());
+
+      /* move the matching rows to the front of the batch */
+      size_t nmatches = 0;
+      for (size_t n = 0; n < nrows; ++n) {
+        if (!pred[n].getBool()) {
+          continue;
+        }
+
+        if (nmatches != n) {
+          for (auto& col : input) {
+            col[nmatches] = std::move(col[n]);
+          }
 
-      if (!pred.getBool()) {
-        continue;
+          for (size_t i = 0; i < num_evaluated; ++i) {
+            shared[i][nmatches] = std::move(shared[i][n]);
+          }
+        }
+
+        ++nmatches;
       }
+
+      nrows = nmatches;
+    }
+
+    if (nrows == 0) {
+      continue;
     }
 
-    for (int i = 0; i < select_exprs_.size(); ++i) {
-      VM::evaluate(
+    evaluateSharedBatch(
+        num_evaluated,
+        num_shared,
+        nrows,
+        columns.data(),
+        &shared);
+
+    for (size_t i = 0; i < select_exprs_.size(); ++i) {
+      VM::evaluateBatch(
           txn_,
           select_exprs_[i].program(),
-          inbuf.size(),
-          inbuf.data(),
-          &outbuf[i]);
+          nrows,
+          width,
+          columns.data(),
+          outcols[i].data());
     }
 
-    if (!output_(outbuf.data(), outbuf.size())) {
-      return;
+    for (size_t n = 0; n < nrows; ++n) {
+      for (size_t i = 0; i < select_exprs_.size(); ++i) {
+        outbuf[i] = std::move(outcols[i][n]);
+      }
+
+      if (!output_(outbuf.data(), outbuf.size())) {
+        return;
+      }
     }
   }
 }
 
+void TableScan::evaluateSharedBatch(
+    size_t begin,
+    size_t end,
+    size_t nrows,
+    const SValue** columns,
+    Vector<Vector<SValue>>* shared) {
+  auto shared_begin = shared_exprs_.inputWidth();
+  for (size_t i = begin; i < end; ++i) {
+    VM::evaluateBatch(
+        txn_,
+        shared_exprs_.getExpression(i).program(),
+        nrows,
+        shared_begin + i,
+        columns,
+        (*shared)[i].data());
+  }
+}
+
 }
@@ -18,6 +18,7 @@
 #include <csql/runtime/tablerepository.h>
 #include <csql/runtime/compiler.h>
 #include <csql/runtime/vm.h>
+#include <csql/runtime/SharedExpressions.h>
 #include <stx/exception.h>
 
 namespace csql {
@@ -42,10 +43,23 @@ public:
 
 protected:
 
+  /**
+   * Evaluates the shared expressions [begin, end) for a batch of nrows rows
+   * into the provided shared expression columns
+   */
+  void evaluateSharedBatch(
+      size_t begin,
+      size_t end,
+      size_t nrows,
+      const SValue** columns,
+      Vector<Vector<SValue>>* shared);
+
   Transaction* txn_;
   ScopedPtr<TableIterator> iter_;
   Vector<ValueExpression> select_exprs_;
   Option<ValueExpression> where_expr_;
+  SharedExpressions shared_exprs_;
+  size_t num_shared_where_exprs_;
   RowSinkFn output_;
 };
 
@@ -0,0 +1,121 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <csql/tasks/topn.h>
+#include <csql/runtime/runtime.h>
+
+namespace csql {
+
+TopN::TopN(
+    Transaction* ctx,
+    Vector<OrderBy::SortExpr> sort_specs,
+    size_t limit,
+    size_t offset,
+    RowSinkFn output) :
+    ctx_(ctx),
+    sort_specs_(std::move(sort_specs)),
+    limit_(limit),
+    offset_(offset),
+    max_rows_(limit + offset),
+    output_(output) {
+  if (sort_specs_.size() == 0) {
+    RAISE(kIllegalArgumentError, "can't execute ORDER BY: no sort specs");
+  }
+
+  tmp_.sort_keys.resize(sort_specs_.size());
+}
+
+bool TopN::onInputRow(
+    const TaskID& input_id,
+    const SValue* argv,
+    int argc) {
+  if (max_rows_ == 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < sort_specs_.size(); ++i) {
+    VM::evaluate(
+        ctx_,
+        sort_specs_[i].expr.program(),
+        argc,
+        argv,
+        &tmp_.sort_keys[i]);
+  }
+
+  auto cmp = [this] (const HeapEntry& left, const HeapEntry& right) {
+    return compare(left, right);
+  };
+
+  /* the heap's top is the row that sorts last among the retained rows */
+  if (heap_.size() >= max_rows_) {
+    if (!compare(tmp_, heap_.front())) {
+      return true;
+    }
+
+    std::pop_heap(heap_.begin(), heap_.end(), cmp);
+    heap_.pop_back();
+  }
+
+  tmp_.row.assign(argv, argv + argc);
+  heap_.emplace_back(tmp_);
+  std::push_heap(heap_.begin(), heap_.end(), cmp);
+  return true;
+}
+
+void TopN::onInputsReady() {
+  std::sort_heap(
+      heap_.begin(),
+      heap_.end(),
+      [this] (const HeapEntry& left, const HeapEntry& right) {
+    return compare(left, right);
+  });
+
+  for (size_t i = offset_; i < heap_.size(); ++i) {
+    if (!output_(heap_[i].row.data(), heap_[i].row.size())) {
+      break;
+    }
+  }
+
+  heap_.clear();
+}
+
+bool TopN::compare(const HeapEntry& left, const HeapEntry& right) const {
+  return OrderBy::compareSortKeys(
+      ctx_,
+      sort_specs_,
+      left.sort_keys.data(),
+      right.sort_keys.data());
+}
+
+TopNFactory::TopNFactory(
+    Vector<OrderByFactory::SortExpr> sort_specs,
+    size_t limit,
+    size_t offset) :
+    sort_specs_(sort_specs),
+    limit_(limit),
+    offset_(offset) {}
+
+RefPtr<Task> TopNFactory::build(
+    Transaction* txn,
+    RowSinkFn output) const {
+  auto qbuilder = txn->getRuntime()->queryBuilder();
+
+  Vector<OrderBy::SortExpr> sort_exprs;
+  for (const auto& ss : sort_specs_) {
+    OrderBy::SortExpr se;
+    se.descending = ss.descending;
+    se.expr = qbuilder->buildValueExpression(txn, ss.expr);
+    sort_exprs.emplace_back(std::move(se));
+  }
+
+  return new TopN(txn, std::move(sort_exprs), limit_, offset_, output);
+}
+
+} // namespace csql
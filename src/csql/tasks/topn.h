@@ -0,0 +1,79 @@
+/**
+ * This file is part of the "libcsql" project
+ *   Copyright (c) 2015 Paul Asmuth
+ *
+ * FnordMetric is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License v3.0. You should have received a
+ * copy of the GNU General Public License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <stx/stdtypes.h>
+#include <csql/Transaction.h>
+#include <csql/tasks/Task.h>
+#include <csql/tasks/orderby.h>
+
+namespace csql {
+
+/**
+ * ORDER BY ... LIMIT: keeps only the first offset + limit rows (in sort order)
+ * in a bounded heap instead of sorting the full input
+ */
+class TopN : public Task {
+public:
+
+  TopN(
+      Transaction* ctx,
+      Vector<OrderBy::SortExpr> sort_specs,
+      size_t limit,
+      size_t offset,
+      RowSinkFn output);
+
+  bool onInputRow(
+      const TaskID& input_id,
+      const SValue* row,
+      int row_len) override;
+
+  void onInputsReady() override;
+
+protected:
+
+  struct HeapEntry {
+    Vector<SValue> sort_keys;
+    Vector<SValue> row;
+  };
+
+  /**
+   * Returns true if left sorts before right
+   */
+  bool compare(const HeapEntry& left, const HeapEntry& right) const;
+
+  Transaction* ctx_;
+  Vector<OrderBy::SortExpr> sort_specs_;
+  size_t limit_;
+  size_t offset_;
+  size_t max_rows_;
+  Vector<HeapEntry> heap_;
+  HeapEntry tmp_;
+  RowSinkFn output_;
+};
+
+class TopNFactory : public TaskFactory {
+public:
+
+  TopNFactory(
+      Vector<OrderByFactory::SortExpr> sort_specs,
+      size_t limit,
+      size_t offset);
+
+  RefPtr<Task> build(
+      Transaction* txn,
+      RowSinkFn output) const override;
+
+protected:
+  Vector<OrderByFactory::SortExpr> sort_specs_;
+  size_t limit_;
+  size_t offset_;
+};
+
+}